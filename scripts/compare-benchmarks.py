@@ -0,0 +1,105 @@
+#!/usr/bin/env python3
+"""Compares two sets of Google Benchmark JSON reports and flags regressions.
+
+Each argument is a JSON report or a directory of them, such as the benchmarks/ directory the `benchmarks`
+target writes into the build directory:
+
+    cmake --build build --target benchmarks
+    cp -r build/benchmarks baseline
+    # ... change the code, rebuild ...
+    cmake --build build --target benchmarks
+    scripts/compare-benchmarks.py baseline build/benchmarks
+
+Benchmarks are matched by report file name and benchmark name. The exit status is 1 when any benchmark got
+slower than the threshold allows, so the script can gate a commit.
+"""
+
+import argparse
+import json
+import pathlib
+import sys
+
+TIME_UNITS = {"ns": 1.0, "us": 1e3, "ms": 1e6, "s": 1e9}
+
+
+def load(path):
+    path = pathlib.Path(path)
+    files = sorted(path.glob("*.json")) if path.is_dir() else [path]
+
+    results = {}
+    for file in files:
+        text = file.read_text()
+        # an executable whose benchmarks were all filtered out leaves an empty report
+        if not text.strip():
+            continue
+
+        benchmarks = json.loads(text).get("benchmarks", [])
+
+        for benchmark in benchmarks:
+            if benchmark.get("error_occurred"):
+                continue
+            # repeated runs are compared through their median only
+            if benchmark.get("run_type") == "aggregate" and benchmark.get("aggregate_name") != "median":
+                continue
+
+            key = f"{file.stem}/{benchmark['name']}"
+            results[key] = benchmark
+
+    return results
+
+
+def nanoseconds(benchmark, metric):
+    return benchmark[metric] * TIME_UNITS[benchmark.get("time_unit", "ns")]
+
+
+def format_time(value):
+    for unit in ("s", "ms", "us"):
+        if value >= TIME_UNITS[unit]:
+            return f"{value / TIME_UNITS[unit]:.3g} {unit}"
+    return f"{value:.3g} ns"
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("baseline", help="JSON report or directory of reports to compare against")
+    parser.add_argument("contender", help="JSON report or directory of reports to check")
+    parser.add_argument("--metric", choices=("cpu_time", "real_time"), default="cpu_time")
+    parser.add_argument("--threshold", type=float, default=0.10,
+                        help="relative slowdown reported as a regression (default: 0.10)")
+    arguments = parser.parse_args()
+
+    baseline = load(arguments.baseline)
+    contender = load(arguments.contender)
+
+    regressions = 0
+    width = max((len(name) for name in baseline.keys() | contender.keys()), default=9)
+    print(f"{'benchmark':<{width}}  {'baseline':>10}  {'contender':>10}  {'change':>8}")
+
+    for name in sorted(baseline.keys() | contender.keys()):
+        if name not in baseline or name not in contender:
+            where = "baseline" if name in baseline else "contender"
+            print(f"{name:<{width}}  only in {where}")
+            continue
+
+        before = nanoseconds(baseline[name], arguments.metric)
+        after = nanoseconds(contender[name], arguments.metric)
+        change = (after - before) / before if before > 0 else 0.0
+
+        marker = ""
+        if change > arguments.threshold:
+            marker = "  REGRESSION"
+            regressions += 1
+        elif change < -arguments.threshold:
+            marker = "  improved"
+
+        print(f"{name:<{width}}  {format_time(before):>10}  {format_time(after):>10}  {change:>+8.1%}{marker}")
+
+    if regressions:
+        print(f"\n{regressions} benchmark(s) slower by more than {arguments.threshold:.0%}", file=sys.stderr)
+        return 1
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
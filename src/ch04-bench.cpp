@@ -0,0 +1,74 @@
+#include <benchmark/benchmark.h>
+
+#include "ch04-scoped-timer.h"
+#include "ch04-trace.h"
+#include "ch05.h"
+
+namespace {
+    void BM_EmptyScope(benchmark::State &state) {
+        for (auto _: state) {
+            benchmark::ClobberMemory();
+        }
+    }
+
+    template<typename Clock>
+    void BM_ScopedTimer(benchmark::State &state) {
+        for (auto _: state) {
+            ch04::ScopedTimer<"bench.empty", Clock> timer{};
+            benchmark::ClobberMemory();
+        }
+    }
+
+    // One begin and one end event per iteration, with the tracer writing to /dev/null in the background. Runs
+    // limited to fewer events than a thread buffer holds measure recording alone; longer runs also show how
+    // many events a sustained stream drops while the flush thread competes for the core.
+    void BM_ScopedTrace(benchmark::State &state) {
+        auto &tracer = ch04::Tracer::instance();
+        tracer.start("/dev/null", std::chrono::milliseconds{1});
+        tracer.setEnabled(state.range(0) != 0);
+        const auto dropped = tracer.getDropped();
+
+        for (auto _: state) {
+            ch04::ScopedTrace<"bench.trace"> trace{};
+            benchmark::ClobberMemory();
+        }
+
+        state.counters["dropped"] = static_cast<double>(tracer.getDropped() - dropped);
+        tracer.stop();
+
+        state.counters["per_event"] = benchmark::Counter{static_cast<double>(state.iterations() * 2),
+                                                         benchmark::Counter::kIsRate | benchmark::Counter::kInvert};
+    }
+
+    // times every transfer and reports the distribution the timer collected
+    void BM_TimedBankTransfer(benchmark::State &state) {
+        ch05::InMemoryAccountDatabase accountDatabase;
+        ch05::Bank bank{accountDatabase};
+        for (long account{}; account < 1024; account++) {
+            accountDatabase.setAmount(account, 1'000'000);
+        }
+
+        // the summary below covers this run only, not the ones before it with other iteration counts
+        ch04::TimerRegistry::instance().reset("bench.transfer");
+
+        long account{};
+        for (auto _: state) {
+            ch04::ScopedTimer<"bench.transfer", ch04::TscClock> timer{};
+            bank.transfer(account, (account + 1) & 1023, 1);
+            account = (account + 1) & 1023;
+        }
+
+        const auto summary = ch04::TimerRegistry::instance().summary("bench.transfer");
+        state.counters["p50_ns"] = static_cast<double>(summary.p50);
+        state.counters["p90_ns"] = static_cast<double>(summary.p90);
+        state.counters["p99_ns"] = static_cast<double>(summary.p99);
+        state.counters["max_ns"] = static_cast<double>(summary.max);
+    }
+}
+
+BENCHMARK(BM_EmptyScope);
+BENCHMARK_TEMPLATE(BM_ScopedTimer, ch04::SteadyClock);
+BENCHMARK_TEMPLATE(BM_ScopedTimer, ch04::TscClock);
+BENCHMARK(BM_TimedBankTransfer);
+BENCHMARK(BM_ScopedTrace)->ArgName("enabled")->Arg(0)->Arg(1);
+BENCHMARK(BM_ScopedTrace)->ArgName("enabled")->Arg(1)->Iterations(30'000)->Repetitions(10)->ReportAggregatesOnly();
@@ -0,0 +1,175 @@
+#include <climits>
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "ch04-scoped-timer.h"
+
+namespace {
+    // a clock the test moves by hand; zero is left out, since a timer starting at zero counts as moved-from
+    struct ManualClock {
+        static inline long long ticks{1000};
+
+        static long long now() {
+            return ticks;
+        }
+
+        static long long toNanoseconds(const long long elapsed) {
+            return elapsed;
+        }
+    };
+
+    ch04::TimerHistogram &histogram(const char *name) {
+        auto &registry = ch04::TimerRegistry::instance();
+        return registry.histogram(registry.add(name));
+    }
+
+    // reported values are the top of their bucket, so at or above the exact one, by at most 1/64 of it
+    void expectNear(const long long exact, const long long reported, const char *what) {
+        EXPECT_GE(reported, exact) << what;
+        EXPECT_LE(reported, exact + exact / 64) << what;
+    }
+}
+
+TEST(Ch04ScopedTimer, BucketsHoldValuesWithinOneSixtyFourth) {
+    using Histogram = ch04::TimerHistogram;
+
+    for (unsigned long long value{}; value < Histogram::SUB_BUCKETS; value++) {
+        EXPECT_EQ(value, Histogram::bucketValue(Histogram::bucketIndex(value)));
+    }
+
+    std::vector<unsigned long long> values{ULLONG_MAX, ULLONG_MAX - 1};
+    for (unsigned shift{6}; shift < 64; shift++) {
+        values.push_back((1ull << shift) - 1);
+        values.push_back(1ull << shift);
+        values.push_back((1ull << shift) + 1);
+    }
+    std::mt19937_64 random{1};
+    for (int i{}; i < 100'000; i++) {
+        values.push_back(random() >> (random() % 64));
+    }
+
+    for (const auto value: values) {
+        const auto index = Histogram::bucketIndex(value);
+        ASSERT_LT(index, Histogram::BUCKET_COUNT) << value;
+
+        // the bucket's top is at or above the value, and the bucket below ends below it
+        const auto top = Histogram::bucketValue(index);
+        ASSERT_GE(top, value);
+        ASSERT_LE(top - value, value / 64) << value;
+        if (index > 0) {
+            ASSERT_LT(Histogram::bucketValue(index - 1), value) << value;
+        }
+    }
+}
+
+TEST(Ch04ScopedTimer, PercentilesOfAUniformDistribution) {
+    auto &uniform = histogram("test.uniform");
+    for (long long value{1}; value <= 100'000; value++) {
+        uniform.record(value);
+    }
+
+    const auto summary = ch04::TimerRegistry::instance().summary("test.uniform");
+    EXPECT_EQ(100'000u, summary.count);
+    expectNear(50'000, summary.p50, "p50");
+    expectNear(90'000, summary.p90, "p90");
+    expectNear(99'000, summary.p99, "p99");
+    EXPECT_EQ(100'000, summary.max);
+}
+
+TEST(Ch04ScopedTimer, PercentilesOfASkewedDistribution) {
+    // 98.9% fast, the rest slow: p99 lands on the first slow value
+    auto &skewed = histogram("test.skewed");
+    for (int i{}; i < 989; i++) {
+        skewed.record(100 + i % 3);
+    }
+    for (int i{}; i < 11; i++) {
+        skewed.record(1'000'000'000 + i);
+    }
+    skewed.record(-5);
+
+    const auto summary = ch04::TimerRegistry::instance().summary("test.skewed");
+    EXPECT_EQ(1001u, summary.count);
+    EXPECT_EQ(101, summary.p50);
+    EXPECT_EQ(102, summary.p90);
+    expectNear(1'000'000'000, summary.p99, "p99");
+    EXPECT_EQ(1'000'000'010, summary.max);
+}
+
+TEST(Ch04ScopedTimer, UnknownTimersSummarizeToZero) {
+    const auto summary = ch04::TimerRegistry::instance().summary("test.never");
+    EXPECT_EQ(0u, summary.count);
+    EXPECT_EQ(0, summary.max);
+}
+
+TEST(Ch04ScopedTimer, CountsOfExitedThreadsSurvive) {
+    const auto record = [](const long long from, const long long to) {
+        auto &histogram = ::histogram("test.threads");
+        for (auto value = from; value <= to; value++) {
+            histogram.record(value);
+        }
+    };
+
+    std::thread{record, 1, 1000}.join();
+    auto summary = ch04::TimerRegistry::instance().summary("test.threads");
+    EXPECT_EQ(1000u, summary.count);
+    EXPECT_EQ(1000, summary.max);
+
+    // the next threads take over the exited one's zeroed histograms, without counting its values twice
+    std::vector<std::thread> threads{};
+    for (long long thread{}; thread < 4; thread++) {
+        threads.emplace_back(record, 1001 + thread * 1000, 2000 + thread * 1000);
+    }
+    for (auto &thread: threads) {
+        thread.join();
+    }
+    record(5001, 6000);
+
+    summary = ch04::TimerRegistry::instance().summary("test.threads");
+    EXPECT_EQ(6000u, summary.count);
+    expectNear(3000, summary.p50, "p50");
+    expectNear(5940, summary.p99, "p99");
+    EXPECT_EQ(6000, summary.max);
+}
+
+TEST(Ch04ScopedTimer, ResetForgetsRunningAndExitedThreads) {
+    auto &registry = ch04::TimerRegistry::instance();
+    std::thread{[] { histogram("test.reset").record(1'000'000); }}.join();
+    histogram("test.reset").record(500);
+    histogram("test.other").record(7);
+
+    registry.reset("test.reset");
+    EXPECT_EQ(0u, registry.summary("test.reset").count);
+    EXPECT_EQ(0, registry.summary("test.reset").max);
+    EXPECT_EQ(1u, registry.summary("test.other").count);
+
+    histogram("test.reset").record(40);
+    const auto summary = registry.summary("test.reset");
+    EXPECT_EQ(1u, summary.count);
+    EXPECT_EQ(40, summary.p99);
+    EXPECT_EQ(40, summary.max);
+}
+
+TEST(Ch04ScopedTimer, TimesItsScope) {
+    {
+        ch04::ScopedTimer<"test.scope", ManualClock> timer{};
+        ManualClock::ticks += 250;
+    }
+    {
+        ch04::ScopedTimer<"test.scope", ManualClock> timer{};
+        ManualClock::ticks += 10;
+
+        // a copy records again from the same start, a moved-from timer records nothing
+        auto copy = timer;
+        auto moved = std::move(timer);
+        ManualClock::ticks += 10;
+    }
+
+    const auto summary = ch04::TimerRegistry::instance().summary("test.scope");
+    EXPECT_EQ(3u, summary.count);
+    EXPECT_EQ(20, summary.p50);
+    EXPECT_EQ(250, summary.max);
+}
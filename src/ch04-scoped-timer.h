@@ -0,0 +1,428 @@
+#ifndef CPPCRASHCOURSE_CH04_SCOPED_TIMER_H
+#define CPPCRASHCOURSE_CH04_SCOPED_TIMER_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <x86intrin.h>
+
+#endif
+
+// Define CH04_DISABLE_TIMERS to compile every ScopedTimer down to an empty object.
+
+namespace ch04 {
+    template<size_t N>
+    struct TimerName {
+        char value[N]{};
+
+        constexpr TimerName(const char (&name)[N]) {
+            std::copy_n(name, N, value);
+        }
+    };
+
+    struct SteadyClock {
+        static long long now() {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        static long long toNanoseconds(const long long ticks) {
+            return ticks;
+        }
+    };
+
+#if defined(__x86_64__) || defined(__i386__)
+
+    // Reads the time stamp counter, which is cheaper than steady_clock; ticks are converted with a rate measured
+    // against steady_clock the first time it is needed (which takes about 10 ms).
+    struct TscClock {
+        static long long now() {
+            return static_cast<long long>(__rdtsc());
+        }
+
+        static long long toNanoseconds(const long long ticks) {
+            static const auto nanosecondsPerTick = calibrate();
+            return static_cast<long long>(static_cast<double>(ticks) * nanosecondsPerTick);
+        }
+
+    private:
+        static double calibrate() {
+            const auto startTicks = __rdtsc();
+            const auto start = std::chrono::steady_clock::now();
+            std::this_thread::sleep_for(std::chrono::milliseconds{10});
+            const auto ticks = __rdtsc() - startTicks;
+            const auto elapsed = std::chrono::steady_clock::now() - start;
+
+            return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()) /
+                   static_cast<double>(ticks);
+        }
+    };
+
+#else
+
+    using TscClock = SteadyClock;
+
+#endif
+
+    struct TimerSummary {
+        unsigned long long count;
+        long long p50;
+        long long p90;
+        long long p99;
+        long long max;
+    };
+
+    // Log-linear (HDR) histogram of nanoseconds: exact below 64, then 64 buckets per power of two, so any
+    // recorded value is reported within 1/64 of itself. Only the owning thread records, with plain relaxed
+    // stores, so readers on other threads never block it.
+    class TimerHistogram {
+    public:
+        void record(const long long nanoseconds) {
+            const auto value = static_cast<unsigned long long>(nanoseconds < 0 ? 0 : nanoseconds);
+            auto &bucket = this->buckets[bucketIndex(value)];
+            bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+            if (value > this->max.load(std::memory_order_relaxed)) {
+                this->max.store(value, std::memory_order_relaxed);
+            }
+        }
+
+        // Adds a histogram whose thread no longer records into it.
+        void merge(const TimerHistogram &other) {
+            for (size_t i{}; i < BUCKET_COUNT; i++) {
+                this->buckets[i].store(this->buckets[i].load(std::memory_order_relaxed) +
+                                       other.buckets[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+            }
+
+            this->max.store(std::max(this->max.load(std::memory_order_relaxed),
+                                     other.max.load(std::memory_order_relaxed)), std::memory_order_relaxed);
+        }
+
+        void reset() {
+            for (auto &bucket: this->buckets) {
+                bucket.store(0, std::memory_order_relaxed);
+            }
+            this->max.store(0, std::memory_order_relaxed);
+        }
+
+        void addTo(std::vector<unsigned long long> &counts, unsigned long long &maximum) const {
+            for (size_t i{}; i < BUCKET_COUNT; i++) {
+                counts[i] += this->buckets[i].load(std::memory_order_relaxed);
+            }
+
+            maximum = std::max(maximum, this->max.load(std::memory_order_relaxed));
+        }
+
+        static constexpr size_t SUB_BUCKET_BITS{6};
+        static constexpr size_t SUB_BUCKETS{1 << SUB_BUCKET_BITS};
+        static constexpr size_t BUCKET_COUNT{(64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS};
+
+        static size_t bucketIndex(const unsigned long long value) {
+            if (value < SUB_BUCKETS) {
+                return static_cast<size_t>(value);
+            }
+
+            const auto shift = static_cast<size_t>(std::bit_width(value)) - SUB_BUCKET_BITS - 1;
+            return (shift + 1) * SUB_BUCKETS + static_cast<size_t>(value >> shift) - SUB_BUCKETS;
+        }
+
+        // the largest value that falls into the bucket
+        static unsigned long long bucketValue(const size_t index) {
+            if (index < SUB_BUCKETS) {
+                return index;
+            }
+
+            const auto shift = index / SUB_BUCKETS - 1;
+            const auto base = static_cast<unsigned long long>(index % SUB_BUCKETS + SUB_BUCKETS);
+            return ((base + 1) << shift) - 1;
+        }
+
+    private:
+        std::array<std::atomic<unsigned long long>, BUCKET_COUNT> buckets{};
+        std::atomic<unsigned long long> max{};
+    };
+
+    // Owns every thread's histograms and sums them on demand. When a thread exits, its histograms are added to
+    // the retired totals and zeroed, and the next new thread takes them over, so a program that keeps starting
+    // threads holds only as many sets of histograms as it ever ran threads at once.
+    class TimerRegistry {
+    public:
+        static constexpr size_t MAX_TIMERS{256};
+
+        static TimerRegistry &instance() {
+            static TimerRegistry registry;
+            return registry;
+        }
+
+        size_t add(const char *name) {
+            std::lock_guard lock{this->mutex};
+
+            for (size_t i{}; i < this->names.size(); i++) {
+                if (std::string_view{this->names[i]} == name) {
+                    return i;
+                }
+            }
+
+            if (this->names.size() == MAX_TIMERS) {
+                throw std::length_error{"too many timer names"};
+            }
+
+            this->names.push_back(name);
+            return this->names.size() - 1;
+        }
+
+        // The calling thread's histogram for the timer; the first call per thread and timer allocates it.
+        TimerHistogram &histogram(const size_t id) {
+            thread_local const ThreadRegistration registration{*this};
+            auto *histograms = registration.histograms;
+
+            auto *histogram = histograms->timers[id].load(std::memory_order_relaxed);
+            if (histogram == nullptr) {
+                histogram = new TimerHistogram{};
+                histograms->timers[id].store(histogram, std::memory_order_release);
+            }
+
+            return *histogram;
+        }
+
+        [[nodiscard]] TimerSummary summary(const std::string_view name) {
+            std::lock_guard lock{this->mutex};
+
+            for (size_t id{}; id < this->names.size(); id++) {
+                if (this->names[id] == name) {
+                    return this->summarize(id);
+                }
+            }
+
+            return TimerSummary{};
+        }
+
+        // Forgets everything recorded for the timer so far, e.g. between benchmark runs. Meant for moments when
+        // no thread is timing it: a value recorded concurrently may or may not survive.
+        void reset(const std::string_view name) {
+            std::lock_guard lock{this->mutex};
+
+            for (size_t id{}; id < this->names.size(); id++) {
+                if (this->names[id] != name) {
+                    continue;
+                }
+
+                this->retired.reset(id);
+                for (const auto &thread: this->threads) {
+                    thread->reset(id);
+                }
+            }
+        }
+
+        void dump(std::ostream &stream) {
+            std::lock_guard lock{this->mutex};
+
+            for (size_t id{}; id < this->names.size(); id++) {
+                const auto summary = this->summarize(id);
+                stream << this->names[id] << ": count=" << summary.count << " p50=" << summary.p50 << "ns p90="
+                       << summary.p90 << "ns p99=" << summary.p99 << "ns max=" << summary.max << "ns\n";
+            }
+
+            stream.flush();
+        }
+
+        TimerRegistry(const TimerRegistry &) = delete;
+
+        TimerRegistry &operator=(const TimerRegistry &) = delete;
+
+    private:
+        struct ThreadHistograms {
+            std::array<std::atomic<TimerHistogram *>, MAX_TIMERS> timers{};
+
+            ~ThreadHistograms() {
+                for (auto &timer: this->timers) {
+                    delete timer.load(std::memory_order_relaxed);
+                }
+            }
+
+            void reset(const size_t id) {
+                if (auto *histogram = this->timers[id].load(std::memory_order_relaxed)) {
+                    histogram->reset();
+                }
+            }
+        };
+
+        // Hands a thread its histograms on its first timer and gives them back when the thread exits.
+        struct ThreadRegistration {
+            TimerRegistry &registry;
+            ThreadHistograms *histograms;
+
+            explicit ThreadRegistration(TimerRegistry &registry)
+                    : registry{registry}, histograms{registry.addThread()} {}
+
+            ~ThreadRegistration() {
+                this->registry.retireThread(this->histograms);
+            }
+        };
+
+        std::mutex mutex;
+        std::vector<const char *> names;
+        // the histograms of running threads
+        std::vector<std::unique_ptr<ThreadHistograms>> threads;
+        // zeroed histograms of exited threads, for the next new thread
+        std::vector<std::unique_ptr<ThreadHistograms>> unused;
+        // the sum of everything exited threads recorded
+        ThreadHistograms retired;
+
+        TimerRegistry() = default;
+
+        ThreadHistograms *addThread() {
+            std::lock_guard lock{this->mutex};
+
+            if (this->unused.empty()) {
+                return this->threads.emplace_back(std::make_unique<ThreadHistograms>()).get();
+            }
+
+            this->threads.push_back(std::move(this->unused.back()));
+            this->unused.pop_back();
+            return this->threads.back().get();
+        }
+
+        void retireThread(ThreadHistograms *histograms) {
+            std::lock_guard lock{this->mutex};
+
+            for (size_t id{}; id < MAX_TIMERS; id++) {
+                auto *histogram = histograms->timers[id].load(std::memory_order_relaxed);
+                if (histogram == nullptr) {
+                    continue;
+                }
+
+                auto *total = this->retired.timers[id].load(std::memory_order_relaxed);
+                if (total == nullptr) {
+                    total = new TimerHistogram{};
+                    this->retired.timers[id].store(total, std::memory_order_relaxed);
+                }
+
+                total->merge(*histogram);
+                histogram->reset();
+            }
+
+            const auto thread = std::find_if(this->threads.begin(), this->threads.end(),
+                                             [histograms](const auto &thread) {
+                                                 return thread.get() == histograms;
+                                             });
+            this->unused.push_back(std::move(*thread));
+            this->threads.erase(thread);
+        }
+
+        TimerSummary summarize(const size_t id) const {
+            std::vector<unsigned long long> counts(TimerHistogram::BUCKET_COUNT);
+            unsigned long long maximum{};
+            if (const auto *histogram = this->retired.timers[id].load(std::memory_order_relaxed)) {
+                histogram->addTo(counts, maximum);
+            }
+            for (const auto &thread: this->threads) {
+                if (const auto *histogram = thread->timers[id].load(std::memory_order_acquire)) {
+                    histogram->addTo(counts, maximum);
+                }
+            }
+
+            TimerSummary summary{};
+            for (const auto count: counts) {
+                summary.count += count;
+            }
+            if (summary.count == 0) {
+                return summary;
+            }
+
+            const auto percentile = [&counts, &summary, maximum](const unsigned long long permille) {
+                const auto rank = (summary.count * permille + 999) / 1000;
+                unsigned long long seen{};
+                for (size_t i{}; i < counts.size(); i++) {
+                    seen += counts[i];
+                    if (seen >= rank) {
+                        return static_cast<long long>(std::min(TimerHistogram::bucketValue(i), maximum));
+                    }
+                }
+
+                return static_cast<long long>(maximum);
+            };
+
+            summary.p50 = percentile(500);
+            summary.p90 = percentile(900);
+            summary.p99 = percentile(990);
+            summary.max = static_cast<long long>(maximum);
+
+            return summary;
+        }
+    };
+
+#if !defined(CH04_DISABLE_TIMERS)
+
+    // Records how long the scope it lives in took into the histogram named Name, e.g.
+    // ch04::ScopedTimer<"transfer"> timer{};
+    // Copies and moves behave like TimerClass: a copy records again from the same start, a moved-from timer
+    // records nothing.
+    template<TimerName Name, typename Clock = SteadyClock>
+    class ScopedTimer {
+    public:
+        ScopedTimer() : start{Clock::now()} {}
+
+        ~ScopedTimer() {
+            if (this->start == 0) {
+                return;
+            }
+
+            histogram().record(Clock::toNanoseconds(Clock::now() - this->start));
+        }
+
+        ScopedTimer(const ScopedTimer &other) = default;
+
+        ScopedTimer &operator=(const ScopedTimer &other) = default;
+
+        ScopedTimer(ScopedTimer &&other) noexcept: start{other.start} {
+            other.start = 0;
+        }
+
+        ScopedTimer &operator=(ScopedTimer &&other) noexcept {
+            if (this == &other) {
+                return *this;
+            }
+
+            this->start = other.start;
+            other.start = 0;
+
+            return *this;
+        }
+
+    private:
+        long long start;
+
+        static TimerHistogram &histogram() {
+            static const auto id = TimerRegistry::instance().add(Name.value);
+            thread_local auto &histogram = TimerRegistry::instance().histogram(id);
+
+            return histogram;
+        }
+    };
+
+#else
+
+    template<TimerName Name, typename Clock = SteadyClock>
+    class ScopedTimer {
+    };
+
+    static_assert(std::is_empty_v<ScopedTimer<"">> && std::is_trivially_destructible_v<ScopedTimer<"">>);
+
+#endif
+}
+
+#endif //CPPCRASHCOURSE_CH04_SCOPED_TIMER_H
@@ -0,0 +1,22 @@
+#ifndef CPPCRASHCOURSE_CH04_TRACE_SPAN_H
+#define CPPCRASHCOURSE_CH04_TRACE_SPAN_H
+
+// Trace spans in library code, e.g. CH04_TRACE_SPAN("Bank::transfer"); at the top of a function. They are off by
+// default and expand to nothing, so a header using them neither pulls in the tracer nor pays a load per call;
+// define CH04_ENABLE_TRACING to turn every span into a ch04::ScopedTrace.
+
+#if defined(CH04_ENABLE_TRACING)
+
+#include "ch04-trace.h"
+
+#define CH04_TRACE_SPAN_CONCAT_(left, right) left##right
+#define CH04_TRACE_SPAN_CONCAT(left, right) CH04_TRACE_SPAN_CONCAT_(left, right)
+#define CH04_TRACE_SPAN(name) ::ch04::ScopedTrace<name> CH04_TRACE_SPAN_CONCAT(ch04TraceSpan, __LINE__){}
+
+#else
+
+#define CH04_TRACE_SPAN(name) static_cast<void>(0)
+
+#endif
+
+#endif //CPPCRASHCOURSE_CH04_TRACE_SPAN_H
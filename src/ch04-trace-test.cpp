@@ -0,0 +1,217 @@
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "ch04-trace.h"
+
+namespace {
+    struct ParsedEvent {
+        std::string name;
+        char phase;
+        unsigned threadId;
+        double timestamp;
+    };
+
+    // Reads the line of one event, which the tracer writes as
+    // {"name":"...","ph":"B","pid":1,"tid":1,"ts":12.345}
+    // and fails the test on anything else.
+    ParsedEvent parseEvent(const std::string &line) {
+        ParsedEvent event{};
+        size_t position{};
+        const auto expect = [&line, &position](const std::string &text) {
+            if (line.compare(position, text.size(), text) != 0) {
+                throw std::invalid_argument{"expected " + text + " at " + std::to_string(position) + " of " + line};
+            }
+            position += text.size();
+        };
+
+        expect(R"({"name":")");
+        for (; line.at(position) != '"'; position++) {
+            if (line[position] != '\\') {
+                event.name += line[position];
+            } else if (line.at(++position) == 'u') {
+                event.name += static_cast<char>(std::stoi(line.substr(position + 1, 4), nullptr, 16));
+                position += 4;
+            } else {
+                event.name += line[position];
+            }
+        }
+
+        expect(R"(","ph":")");
+        event.phase = line.at(position++);
+        expect(R"(","pid":1,"tid":)");
+        size_t length{};
+        event.threadId = static_cast<unsigned>(std::stoul(line.substr(position), &length));
+        position += length;
+        expect(R"(,"ts":)");
+        event.timestamp = std::stod(line.substr(position), &length);
+        if (line.find('.', position) != position + length - 4) {
+            throw std::invalid_argument{"expected three decimals in " + line};
+        }
+        position += length;
+        expect("}");
+        if (position < line.size()) {
+            expect(",");
+        }
+        if (position != line.size() || (event.phase != 'B' && event.phase != 'E')) {
+            throw std::invalid_argument{"unexpected " + line};
+        }
+
+        return event;
+    }
+
+    // The events of a trace file, which the tracer writes one per line between the brackets of a JSON array.
+    std::vector<ParsedEvent> parse(const std::string &path) {
+        std::ifstream file{path};
+        std::stringstream content{};
+        content << file.rdbuf();
+        const auto text = content.str();
+        EXPECT_EQ(0u, text.find("[\n"));
+        EXPECT_EQ(text.size() - 3, text.rfind("\n]\n"));
+
+        std::vector<ParsedEvent> events{};
+        std::istringstream lines{text};
+        for (std::string line; std::getline(lines, line);) {
+            if (line != "[" && line != "]") {
+                events.push_back(parseEvent(line));
+            }
+        }
+
+        return events;
+    }
+
+    // Every end closes the innermost open span of its thread, nothing stays open, and time never runs backwards
+    // within a thread. Returns the number of events per thread.
+    std::map<unsigned, size_t> expectWellNested(const std::vector<ParsedEvent> &events) {
+        std::map<unsigned, std::vector<std::string>> open{};
+        std::map<unsigned, double> last{};
+        std::map<unsigned, size_t> counts{};
+
+        for (const auto &event: events) {
+            auto &stack = open[event.threadId];
+            if (event.phase == 'B') {
+                stack.push_back(event.name);
+            } else {
+                EXPECT_FALSE(stack.empty()) << "end of " << event.name << " without a begin";
+                if (!stack.empty()) {
+                    EXPECT_EQ(stack.back(), event.name);
+                    stack.pop_back();
+                }
+            }
+
+            EXPECT_LE(last[event.threadId], event.timestamp) << "thread " << event.threadId;
+            last[event.threadId] = event.timestamp;
+            counts[event.threadId]++;
+        }
+
+        for (const auto &[threadId, stack]: open) {
+            EXPECT_TRUE(stack.empty()) << "thread " << threadId << " left " << stack.size() << " spans open";
+        }
+
+        return counts;
+    }
+
+    void nestedSpans(const int count) {
+        for (int i{}; i < count; i++) {
+            ch04::ScopedTrace<"outer"> outer{};
+            {
+                ch04::ScopedTrace<"inner"> inner{};
+            }
+            ch04::ScopedTrace<"second"> second{};
+        }
+    }
+}
+
+struct Ch04Trace : public ::testing::Test {
+    const std::string path{(std::filesystem::temp_directory_path() / "ch04-trace-test.json").string()};
+    const std::string nextPath{(std::filesystem::temp_directory_path() / "ch04-trace-test-next.json").string()};
+
+    void TearDown() override {
+        ch04::Tracer::instance().stop();
+        std::filesystem::remove(path);
+        std::filesystem::remove(nextPath);
+    }
+};
+
+TEST_F(Ch04Trace, NestedSpansFromTwoThreadsPairUp) {
+    ch04::Tracer::instance().start(path, std::chrono::milliseconds{1});
+
+    std::thread first{nestedSpans, 1000};
+    std::thread second{nestedSpans, 1000};
+    first.join();
+    second.join();
+    ch04::Tracer::instance().stop();
+
+    const auto events = parse(path);
+    EXPECT_EQ(2u * 1000 * 6, events.size());
+
+    const auto counts = expectWellNested(events);
+    ASSERT_EQ(2u, counts.size());
+    for (const auto &[threadId, count]: counts) {
+        EXPECT_EQ(1000u * 6, count) << "thread " << threadId;
+    }
+}
+
+TEST_F(Ch04Trace, EscapesNames) {
+    ch04::Tracer::instance().start(path);
+    {
+        ch04::ScopedTrace<"say \"hi\" \\ now\t"> trace{};
+    }
+    ch04::Tracer::instance().stop();
+
+    const auto events = parse(path);
+    ASSERT_EQ(2u, events.size());
+    EXPECT_EQ("say \"hi\" \\ now\t", events[0].name);
+    expectWellNested(events);
+}
+
+TEST_F(Ch04Trace, SpansAcrossARestartStayInTheirFile) {
+    auto &tracer = ch04::Tracer::instance();
+    tracer.start(path);
+    auto straddling = std::make_unique<ch04::ScopedTrace<"straddling">>();
+    tracer.stop();
+
+    tracer.start(nextPath);
+    straddling.reset();
+    {
+        ch04::ScopedTrace<"after"> trace{};
+    }
+    tracer.stop();
+
+    const auto before = parse(path);
+    ASSERT_EQ(1u, before.size());
+    EXPECT_EQ("straddling", before[0].name);
+    EXPECT_EQ('B', before[0].phase);
+
+    const auto after = parse(nextPath);
+    ASSERT_EQ(2u, after.size());
+    EXPECT_EQ("after", after[0].name);
+    expectWellNested(after);
+}
+
+TEST_F(Ch04Trace, ExitedThreadsHandBackTheirBuffers) {
+    auto &tracer = ch04::Tracer::instance();
+    tracer.start(path);
+    const auto buffers = tracer.getBufferCount();
+
+    for (int i{}; i < 50; i++) {
+        std::thread{nestedSpans, 1}.join();
+    }
+    EXPECT_LE(tracer.getBufferCount(), buffers + 1);
+    tracer.stop();
+
+    // every thread's events are kept, under a thread id of its own
+    const auto counts = expectWellNested(parse(path));
+    EXPECT_EQ(50u, counts.size());
+    for (const auto &[threadId, count]: counts) {
+        EXPECT_EQ(6u, count) << "thread " << threadId;
+    }
+}
@@ -0,0 +1,381 @@
+#ifndef CPPCRASHCOURSE_CH04_TRACE_H
+#define CPPCRASHCOURSE_CH04_TRACE_H
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "ch04-scoped-timer.h"
+
+// Define CH04_DISABLE_TRACING to compile every ScopedTrace down to an empty object. The spans in ch05 and ch10
+// are written with CH04_TRACE_SPAN (ch04-trace-span.h) and only exist with CH04_ENABLE_TRACING defined.
+
+namespace ch04 {
+    struct TraceEvent {
+        const char *name;
+        long long ticks;
+        // the Tracer::start() the event belongs to
+        unsigned generation;
+        char phase;
+    };
+
+    // Begin/end events of one thread. Only that thread pushes and only the flush thread pops, so a head and a
+    // tail index are all the synchronization needed; a full buffer drops the event instead of waiting.
+    class TraceBuffer {
+    public:
+        static constexpr size_t CAPACITY{1 << 16};
+
+        explicit TraceBuffer(const unsigned threadId) : threadId{threadId} {}
+
+        // Hands the buffer of an exited thread to a new one. Only while neither pushes nor drains can run.
+        void reuse(const unsigned threadId) {
+            this->threadId = threadId;
+            this->head.store(0, std::memory_order_relaxed);
+            this->cachedTail = 0;
+            this->dropped.store(0, std::memory_order_relaxed);
+            this->tail.store(0, std::memory_order_relaxed);
+        }
+
+        void push(const TraceEvent &event) {
+            const auto head = this->head.load(std::memory_order_relaxed);
+            if (head - this->cachedTail == CAPACITY) {
+                this->cachedTail = this->tail.load(std::memory_order_acquire);
+                if (head - this->cachedTail == CAPACITY) {
+                    this->dropped.store(this->dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                    return;
+                }
+            }
+
+            this->events[head & (CAPACITY - 1)] = event;
+            this->head.store(head + 1, std::memory_order_release);
+        }
+
+        template<typename Consumer>
+        void drain(Consumer &&consumer) {
+            const auto head = this->head.load(std::memory_order_acquire);
+            auto tail = this->tail.load(std::memory_order_relaxed);
+
+            for (; tail != head; tail++) {
+                consumer(this->events[tail & (CAPACITY - 1)]);
+            }
+
+            this->tail.store(tail, std::memory_order_release);
+        }
+
+        [[nodiscard]] unsigned getThreadId() const {
+            return this->threadId;
+        }
+
+        [[nodiscard]] unsigned long long getDropped() const {
+            return this->dropped.load(std::memory_order_relaxed);
+        }
+
+    private:
+        unsigned threadId;
+        std::unique_ptr<TraceEvent[]> events{std::make_unique<TraceEvent[]>(CAPACITY)};
+        alignas(64) std::atomic<size_t> head{};
+        size_t cachedTail{};
+        std::atomic<unsigned long long> dropped{};
+        alignas(64) std::atomic<size_t> tail{};
+    };
+
+    // Collects begin/end events from every thread and writes them as a Chrome trace (JSON array format, which
+    // chrome://tracing and Perfetto open directly). Recording is off until start() and can be paused with
+    // setEnabled(false); while it is off an event costs one relaxed load. An exiting thread hands its buffer
+    // back, and the next new thread reuses it, so a program that keeps starting threads holds only as many
+    // buffers as it ever ran tracing threads at once.
+    class Tracer {
+    public:
+        static Tracer &instance() {
+            static Tracer tracer;
+            return tracer;
+        }
+
+        ~Tracer() {
+            this->stop();
+        }
+
+        Tracer(const Tracer &) = delete;
+
+        Tracer &operator=(const Tracer &) = delete;
+
+        // Opens the file and starts a thread that moves events from the buffers into it every flushInterval.
+        void start(const std::string &path,
+                   const std::chrono::milliseconds flushInterval = std::chrono::milliseconds{10}) {
+            std::lock_guard lock{this->mutex};
+            if (this->flusher.joinable()) {
+                throw std::logic_error{"tracer already started"};
+            }
+
+            this->file.open(path, std::ios::binary | std::ios::trunc);
+            if (!this->file) {
+                throw std::runtime_error{"cannot open " + path};
+            }
+
+            this->file << "[";
+            this->firstEvent = true;
+            // calibrates the TSC here rather than in the first flush, which holds the mutex new threads need
+            TscClock::toNanoseconds(0);
+            this->epoch = TscClock::now();
+
+            // events left over from before, such as the end of a span that began before the last stop(), belong
+            // to the last file; the ones still to come are told apart by their generation
+            for (const auto &buffer: this->buffers) {
+                buffer->drain([](const TraceEvent &) {});
+            }
+            this->generation.store(this->generation.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+            this->flushing.store(true, std::memory_order_release);
+            this->flusher = std::thread{[this, flushInterval] { this->run(flushInterval); }};
+            this->setEnabled(true);
+        }
+
+        // Writes everything recorded so far and closes the file.
+        void stop() {
+            this->setEnabled(false);
+
+            std::unique_lock lock{this->mutex};
+            if (!this->flusher.joinable()) {
+                return;
+            }
+
+            this->flushing.store(false, std::memory_order_release);
+            lock.unlock();
+            this->flusher.join();
+            lock.lock();
+
+            this->flush();
+            this->file << "\n]\n";
+            this->file.close();
+        }
+
+        void setEnabled(const bool enabled) {
+            this->enabled.store(enabled, std::memory_order_relaxed);
+        }
+
+        [[nodiscard]] bool isEnabled() const {
+            return this->enabled.load(std::memory_order_relaxed);
+        }
+
+        // Identifies the current start(), so a span that began before a stop() does not end in the next file.
+        [[nodiscard]] unsigned getGeneration() const {
+            return this->generation.load(std::memory_order_relaxed);
+        }
+
+        void record(const char *name, const char phase, const unsigned generation) {
+            thread_local const ThreadRegistration registration{*this};
+            registration.buffer->push(TraceEvent{name, TscClock::now(), generation, phase});
+        }
+
+        [[nodiscard]] unsigned long long getDropped() {
+            std::lock_guard lock{this->mutex};
+
+            auto dropped = this->exitedDropped;
+            for (const auto &buffer: this->buffers) {
+                dropped += buffer->getDropped();
+            }
+
+            return dropped;
+        }
+
+        // every buffer allocated so far, whether a running thread holds it or it waits for the next one
+        [[nodiscard]] size_t getBufferCount() {
+            std::lock_guard lock{this->mutex};
+            return this->buffers.size() + this->unused.size();
+        }
+
+    private:
+        struct ThreadRegistration {
+            Tracer &tracer;
+            TraceBuffer *buffer;
+
+            explicit ThreadRegistration(Tracer &tracer) : tracer{tracer}, buffer{tracer.addThread()} {}
+
+            ~ThreadRegistration() {
+                this->tracer.retireThread(this->buffer);
+            }
+        };
+
+        std::atomic<bool> enabled{};
+        std::atomic<bool> flushing{};
+        std::atomic<unsigned> generation{};
+        std::mutex mutex;
+        // the buffers of running threads
+        std::vector<std::unique_ptr<TraceBuffer>> buffers;
+        // the emptied buffers of exited threads, for the next new thread
+        std::vector<std::unique_ptr<TraceBuffer>> unused;
+        unsigned long long exitedDropped{};
+        unsigned lastThreadId{};
+        std::ofstream file;
+        std::string text;
+        bool firstEvent{};
+        long long epoch{};
+        std::thread flusher;
+
+        Tracer() = default;
+
+        TraceBuffer *addThread() {
+            std::lock_guard lock{this->mutex};
+            const auto threadId = ++this->lastThreadId;
+
+            if (this->unused.empty()) {
+                return this->buffers.emplace_back(std::make_unique<TraceBuffer>(threadId)).get();
+            }
+
+            this->buffers.push_back(std::move(this->unused.back()));
+            this->unused.pop_back();
+            this->buffers.back()->reuse(threadId);
+            return this->buffers.back().get();
+        }
+
+        // Keeps what the exiting thread recorded last for the next flush, or drops it while nothing is running.
+        void retireThread(TraceBuffer *buffer) {
+            std::lock_guard lock{this->mutex};
+
+            if (this->flusher.joinable()) {
+                this->drain(*buffer);
+            } else {
+                buffer->drain([](const TraceEvent &) {});
+            }
+            this->exitedDropped += buffer->getDropped();
+
+            const auto thread = std::find_if(this->buffers.begin(), this->buffers.end(),
+                                             [buffer](const auto &thread) {
+                                                 return thread.get() == buffer;
+                                             });
+            this->unused.push_back(std::move(*thread));
+            this->buffers.erase(thread);
+        }
+
+        void run(const std::chrono::milliseconds flushInterval) {
+            while (this->flushing.load(std::memory_order_acquire)) {
+                std::this_thread::sleep_for(flushInterval);
+
+                std::lock_guard lock{this->mutex};
+                this->flush();
+            }
+        }
+
+        // called with the mutex held
+        void drain(TraceBuffer &buffer) {
+            const auto threadId = buffer.getThreadId();
+            const auto generation = this->generation.load(std::memory_order_relaxed);
+
+            buffer.drain([this, threadId, generation](const TraceEvent &event) {
+                if (event.generation == generation) {
+                    this->format(event, threadId);
+                }
+            });
+        }
+
+        // called with the mutex held
+        void flush() {
+            for (const auto &buffer: this->buffers) {
+                this->drain(*buffer);
+            }
+
+            this->file.write(this->text.data(), static_cast<std::streamsize>(this->text.size()));
+            this->file.flush();
+            this->text.clear();
+        }
+
+        void format(const TraceEvent &event, const unsigned threadId) {
+            char number[32];
+
+            this->text += this->firstEvent ? "\n" : ",\n";
+            this->firstEvent = false;
+
+            this->text += R"({"name":")";
+            this->escape(event.name);
+            this->text += R"(","ph":")";
+            this->text += event.phase;
+            this->text += R"(","pid":1,"tid":)";
+            this->text.append(number, std::to_chars(number, number + sizeof(number), threadId).ptr);
+
+            // microseconds with nanosecond precision
+            const auto nanoseconds = TscClock::toNanoseconds(event.ticks - this->epoch);
+            this->text += R"(,"ts":)";
+            this->text.append(number, std::to_chars(number, number + sizeof(number), nanoseconds / 1000).ptr);
+            this->text += '.';
+            const auto fraction = std::to_string(1000 + std::abs(nanoseconds % 1000));
+            this->text.append(fraction, 1, 3);
+            this->text += '}';
+        }
+
+        void escape(const char *name) {
+            for (; *name != '\0'; name++) {
+                const auto character = static_cast<unsigned char>(*name);
+                if (character == '"' || character == '\\') {
+                    this->text += '\\';
+                    this->text += *name;
+                } else if (character < 0x20) {
+                    constexpr char HEX[]{"0123456789abcdef"};
+                    this->text += "\\u00";
+                    this->text += HEX[character >> 4];
+                    this->text += HEX[character & 0xF];
+                } else {
+                    this->text += *name;
+                }
+            }
+        }
+    };
+
+#if !defined(CH04_DISABLE_TRACING)
+
+    // Emits a begin event named Name now and the matching end event when the scope exits, e.g.
+    // ch04::ScopedTrace<"ch05.transfer"> trace{};
+    // A moved-from trace emits nothing, so every begin has exactly one end; both carry the generation of the
+    // start() the trace began under, so an end after a restart is left out of the new file.
+    template<TimerName Name>
+    class ScopedTrace {
+    public:
+        ScopedTrace() {
+            auto &tracer = Tracer::instance();
+            if (tracer.isEnabled()) {
+                this->generation = tracer.getGeneration();
+                tracer.record(Name.value, 'B', this->generation);
+            }
+        }
+
+        ~ScopedTrace() {
+            if (this->generation != 0) {
+                Tracer::instance().record(Name.value, 'E', this->generation);
+            }
+        }
+
+        ScopedTrace(const ScopedTrace &other) = delete;
+
+        ScopedTrace &operator=(const ScopedTrace &other) = delete;
+
+        ScopedTrace(ScopedTrace &&other) noexcept: generation{std::exchange(other.generation, 0)} {}
+
+        ScopedTrace &operator=(ScopedTrace &&other) = delete;
+
+    private:
+        // zero when the trace emits nothing
+        unsigned generation{};
+    };
+
+#else
+
+    template<TimerName Name>
+    class ScopedTrace {
+    };
+
+    static_assert(std::is_empty_v<ScopedTrace<"">> && std::is_trivially_destructible_v<ScopedTrace<"">>);
+
+#endif
+}
+
+#endif //CPPCRASHCOURSE_CH04_TRACE_H
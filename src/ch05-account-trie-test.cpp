@@ -0,0 +1,200 @@
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "ch05-account-trie.h"
+#include "ch05-snapshot-account-database.h"
+
+namespace {
+    // Dense accounts, which fill whole nodes, mixed with sparse and negative ones and with accounts that share
+    // their low bits and only part deep down the trie.
+    long randomAccount(std::mt19937_64 &random) {
+        switch (random() % 4) {
+            case 0:
+                return static_cast<long>(random() % 2048);
+            case 1:
+                return static_cast<long>(random());
+            case 2:
+                return -static_cast<long>(random() % 2048);
+            default:
+                return static_cast<long>((random() % 16) << 58) | 7;
+        }
+    }
+
+    std::map<long, long long> collect(const ch05::AccountSnapshot &snapshot) {
+        std::map<long, long long> balances{};
+        snapshot.forEach([&balances](const long account, const long long amount) {
+            EXPECT_TRUE(balances.emplace(account, amount).second) << "account " << account << " visited twice";
+        });
+
+        return balances;
+    }
+
+    void expectSnapshot(const std::map<long, long long> &expected, const ch05::AccountSnapshot &snapshot) {
+        EXPECT_EQ(expected.size(), snapshot.getSize());
+        EXPECT_EQ(expected, collect(snapshot));
+        for (const auto &[account, amount]: expected) {
+            ASSERT_EQ(amount, snapshot.getAmount(account)) << "account " << account;
+        }
+    }
+
+    // the trie after writes to random accounts, and the same balances in an ordered map
+    std::pair<std::map<long, long long>, ch05::AccountSnapshot> randomBalances(ch05::AccountTrie &accounts,
+                                                                               const int writes) {
+        std::mt19937_64 random{7};
+        std::map<long, long long> oracle{};
+        for (int i{}; i < writes; i++) {
+            const auto account = randomAccount(random);
+            const auto amount = static_cast<long long>(random() % 1000);
+            accounts.findOrInsert(account) += amount;
+            oracle[account] += amount;
+        }
+
+        return {oracle, accounts.snapshot()};
+    }
+}
+
+TEST(Ch05AccountTrie, MatchesAMapThroughRandomWrites) {
+    ch05::AccountTrie accounts{};
+    std::map<long, long long> oracle{};
+    std::mt19937_64 random{42};
+
+    for (int i{}; i < 50'000; i++) {
+        const auto account = randomAccount(random);
+        const auto amount = static_cast<long long>(random() % 2001) - 1000;
+
+        if (random() % 2 == 0) {
+            accounts.findOrInsert(account) = amount;
+            oracle[account] = amount;
+        } else {
+            accounts.findOrInsert(account) += amount;
+            oracle[account] += amount;
+        }
+
+        const auto probe = randomAccount(random);
+        const auto *entry = accounts.find(probe);
+        const auto expected = oracle.find(probe);
+        ASSERT_EQ(expected != oracle.end(), entry != nullptr) << "account " << probe;
+        if (entry != nullptr) {
+            ASSERT_EQ(expected->second, entry->amount) << "account " << probe;
+        }
+    }
+
+    EXPECT_EQ(oracle.size(), accounts.getSize());
+    expectSnapshot(oracle, accounts.snapshot());
+}
+
+TEST(Ch05AccountTrie, OldSnapshotsDoNotChange) {
+    ch05::AccountTrie accounts{};
+    std::map<long, long long> oracle{};
+    std::vector<std::pair<std::map<long, long long>, ch05::AccountSnapshot>> snapshots{};
+    std::mt19937_64 random{1};
+
+    for (int i{}; i < 20'000; i++) {
+        const auto account = randomAccount(random);
+        accounts.findOrInsert(account) += 1;
+        oracle[account] += 1;
+
+        if (i % 1000 == 0) {
+            snapshots.emplace_back(oracle, accounts.snapshot());
+        }
+
+        // some snapshots are dropped again, so the writer goes back to changing their nodes in place
+        if (i % 3000 == 0 && snapshots.size() > 1) {
+            snapshots.erase(snapshots.begin() + static_cast<std::ptrdiff_t>(random() % snapshots.size()));
+        }
+    }
+
+    for (const auto &[expected, snapshot]: snapshots) {
+        expectSnapshot(expected, snapshot);
+    }
+    expectSnapshot(oracle, accounts.snapshot());
+}
+
+TEST(Ch05AccountTrie, CopiedSnapshotsOutliveTheTrie) {
+    ch05::AccountSnapshot copy{};
+    std::map<long, long long> oracle{};
+    {
+        ch05::AccountTrie accounts{};
+        auto [balances, snapshot] = randomBalances(accounts, 5000);
+        oracle = std::move(balances);
+        copy = snapshot;
+        accounts.findOrInsert(1) += 1;
+    }
+
+    expectSnapshot(oracle, copy);
+}
+
+TEST(Ch05AccountTrie, ParallelForEachVisitsEveryAccountOnce) {
+    ch05::AccountTrie accounts{};
+    const auto [oracle, snapshot] = randomBalances(accounts, 20'000);
+
+    for (const size_t threadCount: {1, 2, 3, 8, 64}) {
+        std::mutex mutex{};
+        std::map<long, long long> visited{};
+        snapshot.parallelForEach(threadCount, [&mutex, &visited](const long account, const long long amount) {
+            std::lock_guard lock{mutex};
+            EXPECT_TRUE(visited.emplace(account, amount).second) << "account " << account << " visited twice";
+        });
+
+        EXPECT_EQ(oracle, visited) << threadCount << " threads";
+    }
+}
+
+TEST(Ch05AccountTrie, ParallelForEachOnAnEmptySnapshot) {
+    const ch05::AccountSnapshot snapshot{};
+    std::atomic<int> visits{};
+    snapshot.parallelForEach(4, [&visits](long, long long) {
+        visits++;
+    });
+
+    EXPECT_EQ(0, visits.load());
+    EXPECT_EQ(0, snapshot.getTotal(4));
+}
+
+TEST(Ch05AccountTrie, TotalsAgreeForAnyThreadCount) {
+    ch05::AccountTrie accounts{};
+    const auto [oracle, snapshot] = randomBalances(accounts, 20'000);
+
+    long long expected{};
+    for (const auto &[account, amount]: oracle) {
+        expected += amount;
+    }
+
+    for (const size_t threadCount: {0, 1, 2, 5, 16}) {
+        EXPECT_EQ(expected, snapshot.getTotal(threadCount)) << threadCount << " threads";
+    }
+}
+
+TEST(Ch05SnapshotAccountDatabase, SnapshotsKeepTheTotalWhileTransfersGoOn) {
+    constexpr long accountCount{4096};
+    ch05::SnapshotAccountDatabase database{};
+    for (long account{}; account < accountCount; account++) {
+        database.setAmount(account, 100);
+    }
+
+    std::atomic<bool> transferring{true};
+    std::thread writer{[&database, &transferring] {
+        std::mt19937_64 random{3};
+        for (int i{}; i < 100'000; i++) {
+            database.transfer(static_cast<long>(random() % accountCount), static_cast<long>(random() % accountCount),
+                              static_cast<long long>(random() % 50));
+        }
+        transferring.store(false);
+    }};
+
+    do {
+        const auto snapshot = database.snapshot();
+        ASSERT_EQ(static_cast<size_t>(accountCount), snapshot.getSize());
+        ASSERT_EQ(accountCount * 100, snapshot.getTotal(2));
+    } while (transferring.load());
+
+    writer.join();
+    EXPECT_EQ(accountCount * 100, database.snapshot().getTotal(1));
+}
@@ -0,0 +1,416 @@
+#ifndef CPPCRASHCOURSE_CH05_ACCOUNT_TRIE_H
+#define CPPCRASHCOURSE_CH05_ACCOUNT_TRIE_H
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <new>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace ch05 {
+    // Nodes of a persistent hash trie (CHAMP): every node covers five bits of the account number and keeps two
+    // 32-bit maps, one of the balances stored inline and one of the child nodes, so a node is exactly as large
+    // as what it holds. Every node counts the parents and snapshots pointing to it; the writer changes a node
+    // in place only while that count is one and copies it otherwise.
+    namespace trie {
+        constexpr unsigned BITS = 5;
+
+        struct Entry {
+            long account;
+            long long amount;
+        };
+
+        inline unsigned countBits(std::uint32_t bits) {
+#if defined(__POPCNT__)
+            return static_cast<unsigned>(std::popcount(bits));
+#else
+            // without the instruction std::popcount is a library call, which is slower than this
+            bits -= (bits >> 1) & 0x55555555u;
+            bits = (bits & 0x33333333u) + ((bits >> 2) & 0x33333333u);
+            bits = (bits + (bits >> 4)) & 0x0F0F0F0Fu;
+            return (bits * 0x01010101u) >> 24;
+#endif
+        }
+
+        struct alignas(16) Node {
+            std::atomic<long> references;
+            std::uint32_t entryMap;
+            std::uint32_t childMap;
+
+            [[nodiscard]] unsigned entryCount() const {
+                return countBits(this->entryMap);
+            }
+
+            [[nodiscard]] unsigned childCount() const {
+                return countBits(this->childMap);
+            }
+
+            Entry *entries() {
+                return reinterpret_cast<Entry *>(this + 1);
+            }
+
+            [[nodiscard]] const Entry *entries() const {
+                return reinterpret_cast<const Entry *>(this + 1);
+            }
+
+            Node **children() {
+                return reinterpret_cast<Node **>(this->entries() + this->entryCount());
+            }
+
+            [[nodiscard]] Node *const *children() const {
+                return reinterpret_cast<Node *const *>(this->entries() + this->entryCount());
+            }
+        };
+
+        // Account numbers are mostly dense, so they are used as they are: consecutive accounts fill whole nodes
+        // and the trie stays shallow. Distinct accounts still differ somewhere in their 64 bits.
+        inline unsigned long long hash(const long account) {
+            return static_cast<unsigned long long>(account);
+        }
+
+        inline std::uint32_t bit(const unsigned long long hash, const unsigned depth) {
+            return std::uint32_t{1} << ((hash >> (BITS * depth)) & 31);
+        }
+
+        // position of the entry or child for bit among those present in map
+        inline unsigned rank(const std::uint32_t map, const std::uint32_t bit) {
+            return countBits(map & (bit - 1));
+        }
+
+        // an uninitialized node with room for exactly what the maps say
+        inline Node *allocate(const std::uint32_t entryMap, const std::uint32_t childMap) {
+            const auto size = sizeof(Node) + countBits(entryMap) * sizeof(Entry) + countBits(childMap) * sizeof(Node *);
+            auto *node = static_cast<Node *>(::operator new(size, std::align_val_t{alignof(Node)}));
+            node->references.store(1, std::memory_order_relaxed);
+            node->entryMap = entryMap;
+            node->childMap = childMap;
+
+            return node;
+        }
+
+        inline void deallocate(Node *node) {
+            ::operator delete(node, std::align_val_t{alignof(Node)});
+        }
+
+        inline void retain(Node *node) {
+            if (node != nullptr) {
+                node->references.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        inline void release(Node *node) {
+            if (node == nullptr || node->references.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+                return;
+            }
+
+            for (unsigned i{}; i < node->childCount(); i++) {
+                release(node->children()[i]);
+            }
+            deallocate(node);
+        }
+
+        inline const Entry *find(const Node *node, const long account) {
+            const auto hash = trie::hash(account);
+
+            for (unsigned depth{}; node != nullptr; depth++) {
+                const auto bit = trie::bit(hash, depth);
+
+                if ((node->entryMap & bit) != 0) {
+                    const auto *entry = &node->entries()[rank(node->entryMap, bit)];
+                    return entry->account == account ? entry : nullptr;
+                }
+
+                if ((node->childMap & bit) == 0) {
+                    return nullptr;
+                }
+
+                node = node->children()[rank(node->childMap, bit)];
+            }
+
+            return nullptr;
+        }
+
+        template<typename Visitor>
+        void forEachEntry(const Node *node, Visitor &visitor) {
+            for (unsigned i{}; i < node->entryCount(); i++) {
+                visitor(node->entries()[i].account, node->entries()[i].amount);
+            }
+        }
+
+        template<typename Visitor>
+        void forEach(const Node *node, Visitor &visitor) {
+            if (node == nullptr) {
+                return;
+            }
+
+            forEachEntry(node, visitor);
+            for (unsigned i{}; i < node->childCount(); i++) {
+                forEach(node->children()[i], visitor);
+            }
+        }
+    }
+
+    // A read-only, point-in-time view of the balances. Taking one costs a reference count increment; the
+    // database keeps changing behind it, copying only the nodes it writes to while the view holds them, so a
+    // view costs memory in proportion to the accounts changed since it was taken.
+    class AccountSnapshot {
+    public:
+        AccountSnapshot() = default;
+
+        ~AccountSnapshot() {
+            trie::release(this->root);
+        }
+
+        AccountSnapshot(const AccountSnapshot &other) : root{other.root}, size{other.size} {
+            trie::retain(this->root);
+        }
+
+        AccountSnapshot(AccountSnapshot &&other) noexcept
+                : root{std::exchange(other.root, nullptr)}, size{std::exchange(other.size, 0)} {}
+
+        AccountSnapshot &operator=(AccountSnapshot other) noexcept {
+            std::swap(this->root, other.root);
+            std::swap(this->size, other.size);
+            return *this;
+        }
+
+        [[nodiscard]] long long getAmount(const long account) const {
+            const auto *entry = trie::find(this->root, account);
+            return entry == nullptr ? 0 : entry->amount;
+        }
+
+        [[nodiscard]] size_t getSize() const {
+            return this->size;
+        }
+
+        // calls visitor(account, amount) for every account, in no particular order
+        template<typename Visitor>
+        void forEach(Visitor &&visitor) const {
+            trie::forEach(this->root, visitor);
+        }
+
+        // Calls visitor(account, amount) from threadCount threads at once, each account exactly once.
+        template<typename Visitor>
+        void parallelForEach(const size_t threadCount, Visitor &&visitor) const {
+            this->parallelSubtrees(threadCount, [&visitor](const trie::Node *node, const bool entriesOnly, size_t) {
+                entriesOnly ? trie::forEachEntry(node, visitor) : trie::forEach(node, visitor);
+            });
+        }
+
+        [[nodiscard]] long long getTotal(const size_t threadCount = std::thread::hardware_concurrency()) const {
+            struct alignas(64) Sum {
+                long long value;
+            };
+
+            std::vector<Sum> sums(std::max<size_t>(threadCount, 1));
+            this->parallelSubtrees(sums.size(), [&sums](const trie::Node *node, const bool entriesOnly,
+                                                        const size_t thread) {
+                auto add = [&sum = sums[thread].value](long, const long long amount) {
+                    sum += amount;
+                };
+                entriesOnly ? trie::forEachEntry(node, add) : trie::forEach(node, add);
+            });
+
+            long long total{};
+            for (const auto &sum: sums) {
+                total += sum.value;
+            }
+
+            return total;
+        }
+
+    private:
+        friend class AccountTrie;
+
+        trie::Node *root{};
+        size_t size{};
+
+        AccountSnapshot(trie::Node *root, const size_t size) : root{root}, size{size} {
+            trie::retain(root);
+        }
+
+        // Cuts the trie into at least eight subtrees per thread where it is deep enough, and lets threadCount
+        // threads take them one at a time as task(node, entriesOnly, thread); the nodes cut off from their
+        // children come with entriesOnly set, so their inline balances are visited exactly once too.
+        template<typename Task>
+        void parallelSubtrees(const size_t threadCount, Task &&task) const {
+            struct Piece {
+                const trie::Node *node;
+                bool entriesOnly;
+            };
+
+            std::vector<Piece> pieces{};
+            std::vector<const trie::Node *> frontier{};
+            if (this->root != nullptr) {
+                frontier.push_back(this->root);
+            }
+
+            while (!frontier.empty() && frontier.size() < 8 * threadCount) {
+                std::vector<const trie::Node *> children{};
+                for (const auto *node: frontier) {
+                    if (node->entryCount() > 0) {
+                        pieces.push_back(Piece{node, true});
+                    }
+                    children.insert(children.end(), node->children(), node->children() + node->childCount());
+                }
+                frontier.swap(children);
+            }
+
+            for (const auto *node: frontier) {
+                pieces.push_back(Piece{node, false});
+            }
+
+            std::atomic<size_t> next{};
+            const auto work = [&pieces, &next, &task](const size_t thread) {
+                for (auto i = next.fetch_add(1, std::memory_order_relaxed); i < pieces.size();
+                     i = next.fetch_add(1, std::memory_order_relaxed)) {
+                    task(pieces[i].node, pieces[i].entriesOnly, thread);
+                }
+            };
+
+            std::vector<std::thread> threads{};
+            for (size_t thread{1}; thread < threadCount; thread++) {
+                threads.emplace_back(work, thread);
+            }
+            work(0);
+
+            for (auto &thread: threads) {
+                thread.join();
+            }
+        }
+    };
+
+    // The writable side: one owner changes the trie while any number of snapshots read older versions of it
+    // from other threads.
+    class AccountTrie {
+    public:
+        AccountTrie() = default;
+
+        ~AccountTrie() {
+            trie::release(this->root);
+        }
+
+        AccountTrie(const AccountTrie &) = delete;
+
+        AccountTrie &operator=(const AccountTrie &) = delete;
+
+        [[nodiscard]] const trie::Entry *find(const long account) const {
+            return trie::find(this->root, account);
+        }
+
+        // the balance of account, inserted as zero if it is new, in a node no snapshot can see
+        long long &findOrInsert(const long account) {
+            const auto hash = trie::hash(account);
+            if (this->root == nullptr) {
+                this->root = single(trie::bit(hash, 0), trie::Entry{account, 0});
+                this->size++;
+                return this->root->entries()[0].amount;
+            }
+
+            auto **slot = &this->root;
+            for (unsigned depth{};; depth++) {
+                auto *node = unshare(*slot);
+                const auto bit = trie::bit(hash, depth);
+
+                if ((node->childMap & bit) != 0) {
+                    slot = &node->children()[trie::rank(node->childMap, bit)];
+                    continue;
+                }
+
+                if ((node->entryMap & bit) == 0) {
+                    node = *slot = insertEntry(node, bit, trie::Entry{account, 0});
+                    this->size++;
+                    return node->entries()[trie::rank(node->entryMap, bit)].amount;
+                }
+
+                auto &entry = node->entries()[trie::rank(node->entryMap, bit)];
+                if (entry.account == account) {
+                    return entry.amount;
+                }
+
+                // another account holds the spot: it moves one level down into a node of its own, and the
+                // search goes on there
+                node = *slot = pushDown(node, bit, entry, depth);
+                slot = &node->children()[trie::rank(node->childMap, bit)];
+            }
+        }
+
+        [[nodiscard]] AccountSnapshot snapshot() const {
+            return AccountSnapshot{this->root, this->size};
+        }
+
+        [[nodiscard]] size_t getSize() const {
+            return this->size;
+        }
+
+    private:
+        trie::Node *root{};
+        size_t size{};
+
+        // Makes the node at slot private to the trie. The acquire load pairs with the release of the last
+        // snapshot that shared it, so that snapshot's reads are done before the node is written in place.
+        static trie::Node *unshare(trie::Node *&slot) {
+            auto *node = slot;
+            if (node->references.load(std::memory_order_acquire) == 1) {
+                return node;
+            }
+
+            auto *copy = trie::allocate(node->entryMap, node->childMap);
+            std::copy_n(node->entries(), node->entryCount(), copy->entries());
+            for (unsigned i{}; i < node->childCount(); i++) {
+                copy->children()[i] = node->children()[i];
+                trie::retain(copy->children()[i]);
+            }
+
+            trie::release(node);
+            slot = copy;
+
+            return copy;
+        }
+
+        static trie::Node *single(const std::uint32_t bit, const trie::Entry &entry) {
+            auto *node = trie::allocate(bit, 0);
+            node->entries()[0] = entry;
+
+            return node;
+        }
+
+        // the private node grown by one inline balance; the old node is freed
+        static trie::Node *insertEntry(trie::Node *node, const std::uint32_t bit, const trie::Entry &entry) {
+            auto *grown = trie::allocate(node->entryMap | bit, node->childMap);
+            const auto at = trie::rank(node->entryMap, bit);
+
+            std::copy_n(node->entries(), at, grown->entries());
+            grown->entries()[at] = entry;
+            std::copy_n(node->entries() + at, node->entryCount() - at, grown->entries() + at + 1);
+            std::copy_n(node->children(), node->childCount(), grown->children());
+
+            trie::deallocate(node);
+            return grown;
+        }
+
+        // the private node with the balance at bit replaced by a child node holding just that balance
+        static trie::Node *pushDown(trie::Node *node, const std::uint32_t bit, const trie::Entry entry,
+                                    const unsigned depth) {
+            auto *child = single(trie::bit(trie::hash(entry.account), depth + 1), entry);
+
+            auto *moved = trie::allocate(node->entryMap & ~bit, node->childMap | bit);
+            const auto entryAt = trie::rank(node->entryMap, bit);
+            const auto childAt = trie::rank(node->childMap, bit);
+
+            std::copy_n(node->entries(), entryAt, moved->entries());
+            std::copy_n(node->entries() + entryAt + 1, node->entryCount() - entryAt - 1, moved->entries() + entryAt);
+            std::copy_n(node->children(), childAt, moved->children());
+            moved->children()[childAt] = child;
+            std::copy_n(node->children() + childAt, node->childCount() - childAt, moved->children() + childAt + 1);
+
+            trie::deallocate(node);
+            return moved;
+        }
+    };
+}
+
+#endif //CPPCRASHCOURSE_CH05_ACCOUNT_TRIE_H
@@ -0,0 +1,178 @@
+#include <atomic>
+#include <chrono>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "ch05-async-logger.h"
+
+namespace {
+    // A string buffer whose writes wait until open() is called, so a test can hold the logger's writer thread
+    // in the middle of a batch while it fills the ring buffer.
+    class GatedBuffer : public std::stringbuf {
+    public:
+        void waitUntilEntered() const {
+            while (!this->entered.load()) {
+                std::this_thread::yield();
+            }
+        }
+
+        void open() {
+            this->opened.store(true);
+        }
+
+    protected:
+        std::streamsize xsputn(const char *text, const std::streamsize count) override {
+            this->entered.store(true);
+            while (!this->opened.load()) {
+                std::this_thread::yield();
+            }
+
+            return std::stringbuf::xsputn(text, count);
+        }
+
+    private:
+        std::atomic<bool> entered{};
+        std::atomic<bool> opened{};
+    };
+
+    std::vector<std::string> lines(const std::string &text) {
+        std::vector<std::string> lines{};
+        std::istringstream stream{text};
+        for (std::string line; std::getline(stream, line);) {
+            lines.push_back(line);
+        }
+
+        return lines;
+    }
+
+    size_t countTransfers(const std::string &text) {
+        size_t count{};
+        for (const auto &line: lines(text)) {
+            count += line.find(": transfer from account: ") != std::string::npos;
+        }
+
+        return count;
+    }
+
+    // one transfer that occupies the writer, then enough to fill a ring buffer of four and overflow it by ten
+    void overflow(ch05::AsyncLogger &logger, GatedBuffer &buffer) {
+        logger.transfer(0, 1, 1);
+        buffer.waitUntilEntered();
+
+        for (long i{}; i < 14; i++) {
+            logger.transfer(i, i + 1, 100 + i);
+        }
+    }
+}
+
+TEST(Ch05AsyncLogger, WritesTransfersInOrder) {
+    std::ostringstream stream{};
+    ch05::AsyncLogger logger{"bank", stream};
+
+    for (long i{}; i < 1000; i++) {
+        logger.transfer(i, i + 1, i * 10);
+    }
+    logger.flush();
+
+    const auto written = lines(stream.str());
+    ASSERT_EQ(1000u, written.size());
+    EXPECT_EQ(0u, written[7].find("bank: transfer from account: 7 to account: 8 amount: 70 timestamp: "));
+    EXPECT_EQ(0u, written[999].find("bank: transfer from account: 999 to account: 1000 amount: 9990 timestamp: "));
+}
+
+TEST(Ch05AsyncLogger, KeepsEveryTransferFromManyThreads) {
+    constexpr long perThread{20'000};
+    std::ostringstream stream{};
+    ch05::AsyncLogger logger{"bank", stream, 64, ch05::OverflowPolicy::Block};
+
+    std::vector<std::thread> threads{};
+    for (long thread{}; thread < 4; thread++) {
+        threads.emplace_back([&logger, thread] {
+            for (long i{}; i < perThread; i++) {
+                logger.transfer(thread, i, 1);
+            }
+        });
+    }
+    for (auto &thread: threads) {
+        thread.join();
+    }
+    logger.flush();
+
+    EXPECT_EQ(static_cast<size_t>(4 * perThread), countTransfers(stream.str()));
+    EXPECT_EQ(0u, logger.getOverflowCount());
+}
+
+TEST(Ch05AsyncLogger, DropPolicyLosesTransfersQuietly) {
+    GatedBuffer buffer{};
+    std::ostream stream{&buffer};
+    ch05::AsyncLogger logger{"bank", stream, 4, ch05::OverflowPolicy::Drop};
+
+    overflow(logger, buffer);
+    EXPECT_EQ(10u, logger.getOverflowCount());
+
+    buffer.open();
+    logger.flush();
+
+    EXPECT_EQ(5u, countTransfers(buffer.str()));
+    EXPECT_EQ(std::string::npos, buffer.str().find("dropped"));
+}
+
+TEST(Ch05AsyncLogger, CountPolicyReportsTheDroppedTransfers) {
+    GatedBuffer buffer{};
+    std::ostream stream{&buffer};
+    ch05::AsyncLogger logger{"bank", stream, 4, ch05::OverflowPolicy::Count};
+
+    overflow(logger, buffer);
+    EXPECT_EQ(10u, logger.getOverflowCount());
+
+    buffer.open();
+    logger.flush();
+
+    EXPECT_EQ(5u, countTransfers(buffer.str()));
+    EXPECT_NE(std::string::npos, buffer.str().find("bank: dropped transfers: 10\n"));
+}
+
+TEST(Ch05AsyncLogger, BlockPolicyWaitsForRoom) {
+    GatedBuffer buffer{};
+    std::ostream stream{&buffer};
+    ch05::AsyncLogger logger{"bank", stream, 4, ch05::OverflowPolicy::Block};
+
+    logger.transfer(0, 1, 1);
+    buffer.waitUntilEntered();
+    for (long i{}; i < 4; i++) {
+        logger.transfer(i, i + 1, 1);
+    }
+
+    std::atomic<bool> returned{};
+    std::thread blocked{[&logger, &returned] {
+        logger.transfer(5, 6, 1);
+        returned.store(true);
+    }};
+
+    std::this_thread::sleep_for(std::chrono::milliseconds{20});
+    EXPECT_FALSE(returned.load());
+
+    buffer.open();
+    blocked.join();
+    logger.flush();
+
+    EXPECT_EQ(6u, countTransfers(buffer.str()));
+    EXPECT_EQ(0u, logger.getOverflowCount());
+}
+
+TEST(Ch05AsyncLogger, DrainsEverythingOnDestruction) {
+    std::ostringstream stream{};
+    {
+        // more than one batch, and no flush before the destructor
+        ch05::AsyncLogger logger{"bank", stream, 1 << 15, ch05::OverflowPolicy::Block};
+        for (long i{}; i < 10'000; i++) {
+            logger.transfer(i, i + 1, 1);
+        }
+    }
+
+    EXPECT_EQ(10'000u, countTransfers(stream.str()));
+}
@@ -0,0 +1,169 @@
+#ifndef CPPCRASHCOURSE_CH05_ASYNC_LOGGER_H
+#define CPPCRASHCOURSE_CH05_ASYNC_LOGGER_H
+
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <ostream>
+#include <string>
+#include <thread>
+
+#include "ch04-trace-span.h"
+#include "ch05.h"
+#include "ch10-bounded-queue.h"
+
+namespace ch05 {
+    enum class OverflowPolicy {
+        Drop,
+        Block,
+        Count,
+    };
+
+    // Pushes fixed-size binary records into a bounded lock-free MPSC queue; a background thread
+    // formats them and writes them to the stream in large batches, so transfer() never touches the stream.
+    class AsyncLogger : public Logger {
+    public:
+        AsyncLogger(const char *name, std::ostream &stream, const size_t capacity = 1 << 16,
+                    const OverflowPolicy overflowPolicy = OverflowPolicy::Count)
+                : name{name}, stream{stream}, overflowPolicy{overflowPolicy}, records{capacity} {
+            this->buffer.reserve(BATCH_SIZE * 96);
+            this->writer = std::thread{[this] { this->run(); }};
+        }
+
+        ~AsyncLogger() override {
+            this->running.store(false, std::memory_order_release);
+            this->writer.join();
+        }
+
+        AsyncLogger(const AsyncLogger &) = delete;
+
+        AsyncLogger &operator=(const AsyncLogger &) = delete;
+
+        void transfer(const long fromAccount, const long toAccount, const long long amount) const override {
+            const auto timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::system_clock::now().time_since_epoch()).count();
+
+            const Record record{fromAccount, toAccount, amount, timestamp};
+
+            while (!this->records.try_push(record)) {
+                if (this->overflowPolicy != OverflowPolicy::Block) {
+                    this->overflowCount.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+
+                std::this_thread::yield();
+            }
+        }
+
+        // Blocks until every record pushed before the call has been written and the stream flushed.
+        void flush() const {
+            const auto target = this->records.push_count();
+
+            while (this->writtenPosition.load(std::memory_order_acquire) < target) {
+                std::this_thread::yield();
+            }
+        }
+
+        [[nodiscard]] unsigned long long getOverflowCount() const {
+            return this->overflowCount.load(std::memory_order_relaxed);
+        }
+
+    private:
+        static constexpr size_t BATCH_SIZE = 4096;
+
+        struct Record {
+            long fromAccount;
+            long toAccount;
+            long long amount;
+            long long timestamp;
+        };
+
+        const char *name;
+        std::ostream &stream;
+        OverflowPolicy overflowPolicy;
+        mutable ch10::BoundedQueue<Record> records;
+
+        alignas(64) mutable std::atomic<unsigned long long> overflowCount{};
+        alignas(64) std::atomic<size_t> writtenPosition{};
+        std::atomic<bool> running{true};
+        size_t popCount{};
+        unsigned long long reportedOverflowCount{};
+        std::string buffer;
+        std::thread writer;
+
+        void run() {
+            for (;;) {
+                // read the flag before draining, so nothing pushed before the destructor is lost
+                const auto stopping = !this->running.load(std::memory_order_acquire);
+
+                size_t count{};
+                Record record{};
+                while (count < BATCH_SIZE && this->records.try_pop(record)) {
+                    this->format(record);
+                    count++;
+                }
+
+                this->reportOverflow();
+
+                if (!this->buffer.empty()) {
+                    CH04_TRACE_SPAN("AsyncLogger::write");
+                    this->stream.write(this->buffer.data(), static_cast<std::streamsize>(this->buffer.size()));
+                    this->stream.flush();
+                    this->buffer.clear();
+                }
+
+                this->popCount += count;
+                this->writtenPosition.store(this->popCount, std::memory_order_release);
+
+                if (count == BATCH_SIZE) {
+                    continue;
+                }
+
+                if (stopping) {
+                    return;
+                }
+
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+        }
+
+        void format(const Record &record) {
+            this->buffer.append(this->name);
+            this->buffer.append(": transfer from account: ");
+            this->append(record.fromAccount);
+            this->buffer.append(" to account: ");
+            this->append(record.toAccount);
+            this->buffer.append(" amount: ");
+            this->append(record.amount);
+            this->buffer.append(" timestamp: ");
+            this->append(record.timestamp);
+            this->buffer.push_back('\n');
+        }
+
+        void reportOverflow() {
+            if (this->overflowPolicy != OverflowPolicy::Count) {
+                return;
+            }
+
+            const auto overflowCount = this->overflowCount.load(std::memory_order_relaxed);
+            if (overflowCount == this->reportedOverflowCount) {
+                return;
+            }
+
+            this->buffer.append(this->name);
+            this->buffer.append(": dropped transfers: ");
+            this->append(static_cast<long long>(overflowCount - this->reportedOverflowCount));
+            this->buffer.push_back('\n');
+
+            this->reportedOverflowCount = overflowCount;
+        }
+
+        void append(const long long value) {
+            char digits[24];
+            auto result = std::to_chars(std::begin(digits), std::end(digits), value);
+            this->buffer.append(digits, result.ptr);
+        }
+    };
+}
+
+#endif //CPPCRASHCOURSE_CH05_ASYNC_LOGGER_H
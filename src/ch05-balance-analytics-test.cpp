@@ -0,0 +1,222 @@
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+#include <map>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "ch05-balance-analytics.h"
+
+// the analytics refer to their columns, so they cannot be built from a temporary
+static_assert(std::is_constructible_v<ch05::BalanceAnalytics, const ch05::BalanceColumns &, size_t>);
+static_assert(!std::is_constructible_v<ch05::BalanceAnalytics, ch05::BalanceColumns, size_t>);
+static_assert(!std::is_constructible_v<ch05::BalanceAnalytics, const ch05::BalanceColumns, size_t>);
+
+namespace {
+    // more threads than some of the column sizes below have balances, so some chunks come out empty
+    constexpr size_t THREAD_COUNTS[]{1, 3, 8};
+
+    ch05::BalanceColumns makeColumns(const std::vector<long long> &amounts) {
+        ch05::BalanceColumns columns{};
+        columns.amounts = amounts;
+        columns.accounts.resize(amounts.size());
+        std::iota(columns.accounts.begin(), columns.accounts.end(), 100);
+
+        return columns;
+    }
+
+    // balances over several orders of magnitude and of either sign, with many repeated amounts
+    ch05::BalanceColumns randomColumns(const size_t size, const unsigned seed) {
+        std::mt19937_64 random{seed};
+        std::uniform_int_distribution<int> digits{0, 12};
+
+        std::vector<long long> amounts(size);
+        for (auto &amount: amounts) {
+            long long magnitude{1};
+            for (auto digit = digits(random); digit > 0; digit--) {
+                magnitude *= 10;
+            }
+            amount = static_cast<long long>(random() % static_cast<unsigned long long>(magnitude));
+            amount = random() % 4 == 0 ? -amount : amount;
+        }
+
+        return makeColumns(amounts);
+    }
+}
+
+TEST(Ch05BalanceAnalytics, RejectsColumnsOfDifferentLengths) {
+    auto columns = makeColumns({1, 2, 3});
+    columns.accounts.pop_back();
+
+    EXPECT_THROW(ch05::BalanceAnalytics(columns, 2), std::invalid_argument);
+}
+
+TEST(Ch05BalanceAnalytics, ExportsASnapshotWhileWritersContinue) {
+    ch05::SnapshotAccountDatabase database{};
+    std::map<long, long long> expected{};
+    for (long account{-50}; account < 50; account++) {
+        database.setAmount(account, account * 3);
+        expected[account] = account * 3;
+    }
+    database.transfer(-50, 1000, 25);
+    expected[-50] -= 25;
+    expected[1000] += 25;
+
+    const auto snapshot = database.snapshot();
+    database.transfer(1000, 2000, 25);
+    database.setAmount(0, 7);
+
+    const auto columns = ch05::exportColumns(snapshot);
+    ASSERT_EQ(expected.size(), columns.size());
+    ASSERT_EQ(columns.accounts.size(), columns.amounts.size());
+
+    std::map<long, long long> exported{};
+    for (size_t i{}; i < columns.size(); i++) {
+        EXPECT_TRUE(exported.emplace(columns.accounts[i], columns.amounts[i]).second);
+    }
+    EXPECT_EQ(expected, exported);
+    EXPECT_EQ(-150, ch05::BalanceAnalytics(columns, 3).getTotal());
+
+    EXPECT_EQ(expected.size() + 1, ch05::exportColumns(database).size());
+    EXPECT_EQ(0u, ch05::exportColumns(ch05::SnapshotAccountDatabase{}).size());
+}
+
+TEST(Ch05BalanceAnalytics, TotalsEveryBalance) {
+    for (const size_t size: {0, 1, 5, 4099}) {
+        const auto columns = randomColumns(size, 1);
+        const auto expected = std::accumulate(columns.amounts.begin(), columns.amounts.end(), 0LL);
+
+        for (const auto threadCount: THREAD_COUNTS) {
+            EXPECT_EQ(expected, ch05::BalanceAnalytics(columns, threadCount).getTotal())
+                                << size << " balances, " << threadCount << " threads";
+        }
+    }
+}
+
+TEST(Ch05BalanceAnalytics, FindsTheRange) {
+    const auto empty = makeColumns({});
+    const auto emptyRange = ch05::BalanceAnalytics(empty, 2).getRange();
+    EXPECT_EQ(0, emptyRange.min);
+    EXPECT_EQ(0, emptyRange.max);
+
+    auto columns = randomColumns(1000, 2);
+    columns.amounts[17] = std::numeric_limits<long long>::min();
+    columns.amounts[998] = std::numeric_limits<long long>::max();
+
+    for (const auto threadCount: THREAD_COUNTS) {
+        const auto range = ch05::BalanceAnalytics(columns, threadCount).getRange();
+        EXPECT_EQ(std::numeric_limits<long long>::min(), range.min);
+        EXPECT_EQ(std::numeric_limits<long long>::max(), range.max);
+    }
+
+    const auto single = makeColumns({-42});
+    const auto singleRange = ch05::BalanceAnalytics(single, 8).getRange();
+    EXPECT_EQ(-42, singleRange.min);
+    EXPECT_EQ(-42, singleRange.max);
+}
+
+TEST(Ch05BalanceAnalytics, TopKMatchesASortedCopy) {
+    auto columns = randomColumns(5000, 3);
+    // many ties, spread over every thread's chunk
+    for (size_t i{}; i < columns.size(); i += 7) {
+        columns.amounts[i] = 1'000'000'000'000;
+    }
+
+    std::vector<ch05::AccountBalance> sorted{};
+    for (size_t i{}; i < columns.size(); i++) {
+        sorted.push_back(ch05::AccountBalance{columns.accounts[i], columns.amounts[i]});
+    }
+    std::sort(sorted.begin(), sorted.end(), [](const auto &left, const auto &right) {
+        return left.amount != right.amount ? left.amount > right.amount : left.account < right.account;
+    });
+
+    for (const auto threadCount: THREAD_COUNTS) {
+        const ch05::BalanceAnalytics analytics{columns, threadCount};
+        EXPECT_TRUE(analytics.getTopK(0).empty());
+
+        for (const size_t k: {1, 10, 500, 5000, 6000}) {
+            const auto top = analytics.getTopK(k);
+            const std::vector<ch05::AccountBalance> expected{
+                    sorted.begin(), sorted.begin() + static_cast<std::ptrdiff_t>(std::min(k, sorted.size()))};
+            EXPECT_EQ(expected, top) << "k " << k << ", " << threadCount << " threads";
+        }
+    }
+}
+
+TEST(Ch05BalanceAnalytics, TopKBreaksTiesByAccount) {
+    ch05::BalanceColumns columns{};
+    columns.accounts = {9, 4, 7, 1, 8, 3};
+    columns.amounts = {5, 5, 5, 2, 5, 5};
+
+    for (const auto threadCount: THREAD_COUNTS) {
+        const auto top = ch05::BalanceAnalytics(columns, threadCount).getTopK(3);
+        const std::vector<ch05::AccountBalance> expected{{3, 5}, {4, 5}, {7, 5}};
+        EXPECT_EQ(expected, top) << threadCount << " threads";
+    }
+}
+
+TEST(Ch05BalanceAnalytics, HistogramBucketsIncludeTheirLowerBound) {
+    const auto columns = makeColumns({-1, 0, 9, 10, 99, 100, 1000});
+    const long long bounds[]{0, 10, 100};
+
+    for (const auto threadCount: THREAD_COUNTS) {
+        const auto histogram = ch05::BalanceAnalytics(columns, threadCount).getHistogram(bounds);
+        const std::vector<unsigned long long> expected{1, 2, 2, 2};
+        EXPECT_EQ(expected, histogram) << threadCount << " threads";
+    }
+}
+
+TEST(Ch05BalanceAnalytics, HistogramEdgeCases) {
+    const auto columns = makeColumns({3, 5, 5, 7});
+    const ch05::BalanceAnalytics analytics{columns, 3};
+
+    // no bounds: one bucket with everything
+    EXPECT_EQ(std::vector<unsigned long long>{4}, analytics.getHistogram({}));
+
+    // a repeated bound makes an empty bucket [5, 5)
+    const long long repeated[]{5, 5};
+    EXPECT_EQ((std::vector<unsigned long long>{1, 0, 3}), analytics.getHistogram(repeated));
+
+    const long long unsorted[]{10, 0};
+    EXPECT_THROW(static_cast<void>(analytics.getHistogram(unsorted)), std::invalid_argument);
+}
+
+TEST(Ch05BalanceAnalytics, QuantilesAreWithinTheErrorBound) {
+    const auto columns = randomColumns(20'000, 4);
+    auto sorted = columns.amounts;
+    std::sort(sorted.begin(), sorted.end());
+
+    for (const auto threadCount: THREAD_COUNTS) {
+        const auto sketch = ch05::BalanceAnalytics(columns, threadCount).getQuantiles();
+        ASSERT_EQ(sorted.size(), sketch.getCount());
+
+        for (const double q: {0.0, 0.001, 0.1, 0.25, 0.5, 0.75, 0.9, 0.99, 0.999, 1.0}) {
+            const auto exact = sorted[static_cast<size_t>(q * static_cast<double>(sorted.size() - 1))];
+            const auto estimate = sketch.quantile(q);
+
+            // the middle of a bucket is at most 1/128 of the bucket's smallest magnitude away from any amount
+            // in it, and amounts below 128 in magnitude are exact
+            EXPECT_LE(std::llabs(estimate - exact), std::llabs(exact) / 128)
+                                << "q " << q << ", exact " << exact << ", estimate " << estimate;
+        }
+    }
+}
+
+TEST(Ch05BalanceAnalytics, QuantileSketchHandlesExtremes) {
+    ch05::QuantileSketch sketch{};
+    EXPECT_THROW(static_cast<void>(sketch.quantile(0.5)), std::logic_error);
+
+    sketch.add(std::numeric_limits<long long>::min());
+    sketch.add(0);
+    sketch.add(std::numeric_limits<long long>::max());
+
+    EXPECT_EQ(std::numeric_limits<long long>::min(), sketch.quantile(0.0));
+    EXPECT_EQ(0, sketch.quantile(0.5));
+    EXPECT_GE(sketch.quantile(1.0), std::numeric_limits<long long>::max() / 128 * 127);
+    EXPECT_THROW(static_cast<void>(sketch.quantile(1.5)), std::invalid_argument);
+}
@@ -0,0 +1,343 @@
+#ifndef CPPCRASHCOURSE_CH05_BALANCE_ANALYTICS_H
+#define CPPCRASHCOURSE_CH05_BALANCE_ANALYTICS_H
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "ch05.h"
+#include "ch05-snapshot-account-database.h"
+
+namespace ch05 {
+    // The balances as two parallel arrays, so a reduction streams through contiguous amounts without touching
+    // account numbers, nodes or virtual calls.
+    struct BalanceColumns {
+        std::vector<long> accounts;
+        std::vector<long long> amounts;
+
+        [[nodiscard]] size_t size() const {
+            return this->amounts.size();
+        }
+    };
+
+    // Copies a snapshot into columns while writers keep going on the database it came from.
+    inline BalanceColumns exportColumns(const AccountSnapshot &snapshot) {
+        BalanceColumns columns{};
+        columns.accounts.reserve(snapshot.getSize());
+        columns.amounts.reserve(snapshot.getSize());
+
+        snapshot.forEach([&columns](const long account, const long long amount) {
+            columns.accounts.push_back(account);
+            columns.amounts.push_back(amount);
+        });
+
+        return columns;
+    }
+
+    inline BalanceColumns exportColumns(const SnapshotAccountDatabase &database) {
+        return exportColumns(database.snapshot());
+    }
+
+    // Approximate quantiles in constant memory: every amount lands in a bucket at most 1/64 of its lower bound
+    // wide, and amounts below 128 in magnitude are kept exactly. Sketches built on different threads add
+    // up with merge(), which is what makes them cheap to build in parallel.
+    class QuantileSketch {
+    public:
+        QuantileSketch() : negative(BUCKET_COUNT), positive(BUCKET_COUNT) {}
+
+        void add(const long long amount) {
+            if (amount < 0) {
+                // through unsigned, so the magnitude of the smallest long long does not overflow
+                this->negative[bucket(0 - static_cast<unsigned long long>(amount))]++;
+            } else {
+                this->positive[bucket(static_cast<unsigned long long>(amount))]++;
+            }
+            this->count++;
+        }
+
+        void merge(const QuantileSketch &other) {
+            for (size_t i{}; i < BUCKET_COUNT; i++) {
+                this->negative[i] += other.negative[i];
+                this->positive[i] += other.positive[i];
+            }
+            this->count += other.count;
+        }
+
+        // the amount with a fraction q of all amounts below it, 0 <= q <= 1
+        [[nodiscard]] long long quantile(const double q) const {
+            if (this->count == 0) {
+                throw std::logic_error{"quantile of an empty sketch"};
+            }
+            if (!(q >= 0.0 && q <= 1.0)) {
+                throw std::invalid_argument{"quantile " + std::to_string(q) + " is not between 0 and 1"};
+            }
+
+            auto rank = static_cast<unsigned long long>(q * static_cast<double>(this->count - 1));
+
+            // the most negative amounts first: the negative buckets from the largest magnitude down
+            for (size_t i = BUCKET_COUNT; i-- > 0;) {
+                if (rank < this->negative[i]) {
+                    return negate(middle(i));
+                }
+                rank -= this->negative[i];
+            }
+
+            for (size_t i{}; i < BUCKET_COUNT; i++) {
+                if (rank < this->positive[i]) {
+                    return static_cast<long long>(middle(i));
+                }
+                rank -= this->positive[i];
+            }
+
+            return static_cast<long long>(middle(BUCKET_COUNT - 1));
+        }
+
+        [[nodiscard]] unsigned long long getCount() const {
+            return this->count;
+        }
+
+    private:
+        // six bits below the leading one, 64 buckets for each power of two
+        static constexpr unsigned SUB_BITS = 6;
+        static constexpr unsigned long long EXACT = 1ull << (SUB_BITS + 1);
+        static constexpr size_t BUCKET_COUNT = (64 - SUB_BITS + 1) << SUB_BITS;
+
+        std::vector<unsigned long long> negative;
+        std::vector<unsigned long long> positive;
+        unsigned long long count{};
+
+        static size_t bucket(const unsigned long long magnitude) {
+            if (magnitude < EXACT) {
+                return static_cast<size_t>(magnitude);
+            }
+
+            const auto shift = static_cast<unsigned>(std::bit_width(magnitude)) - 1 - SUB_BITS;
+            return ((shift + 1) << SUB_BITS) + static_cast<size_t>((magnitude >> shift) - (1ull << SUB_BITS));
+        }
+
+        // the only magnitude beyond the largest long long is that of the smallest one
+        static long long negate(const unsigned long long magnitude) {
+            if (magnitude > static_cast<unsigned long long>(std::numeric_limits<long long>::max())) {
+                return std::numeric_limits<long long>::min();
+            }
+
+            return -static_cast<long long>(magnitude);
+        }
+
+        // the middle of the magnitudes that fall into bucket i
+        static unsigned long long middle(const size_t i) {
+            if (i < EXACT) {
+                return i;
+            }
+
+            const auto shift = static_cast<unsigned>(i >> SUB_BITS) - 1;
+            const auto lowest = ((i & ((1ull << SUB_BITS) - 1)) + (1ull << SUB_BITS)) << shift;
+            return lowest + ((1ull << shift) - 1) / 2;
+        }
+    };
+
+    // Reductions over exported columns, each split into one contiguous chunk per thread with the partial
+    // results merged at the end. The inner loops are plain loops over arrays of long long that the compiler
+    // can vectorize.
+    class BalanceAnalytics {
+    public:
+        explicit BalanceAnalytics(const BalanceColumns &columns,
+                                  const size_t threadCount = std::thread::hardware_concurrency())
+                : columns{columns}, threadCount{std::max<size_t>(threadCount, 1)} {
+            if (columns.accounts.size() != columns.amounts.size()) {
+                throw std::invalid_argument{"account and amount columns differ in length"};
+            }
+        }
+
+        // the analytics only refer to the columns, which a temporary would not outlive
+        BalanceAnalytics(const BalanceColumns &&, size_t = 0) = delete;
+
+        [[nodiscard]] long long getTotal() const {
+            std::vector<Partial<long long>> sums(this->threadCount);
+            this->forEachChunk([&sums](const std::span<const long long> amounts, size_t, const size_t thread) {
+                // four independent sums, so the additions do not wait for each other
+                long long sum[4]{};
+                size_t i{};
+                for (; i + 4 <= amounts.size(); i += 4) {
+                    sum[0] += amounts[i];
+                    sum[1] += amounts[i + 1];
+                    sum[2] += amounts[i + 2];
+                    sum[3] += amounts[i + 3];
+                }
+                for (; i < amounts.size(); i++) {
+                    sum[0] += amounts[i];
+                }
+
+                sums[thread].value = sum[0] + sum[1] + sum[2] + sum[3];
+            });
+
+            long long total{};
+            for (const auto &sum: sums) {
+                total += sum.value;
+            }
+
+            return total;
+        }
+
+        struct Range {
+            long long min;
+            long long max;
+        };
+
+        // the smallest and largest balance; {0, 0} without accounts
+        [[nodiscard]] Range getRange() const {
+            if (this->columns.size() == 0) {
+                return Range{};
+            }
+
+            std::vector<Partial<Range>> ranges(this->threadCount, Partial<Range>{Range{
+                    std::numeric_limits<long long>::max(), std::numeric_limits<long long>::min()}});
+            this->forEachChunk([&ranges](const std::span<const long long> amounts, size_t, const size_t thread) {
+                auto min = std::numeric_limits<long long>::max();
+                auto max = std::numeric_limits<long long>::min();
+                for (const auto amount: amounts) {
+                    min = amount < min ? amount : min;
+                    max = amount > max ? amount : max;
+                }
+
+                ranges[thread].value = Range{min, max};
+            });
+
+            auto range = ranges.front().value;
+            for (const auto &partial: ranges) {
+                range.min = std::min(range.min, partial.value.min);
+                range.max = std::max(range.max, partial.value.max);
+            }
+
+            return range;
+        }
+
+        // The k largest balances, largest first and ties by account. Every thread keeps a min-heap of its k
+        // best, so most amounts cost one comparison with the smallest of those.
+        [[nodiscard]] std::vector<AccountBalance> getTopK(const size_t k) const {
+            if (k == 0) {
+                return {};
+            }
+
+            std::vector<std::vector<AccountBalance>> heaps(this->threadCount);
+            this->forEachChunk([this, k, &heaps](const std::span<const long long> amounts, const size_t offset,
+                                                 const size_t thread) {
+                auto &heap = heaps[thread];
+                heap.reserve(std::min(k, amounts.size()));
+
+                for (size_t i{}; i < amounts.size(); i++) {
+                    const AccountBalance balance{this->columns.accounts[offset + i], amounts[i]};
+                    if (heap.size() < k) {
+                        heap.push_back(balance);
+                        std::push_heap(heap.begin(), heap.end(), ranksHigher);
+                    } else if (ranksHigher(balance, heap.front())) {
+                        std::pop_heap(heap.begin(), heap.end(), ranksHigher);
+                        heap.back() = balance;
+                        std::push_heap(heap.begin(), heap.end(), ranksHigher);
+                    }
+                }
+            });
+
+            std::vector<AccountBalance> top{};
+            for (const auto &heap: heaps) {
+                top.insert(top.end(), heap.begin(), heap.end());
+            }
+
+            const auto count = std::min(k, top.size());
+            std::partial_sort(top.begin(), top.begin() + static_cast<std::ptrdiff_t>(count), top.end(), ranksHigher);
+            top.resize(count);
+
+            return top;
+        }
+
+        [[nodiscard]] QuantileSketch getQuantiles() const {
+            std::vector<QuantileSketch> sketches(this->threadCount);
+            this->forEachChunk([&sketches](const std::span<const long long> amounts, size_t, const size_t thread) {
+                for (const auto amount: amounts) {
+                    sketches[thread].add(amount);
+                }
+            });
+
+            for (size_t thread{1}; thread < sketches.size(); thread++) {
+                sketches.front().merge(sketches[thread]);
+            }
+
+            return std::move(sketches.front());
+        }
+
+        // Counts the balances below bounds[0], then those in [bounds[i - 1], bounds[i]), then those from
+        // bounds.back() on; bounds must be sorted.
+        [[nodiscard]] std::vector<unsigned long long> getHistogram(const std::span<const long long> bounds) const {
+            if (!std::is_sorted(bounds.begin(), bounds.end())) {
+                throw std::invalid_argument{"histogram bounds are not sorted"};
+            }
+
+            std::vector<std::vector<unsigned long long>> counts(this->threadCount);
+            this->forEachChunk([&counts, bounds](const std::span<const long long> amounts, size_t,
+                                                 const size_t thread) {
+                auto &bucketCounts = counts[thread];
+                bucketCounts.assign(bounds.size() + 1, 0);
+
+                for (const auto amount: amounts) {
+                    bucketCounts[static_cast<size_t>(
+                            std::upper_bound(bounds.begin(), bounds.end(), amount) - bounds.begin())]++;
+                }
+            });
+
+            std::vector<unsigned long long> histogram(bounds.size() + 1);
+            for (const auto &bucketCounts: counts) {
+                for (size_t i{}; i < bucketCounts.size(); i++) {
+                    histogram[i] += bucketCounts[i];
+                }
+            }
+
+            return histogram;
+        }
+
+    private:
+        // one cache line per thread, so threads writing their results do not share lines
+        template<typename T>
+        struct alignas(64) Partial {
+            T value;
+        };
+
+        const BalanceColumns &columns;
+        size_t threadCount;
+
+        static bool ranksHigher(const AccountBalance &left, const AccountBalance &right) {
+            return left.amount != right.amount ? left.amount > right.amount : left.account < right.account;
+        }
+
+        // task(amounts, offset, thread) for one contiguous chunk per thread, the calling thread taking the first
+        template<typename Task>
+        void forEachChunk(Task &&task) const {
+            const std::span<const long long> amounts{this->columns.amounts};
+            const auto chunk = (amounts.size() + this->threadCount - 1) / this->threadCount;
+
+            const auto run = [&amounts, &task, chunk](const size_t thread) {
+                const auto begin = std::min(thread * chunk, amounts.size());
+                const auto end = std::min(begin + chunk, amounts.size());
+                task(amounts.subspan(begin, end - begin), begin, thread);
+            };
+
+            std::vector<std::thread> threads{};
+            for (size_t thread{1}; thread < this->threadCount; thread++) {
+                threads.emplace_back(run, thread);
+            }
+            run(0);
+
+            for (auto &thread: threads) {
+                thread.join();
+            }
+        }
+    };
+}
+
+#endif //CPPCRASHCOURSE_CH05_BALANCE_ANALYTICS_H
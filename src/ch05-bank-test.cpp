@@ -0,0 +1,215 @@
+#include <climits>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "ch05.h"
+#include "ch05-snapshot-account-database.h"
+
+namespace {
+    // the balances after applying every transfer on its own, for comparing with what a batch nets them down to
+    std::map<long, long long> applyOneByOne(const std::vector<ch05::Transfer> &transfers) {
+        std::map<long, long long> balances{};
+        for (const auto &transfer: transfers) {
+            balances[transfer.fromAccount] -= transfer.amount;
+            balances[transfer.toAccount] += transfer.amount;
+        }
+
+        return balances;
+    }
+
+    // every account the database holds, including those a batch created at a net of zero
+    std::map<long, long long> collect(const ch05::SnapshotAccountDatabase &database) {
+        std::map<long, long long> balances{};
+        database.snapshot().forEach([&balances](const long account, const long long amount) {
+            balances[account] = amount;
+        });
+
+        return balances;
+    }
+
+    // transfers between accounts of either sign, from a few hundred dense ones to the extremes of long
+    std::vector<ch05::Transfer> randomTransfers(const size_t count, const unsigned seed) {
+        std::mt19937_64 random{seed};
+        const auto account = [&random] {
+            switch (random() % 4) {
+                case 0:
+                    return LONG_MIN + static_cast<long>(random() % 4);
+                case 1:
+                    return LONG_MAX - static_cast<long>(random() % 4);
+                default:
+                    return static_cast<long>(random() % 512) - 256;
+            }
+        };
+
+        std::vector<ch05::Transfer> transfers(count);
+        for (auto &transfer: transfers) {
+            transfer = ch05::Transfer{account(), account(), static_cast<long long>(random() % 1000)};
+        }
+
+        return transfers;
+    }
+
+    // Counts how often the stream is flushed.
+    class SyncCountingBuffer : public std::stringbuf {
+    public:
+        int syncs{};
+
+    protected:
+        int sync() override {
+            this->syncs++;
+            return std::stringbuf::sync();
+        }
+    };
+}
+
+TEST(Ch05Bank, TransferMovesTheAmount) {
+    ch05::InMemoryAccountDatabase database{};
+    database.setAmount(1, 100);
+    ch05::Bank bank{database};
+
+    bank.transfer(1, 2, 30);
+
+    EXPECT_EQ(70, database.getAmount(1));
+    EXPECT_EQ(30, database.getAmount(2));
+}
+
+TEST(Ch05Bank, SmallBatchesNetLikeSingleTransfers) {
+    for (const size_t count: {0, 1, 2, 100, 511}) {
+        ch05::SnapshotAccountDatabase database{};
+        ch05::Bank bank{database};
+        const auto transfers = randomTransfers(count, static_cast<unsigned>(count));
+
+        bank.transferBatch(transfers);
+
+        EXPECT_EQ(applyOneByOne(transfers), collect(database)) << count << " transfers";
+    }
+}
+
+TEST(Ch05Bank, LargeBatchesNetLikeSingleTransfers) {
+    // from 1024 deltas on, the batch is sorted by radix; negative accounts and the extremes of long exercise
+    // every byte of the keys, including the sign
+    for (const size_t count: {512, 1024, 5000}) {
+        ch05::SnapshotAccountDatabase database{};
+        database.setAmount(-3, 1'000'000);
+        ch05::Bank bank{database};
+        const auto transfers = randomTransfers(count, 7);
+
+        bank.transferBatch(transfers);
+
+        auto expected = applyOneByOne(transfers);
+        expected[-3] += 1'000'000;
+        EXPECT_EQ(expected, collect(database)) << count << " transfers";
+    }
+}
+
+TEST(Ch05Bank, LargeBatchOfDenseAccountsSkipsCommonBytes) {
+    // every account fits the lowest byte, so all but one radix pass is skipped
+    std::vector<ch05::Transfer> transfers{};
+    for (long i{}; i < 2000; i++) {
+        transfers.push_back(ch05::Transfer{i % 200, (i * 7) % 200, i});
+    }
+
+    ch05::SnapshotAccountDatabase database{};
+    ch05::Bank{database}.transferBatch(transfers);
+
+    EXPECT_EQ(applyOneByOne(transfers), collect(database));
+}
+
+TEST(Ch05Bank, RepeatedAndSelfTransfers) {
+    ch05::SnapshotAccountDatabase database{};
+    database.setAmount(-5, 100);
+    ch05::Bank bank{database};
+
+    const std::vector<ch05::Transfer> transfers{
+            {-5, 8, 10}, {-5, 8, 10}, {8, -5, 5}, {-5, -5, 1000}, {9, 9, 7}, {-5, 8, 10},
+    };
+    bank.transferBatch(transfers);
+
+    EXPECT_EQ(75, database.getAmount(-5));
+    EXPECT_EQ(25, database.getAmount(8));
+    EXPECT_EQ(0, database.getAmount(9));
+    EXPECT_EQ(3u, database.snapshot().getSize());
+}
+
+TEST(Ch05Bank, NegativeAccounts) {
+    ch05::InMemoryAccountDatabase database{};
+    ch05::Bank bank{database};
+
+    const std::vector<ch05::Transfer> transfers{{-1, 1, 50}, {1, LONG_MIN, 20}, {LONG_MIN, -1, 5}, {-2, -1, 1}};
+    bank.transferBatch(transfers);
+
+    EXPECT_EQ(-44, database.getAmount(-1));
+    EXPECT_EQ(30, database.getAmount(1));
+    EXPECT_EQ(15, database.getAmount(LONG_MIN));
+    EXPECT_EQ(-1, database.getAmount(-2));
+}
+
+TEST(Ch05Bank, ConsoleLoggerFlushesOncePerBatch) {
+    SyncCountingBuffer buffer{};
+    auto *const original = std::cout.rdbuf(&buffer);
+
+    ch05::InMemoryAccountDatabase database{};
+    ch05::ConsoleLogger logger{"bank"};
+    ch05::Bank bank{database};
+    bank.setLogger(&logger);
+
+    bank.transferBatch(std::vector<ch05::Transfer>{{1, 2, 3}, {2, 3, 4}, {3, 1, 5}});
+    const auto batchSyncs = buffer.syncs;
+    bank.transfer(1, 2, 6);
+    const auto transferSyncs = buffer.syncs - batchSyncs;
+
+    std::cout.rdbuf(original);
+
+    EXPECT_EQ(1, batchSyncs);
+    EXPECT_EQ(1, transferSyncs);
+    EXPECT_EQ("bank: transfer from account: 1 to account: 2 amount: 3\n"
+              "bank: transfer from account: 2 to account: 3 amount: 4\n"
+              "bank: transfer from account: 3 to account: 1 amount: 5\n"
+              "bank: transfer from account: 1 to account: 2 amount: 6\n", buffer.str());
+}
+
+TEST(Ch05Bank, OneBankTakesBatchesFromManyThreads) {
+    constexpr long accountCount{4096};
+    ch05::SnapshotAccountDatabase shared{};
+    ch05::SnapshotAccountDatabase expected{};
+    ch05::Bank bank{shared};
+
+    // small batches take the sort, large ones the radix sort, and every thread nets its own at the same time
+    std::vector<std::vector<ch05::Transfer>> batches{};
+    std::mt19937_64 random{5};
+    for (int i{}; i < 64; i++) {
+        std::vector<ch05::Transfer> batch(i % 2 == 0 ? 100 : 2000);
+        for (auto &transfer: batch) {
+            transfer = ch05::Transfer{static_cast<long>(random() % accountCount) - accountCount / 2,
+                                      static_cast<long>(random() % accountCount), static_cast<long long>(random() % 50)};
+        }
+        ch05::Bank{expected}.transferBatch(batch);
+        batches.push_back(std::move(batch));
+    }
+
+    std::vector<std::thread> threads{};
+    for (size_t thread{}; thread < 4; thread++) {
+        threads.emplace_back([&bank, &batches, thread] {
+            for (auto i = thread; i < batches.size(); i += 4) {
+                bank.transferBatch(batches[i]);
+            }
+        });
+    }
+    for (auto &thread: threads) {
+        thread.join();
+    }
+
+    const auto actual = shared.snapshot();
+    EXPECT_EQ(0, actual.getTotal(1));
+    EXPECT_EQ(expected.snapshot().getSize(), actual.getSize());
+    expected.snapshot().forEach([&actual](const long account, const long long amount) {
+        EXPECT_EQ(amount, actual.getAmount(account)) << "account " << account;
+    });
+}
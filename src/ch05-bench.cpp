@@ -0,0 +1,729 @@
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <malloc.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <benchmark/benchmark.h>
+
+#include "ch05.h"
+#include "ch05-async-logger.h"
+#include "ch05-balance-analytics.h"
+#include "ch05-flat-account-database.h"
+#include "ch05-mmap-account-database.h"
+#include "ch05-optimistic-account-database.h"
+#include "ch05-sharded-account-database.h"
+#include "ch05-snapshot-account-database.h"
+#include "ch05-transfer-journal.h"
+
+namespace {
+    constexpr long ACCOUNT_COUNT = 1 << 20;
+    constexpr size_t SAMPLE_COUNT = 1 << 16;
+
+    enum class Distribution {
+        Uniform,
+        Zipf,
+    };
+
+    std::vector<long> sampleAccounts(const Distribution distribution, const unsigned seed) {
+        std::mt19937_64 random{seed};
+        std::vector<long> accounts(SAMPLE_COUNT);
+
+        if (distribution == Distribution::Uniform) {
+            std::uniform_int_distribution<long> uniform{0, ACCOUNT_COUNT - 1};
+            for (auto &account: accounts) {
+                account = uniform(random);
+            }
+
+            return accounts;
+        }
+
+        // zipf with s = 1 by inverting the cumulative weights, built once and shared between threads
+        static const std::vector<double> cumulative = [] {
+            std::vector<double> weights(ACCOUNT_COUNT);
+            double sum{};
+            for (long i{}; i < ACCOUNT_COUNT; i++) {
+                sum += 1.0 / static_cast<double>(i + 1);
+                weights[i] = sum;
+            }
+            return weights;
+        }();
+
+        std::uniform_real_distribution<double> uniform{0.0, cumulative.back()};
+        for (auto &account: accounts) {
+            auto it = std::lower_bound(cumulative.begin(), cumulative.end(), uniform(random));
+            account = static_cast<long>(it - cumulative.begin());
+        }
+
+        return accounts;
+    }
+
+    template<typename Database>
+    void fill(Database &database) {
+        for (long account{}; account < ACCOUNT_COUNT; account++) {
+            database.setAmount(account, 1000);
+        }
+    }
+
+    void BM_InMemoryBankTransfer(benchmark::State &state, const Distribution distribution) {
+        ch05::InMemoryAccountDatabase database;
+        fill(database);
+        ch05::Bank bank{database};
+
+        auto accounts = sampleAccounts(distribution, 1);
+        size_t i{};
+
+        for (auto _: state) {
+            bank.transfer(accounts[i % SAMPLE_COUNT], accounts[(i + 1) % SAMPLE_COUNT], 1);
+            i++;
+        }
+
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    std::vector<ch05::Transfer> sampleTransfers(const size_t count) {
+        auto accounts = sampleAccounts(Distribution::Uniform, 1);
+        std::vector<ch05::Transfer> transfers(count);
+
+        for (size_t i{}; i < count; i++) {
+            transfers[i] = ch05::Transfer{accounts[i % SAMPLE_COUNT], accounts[(i + 1) % SAMPLE_COUNT], 1};
+        }
+
+        return transfers;
+    }
+
+    void BM_BankTransferPerCall(benchmark::State &state) {
+        ch05::InMemoryAccountDatabase database;
+        fill(database);
+        ch05::Bank bank{database};
+
+        auto transfers = sampleTransfers(static_cast<size_t>(state.range(0)));
+
+        for (auto _: state) {
+            for (const auto &transfer: transfers) {
+                bank.transfer(transfer.fromAccount, transfer.toAccount, transfer.amount);
+            }
+        }
+
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+
+    void BM_BankTransferBatch(benchmark::State &state) {
+        ch05::InMemoryAccountDatabase database;
+        fill(database);
+        ch05::Bank bank{database};
+
+        auto transfers = sampleTransfers(static_cast<size_t>(state.range(0)));
+
+        for (auto _: state) {
+            bank.transferBatch(transfers);
+        }
+
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+
+    // times every call separately, so the tail latency of a logger flushing on the hot path shows up
+    void measureTransferLatency(benchmark::State &state, ch05::Logger *logger) {
+        ch05::InMemoryAccountDatabase database;
+        fill(database);
+        ch05::Bank bank{database};
+        bank.setLogger(logger);
+
+        auto accounts = sampleAccounts(Distribution::Uniform, 1);
+        std::vector<long long> latencies;
+        latencies.reserve(1 << 20);
+        size_t i{};
+
+        for (auto _: state) {
+            const auto start = std::chrono::steady_clock::now();
+            bank.transfer(accounts[i % SAMPLE_COUNT], accounts[(i + 1) % SAMPLE_COUNT], 1);
+            const auto end = std::chrono::steady_clock::now();
+
+            if (latencies.size() < latencies.capacity()) {
+                latencies.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+            }
+            i++;
+        }
+
+        std::sort(latencies.begin(), latencies.end());
+        state.counters["p50_ns"] = static_cast<double>(latencies[latencies.size() / 2]);
+        state.counters["p99_ns"] = static_cast<double>(latencies[latencies.size() * 99 / 100]);
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    void BM_BankTransferLatencyNoLogger(benchmark::State &state) {
+        measureTransferLatency(state, nullptr);
+    }
+
+    void BM_BankTransferLatencyConsoleLogger(benchmark::State &state) {
+        std::ofstream devNull{"/dev/null"};
+        auto *previous = std::cout.rdbuf(devNull.rdbuf());
+
+        ch05::ConsoleLogger logger{"consoleLogger"};
+        measureTransferLatency(state, &logger);
+
+        std::cout.rdbuf(previous);
+    }
+
+    void BM_BankTransferLatencyAsyncLogger(benchmark::State &state, const ch05::OverflowPolicy overflowPolicy) {
+        std::ofstream devNull{"/dev/null"};
+
+        ch05::AsyncLogger logger{"asyncLogger", devNull, 1 << 16, overflowPolicy};
+        measureTransferLatency(state, &logger);
+        logger.flush();
+
+        state.counters["overflows"] = static_cast<double>(logger.getOverflowCount());
+    }
+
+    double residentSetBytes() {
+        std::ifstream statm{"/proc/self/statm"};
+        long long pages{}, residentPages{};
+        statm >> pages >> residentPages;
+
+        return static_cast<double>(residentPages * sysconf(_SC_PAGESIZE));
+    }
+
+    // rss_bytes is the growth of the resident set from before the database is created until it is full
+    template<typename Database, typename... Arguments>
+    void measureLookups(benchmark::State &state, Arguments... arguments) {
+        malloc_trim(0);
+
+        const auto accountCount = state.range(0);
+        const auto before = residentSetBytes();
+
+        Database database{arguments...};
+        for (long account{}; account < accountCount; account++) {
+            database.setAmount(account * 7919, account);
+        }
+
+        state.counters["rss_bytes"] = residentSetBytes() - before;
+
+        std::mt19937_64 random{1};
+        std::uniform_int_distribution<long> uniform{0, accountCount - 1};
+        std::vector<long> accounts(SAMPLE_COUNT);
+        for (auto &account: accounts) {
+            account = uniform(random) * 7919;
+        }
+
+        size_t i{};
+        for (auto _: state) {
+            benchmark::DoNotOptimize(database.getAmount(accounts[i++ % SAMPLE_COUNT]));
+        }
+
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    void BM_InMemoryLookup(benchmark::State &state) {
+        measureLookups<ch05::InMemoryAccountDatabase>(state);
+    }
+
+    void BM_SnapshotLookup(benchmark::State &state) {
+        measureLookups<ch05::SnapshotAccountDatabase>(state);
+    }
+
+    void BM_FlatLookup(benchmark::State &state) {
+        measureLookups<ch05::FlatAccountDatabase>(state);
+    }
+
+    void BM_FlatLookupReserved(benchmark::State &state) {
+        measureLookups<ch05::FlatAccountDatabase>(state, static_cast<size_t>(state.range(0)));
+    }
+
+    std::string mmapDatabasePath() {
+        return (std::filesystem::temp_directory_path() / "ch05-bench.db").string();
+    }
+
+    void removeMmapDatabase() {
+        std::filesystem::remove(mmapDatabasePath());
+        std::filesystem::remove(mmapDatabasePath() + ".wal");
+    }
+
+    void BM_MmapColdOpen(benchmark::State &state) {
+        removeMmapDatabase();
+        {
+            ch05::MmapAccountDatabase database{mmapDatabasePath(), 2 * ACCOUNT_COUNT, 1 << 16};
+            fill(database);
+        }
+
+        for (auto _: state) {
+            ch05::MmapAccountDatabase database{mmapDatabasePath()};
+            benchmark::DoNotOptimize(database.getAmount(ACCOUNT_COUNT / 2));
+        }
+
+        removeMmapDatabase();
+    }
+
+    void BM_MmapTransfer(benchmark::State &state) {
+        removeMmapDatabase();
+        {
+            ch05::MmapAccountDatabase database{mmapDatabasePath(), 2 * ACCOUNT_COUNT, static_cast<size_t>(state.range(0))};
+            fill(database);
+            ch05::Bank bank{database};
+
+            auto accounts = sampleAccounts(Distribution::Uniform, 1);
+            size_t i{};
+
+            for (auto _: state) {
+                bank.transfer(accounts[i % SAMPLE_COUNT], accounts[(i + 1) % SAMPLE_COUNT], 1);
+                i++;
+            }
+
+            state.SetItemsProcessed(state.iterations());
+        }
+        removeMmapDatabase();
+    }
+
+    // the child process commits the transfers and dies without a checkpoint, the open replays its log
+    void BM_MmapRecovery(benchmark::State &state) {
+        removeMmapDatabase();
+        {
+            ch05::MmapAccountDatabase database{mmapDatabasePath(), 2 * ACCOUNT_COUNT, 1 << 16};
+            fill(database);
+        }
+
+        auto accounts = sampleAccounts(Distribution::Uniform, 1);
+
+        for (auto _: state) {
+            state.PauseTiming();
+            const auto child = fork();
+            if (child == 0) {
+                ch05::MmapAccountDatabase database{mmapDatabasePath(), 2 * ACCOUNT_COUNT, 1 << 10, 1ull << 40};
+                for (long i{}; i < state.range(0); i++) {
+                    database.transfer(accounts[i % SAMPLE_COUNT], accounts[(i + 1) % SAMPLE_COUNT], 1);
+                }
+                database.sync();
+                _exit(0);
+            }
+            waitpid(child, nullptr, 0);
+            state.ResumeTiming();
+
+            ch05::MmapAccountDatabase database{mmapDatabasePath()};
+            benchmark::DoNotOptimize(database.getAmount(ACCOUNT_COUNT / 2));
+        }
+
+        removeMmapDatabase();
+    }
+
+    ch05::ShardedAccountDatabase &shardedDatabase() {
+        static ch05::ShardedAccountDatabase database = [] {
+            ch05::ShardedAccountDatabase database{};
+            fill(database);
+            return database;
+        }();
+
+        return database;
+    }
+
+    void BM_ShardedBankTransfer(benchmark::State &state, const Distribution distribution) {
+        auto &database = shardedDatabase();
+        ch05::Bank bank{database};
+
+        auto accounts = sampleAccounts(distribution, state.thread_index() + 1);
+        size_t i{};
+
+        for (auto _: state) {
+            bank.transfer(accounts[i % SAMPLE_COUNT], accounts[(i + 1) % SAMPLE_COUNT], 1);
+            i++;
+        }
+
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    // the same dense array of balances as the optimistic database, behind one mutex
+    class MutexBank {
+    public:
+        explicit MutexBank(const size_t accountCount) : amounts(accountCount, 1000) {}
+
+        void transfer(const std::span<const ch05::AccountDelta> legs) {
+            std::lock_guard lock{this->mutex};
+
+            for (const auto &leg: legs) {
+                this->amounts[static_cast<size_t>(leg.account)] += leg.amount;
+            }
+        }
+
+    private:
+        std::mutex mutex;
+        std::vector<long long> amounts;
+    };
+
+    // The next transfer of range(0) legs from the sampled accounts: the first account pays one to each of the
+    // others. Zipf samples put most transfers on a few hot accounts.
+    std::span<const ch05::AccountDelta> nextLegs(const std::vector<long> &accounts, size_t &i,
+                                                 std::vector<ch05::AccountDelta> &legs) {
+        const auto payment = 1 - static_cast<long long>(legs.size());
+        for (size_t leg{}; leg < legs.size(); leg++) {
+            legs[leg] = ch05::AccountDelta{accounts[i++ % SAMPLE_COUNT], leg == 0 ? payment : 1};
+        }
+
+        return legs;
+    }
+
+    ch05::OptimisticAccountDatabase &optimisticDatabase() {
+        static ch05::OptimisticAccountDatabase database = [] {
+            ch05::OptimisticAccountDatabase database{ACCOUNT_COUNT};
+            fill(database);
+            return database;
+        }();
+
+        return database;
+    }
+
+    // the netted batch reaches the database as one addAmounts transaction with up to one leg per account touched
+    void BM_OptimisticBankTransferBatch(benchmark::State &state) {
+        ch05::Bank bank{optimisticDatabase()};
+
+        auto transfers = sampleTransfers(static_cast<size_t>(state.range(0)));
+
+        for (auto _: state) {
+            bank.transferBatch(transfers);
+        }
+
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+
+    void BM_OptimisticTransfer(benchmark::State &state, const Distribution distribution) {
+        auto &database = optimisticDatabase();
+
+        auto accounts = sampleAccounts(distribution, state.thread_index() + 1);
+        std::vector<ch05::AccountDelta> legs(static_cast<size_t>(state.range(0)));
+        size_t i{};
+        unsigned long long attempts{};
+
+        for (auto _: state) {
+            attempts += database.transfer(nextLegs(accounts, i, legs));
+        }
+
+        state.SetItemsProcessed(state.iterations());
+        state.counters["abort_rate"] = benchmark::Counter(
+                static_cast<double>(attempts - state.iterations()) / static_cast<double>(attempts),
+                benchmark::Counter::kAvgThreads);
+    }
+
+    void BM_MutexTransfer(benchmark::State &state, const Distribution distribution) {
+        static MutexBank bank{ACCOUNT_COUNT};
+
+        auto accounts = sampleAccounts(distribution, state.thread_index() + 1);
+        std::vector<ch05::AccountDelta> legs(static_cast<size_t>(state.range(0)));
+        size_t i{};
+
+        for (auto _: state) {
+            bank.transfer(nextLegs(accounts, i, legs));
+        }
+
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    ch05::SnapshotAccountDatabase &snapshotDatabase() {
+        // the database holds a mutex and cannot be moved out of a lambda
+        static ch05::SnapshotAccountDatabase database;
+        static const bool filled = (fill(database), true);
+        (void) filled;
+
+        return database;
+    }
+
+    // a snapshot taken before every transfer, so each transfer also pays for copying the nodes it writes to
+    void BM_SnapshotTransfer(benchmark::State &state) {
+        auto &database = snapshotDatabase();
+        ch05::Bank bank{database};
+
+        auto accounts = sampleAccounts(Distribution::Uniform, 1);
+        size_t i{};
+
+        for (auto _: state) {
+            auto snapshot = database.snapshot();
+            benchmark::DoNotOptimize(snapshot);
+            bank.transfer(accounts[i % SAMPLE_COUNT], accounts[(i + 1) % SAMPLE_COUNT], 1);
+            i++;
+        }
+
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    // Transfer throughput while range(0) threads keep taking snapshots and adding up every balance in them.
+    void BM_SnapshotTransferDuringScan(benchmark::State &state) {
+        auto &database = snapshotDatabase();
+        ch05::Bank bank{database};
+
+        std::atomic<bool> stop{};
+        std::atomic<long> scans{};
+        std::vector<std::thread> scanners{};
+        for (long scanner{}; scanner < state.range(0); scanner++) {
+            scanners.emplace_back([&database, &stop, &scans] {
+                while (!stop.load(std::memory_order_relaxed)) {
+                    benchmark::DoNotOptimize(database.snapshot().getTotal(1));
+                    scans.fetch_add(1, std::memory_order_relaxed);
+                }
+            });
+        }
+
+        auto accounts = sampleAccounts(Distribution::Uniform, 1);
+        size_t i{};
+
+        for (auto _: state) {
+            bank.transfer(accounts[i % SAMPLE_COUNT], accounts[(i + 1) % SAMPLE_COUNT], 1);
+            i++;
+        }
+
+        stop = true;
+        for (auto &scanner: scanners) {
+            scanner.join();
+        }
+
+        state.SetItemsProcessed(state.iterations());
+        state.counters["scans"] = benchmark::Counter(static_cast<double>(scans), benchmark::Counter::kIsRate);
+    }
+
+    void BM_SnapshotTotal(benchmark::State &state) {
+        const auto snapshot = snapshotDatabase().snapshot();
+
+        for (auto _: state) {
+            benchmark::DoNotOptimize(snapshot.getTotal(static_cast<size_t>(state.range(0))));
+        }
+
+        state.SetItemsProcessed(state.iterations() * static_cast<long>(snapshot.getSize()));
+    }
+
+    void BM_ExportColumns(benchmark::State &state) {
+        const auto snapshot = snapshotDatabase().snapshot();
+
+        for (auto _: state) {
+            benchmark::DoNotOptimize(ch05::exportColumns(snapshot));
+        }
+
+        state.SetItemsProcessed(state.iterations() * static_cast<long>(snapshot.getSize()));
+    }
+
+    // range(0) accounts with balances spread over five orders of magnitude, generated directly as columns; only
+    // the latest size is kept, since 100M accounts take 1.6 GB
+    const ch05::BalanceColumns &balanceColumns(const size_t size) {
+        static ch05::BalanceColumns columns{};
+
+        if (columns.size() != size) {
+            columns = ch05::BalanceColumns{};
+            columns.accounts.resize(size);
+            columns.amounts.resize(size);
+
+            std::mt19937_64 random{1};
+            std::lognormal_distribution<double> amounts{7.0, 2.0};
+            for (size_t i{}; i < size; i++) {
+                columns.accounts[i] = static_cast<long>(i);
+                columns.amounts[i] = static_cast<long long>(amounts(random));
+            }
+        }
+
+        return columns;
+    }
+
+    // every reduction over range(0) accounts with range(1) threads
+    void analyticsArguments(benchmark::internal::Benchmark *benchmark) {
+        for (const long size: {1L << 24, 100'000'000L}) {
+            for (long threads{1}; threads <= std::max(4L, static_cast<long>(std::thread::hardware_concurrency()));
+                 threads *= 2) {
+                benchmark->Args({size, threads});
+            }
+        }
+        benchmark->ArgNames({"accounts", "threads"})->Unit(benchmark::kMillisecond)->UseRealTime();
+    }
+
+    template<typename Reduction>
+    void measureAnalytics(benchmark::State &state, Reduction &&reduction) {
+        const auto &columns = balanceColumns(static_cast<size_t>(state.range(0)));
+        const ch05::BalanceAnalytics analytics{columns, static_cast<size_t>(state.range(1))};
+
+        for (auto _: state) {
+            benchmark::DoNotOptimize(reduction(analytics));
+        }
+
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+        state.SetBytesProcessed(state.iterations() * state.range(0) * static_cast<long>(sizeof(long long)));
+    }
+
+    void BM_AnalyticsTotal(benchmark::State &state) {
+        measureAnalytics(state, [](const ch05::BalanceAnalytics &analytics) { return analytics.getTotal(); });
+    }
+
+    void BM_AnalyticsRange(benchmark::State &state) {
+        measureAnalytics(state, [](const ch05::BalanceAnalytics &analytics) { return analytics.getRange(); });
+    }
+
+    void BM_AnalyticsTopK(benchmark::State &state) {
+        measureAnalytics(state, [](const ch05::BalanceAnalytics &analytics) { return analytics.getTopK(100); });
+    }
+
+    void BM_AnalyticsQuantiles(benchmark::State &state) {
+        measureAnalytics(state, [](const ch05::BalanceAnalytics &analytics) {
+            return analytics.getQuantiles().quantile(0.99);
+        });
+    }
+
+    constexpr long JOURNAL_RECORDS = 1 << 20;
+
+    std::string journalPath(const char *extension) {
+        return (std::filesystem::temp_directory_path() / "ch05-bench-journal").string() + extension;
+    }
+
+    // the lines of ConsoleLogger, written to a file
+    class TextJournal : public ch05::Logger {
+    public:
+        explicit TextJournal(const std::string &path) : stream{path} {}
+
+        void transfer(const long fromAccount, const long toAccount, const long long amount) const override {
+            this->stream << "journal: " <<
+                         "transfer from account: " << fromAccount <<
+                         " to account: " << toAccount <<
+                         " amount: " << amount <<
+                         '\n';
+        }
+
+    private:
+        mutable std::ofstream stream;
+    };
+
+    template<typename Journal>
+    void writeJournal(const std::string &path) {
+        const Journal journal{path};
+        auto accounts = sampleAccounts(Distribution::Uniform, 1);
+
+        for (long i{}; i < JOURNAL_RECORDS; i++) {
+            journal.transfer(accounts[i % SAMPLE_COUNT], accounts[(i + 1) % SAMPLE_COUNT], 1 + i % 1000);
+        }
+    }
+
+    template<typename Journal>
+    void measureJournalWrite(benchmark::State &state, const std::string &path) {
+        for (auto _: state) {
+            writeJournal<Journal>(path);
+        }
+
+        state.SetItemsProcessed(state.iterations() * JOURNAL_RECORDS);
+        state.SetBytesProcessed(state.iterations() * static_cast<long>(std::filesystem::file_size(path)));
+        state.counters["bytes_per_record"] = static_cast<double>(std::filesystem::file_size(path)) /
+                                             static_cast<double>(JOURNAL_RECORDS);
+        std::filesystem::remove(path);
+    }
+
+    void BM_JournalWriteBinary(benchmark::State &state) {
+        measureJournalWrite<ch05::TransferJournal>(state, journalPath(".bin"));
+    }
+
+    void BM_JournalWriteText(benchmark::State &state) {
+        measureJournalWrite<TextJournal>(state, journalPath(".txt"));
+    }
+
+    void BM_JournalScanBinary(benchmark::State &state) {
+        const auto path = journalPath(".bin");
+        writeJournal<ch05::TransferJournal>(path);
+
+        for (auto _: state) {
+            const ch05::TransferJournalReader reader{path};
+
+            long long total{};
+            reader.forEach([&total](const ch05::JournalRecord &record) {
+                total += record.amount;
+            });
+            benchmark::DoNotOptimize(total);
+        }
+
+        state.SetItemsProcessed(state.iterations() * JOURNAL_RECORDS);
+        std::filesystem::remove(path);
+    }
+
+    // reads the whole file and parses the three numbers of every line, the least a replay of the text needs
+    void BM_JournalScanText(benchmark::State &state) {
+        const auto path = journalPath(".txt");
+        writeJournal<TextJournal>(path);
+
+        for (auto _: state) {
+            std::ifstream stream{path};
+            std::string line{};
+
+            long long total{};
+            while (std::getline(stream, line)) {
+                long numbers[2]{};
+                long long amount{};
+                const char *position = line.data();
+                const char *end = line.data() + line.size();
+
+                for (auto &number: numbers) {
+                    position = std::find_if(position, end, [](const char c) { return c == '-' || std::isdigit(c); });
+                    position = std::from_chars(position, end, number).ptr;
+                }
+                position = std::find_if(position, end, [](const char c) { return c == '-' || std::isdigit(c); });
+                std::from_chars(position, end, amount);
+
+                benchmark::DoNotOptimize(numbers);
+                total += amount;
+            }
+            benchmark::DoNotOptimize(total);
+        }
+
+        state.SetItemsProcessed(state.iterations() * JOURNAL_RECORDS);
+        std::filesystem::remove(path);
+    }
+}
+
+BENCHMARK_CAPTURE(BM_InMemoryBankTransfer, uniform, Distribution::Uniform);
+BENCHMARK_CAPTURE(BM_InMemoryBankTransfer, zipf, Distribution::Zipf);
+
+BENCHMARK(BM_BankTransferPerCall)->RangeMultiplier(4)->Range(1, 1 << 16);
+BENCHMARK(BM_BankTransferBatch)->RangeMultiplier(4)->Range(1, 1 << 16);
+BENCHMARK(BM_OptimisticBankTransferBatch)->RangeMultiplier(4)->Range(1, 1 << 16);
+
+BENCHMARK(BM_BankTransferLatencyNoLogger);
+BENCHMARK(BM_BankTransferLatencyConsoleLogger);
+BENCHMARK_CAPTURE(BM_BankTransferLatencyAsyncLogger, drop, ch05::OverflowPolicy::Drop);
+BENCHMARK_CAPTURE(BM_BankTransferLatencyAsyncLogger, block, ch05::OverflowPolicy::Block);
+BENCHMARK_CAPTURE(BM_BankTransferLatencyAsyncLogger, count, ch05::OverflowPolicy::Count);
+
+BENCHMARK(BM_InMemoryLookup)->Arg(1'000'000)->Arg(10'000'000)->Arg(100'000'000)->Iterations(1 << 24);
+BENCHMARK(BM_SnapshotLookup)->Arg(1'000'000)->Arg(10'000'000)->Iterations(1 << 24);
+BENCHMARK(BM_FlatLookup)->Arg(1'000'000)->Arg(10'000'000)->Arg(100'000'000)->Iterations(1 << 24);
+BENCHMARK(BM_FlatLookupReserved)->Arg(1'000'000)->Arg(10'000'000)->Arg(100'000'000)->Iterations(1 << 24);
+
+BENCHMARK(BM_MmapColdOpen)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_MmapTransfer)->Arg(1)->Arg(16)->Arg(256)->Arg(4096)->UseRealTime();
+BENCHMARK(BM_MmapRecovery)->Arg(1 << 10)->Arg(1 << 14)->Arg(1 << 18)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_CAPTURE(BM_ShardedBankTransfer, uniform, Distribution::Uniform)
+        ->ThreadRange(1, static_cast<int>(std::thread::hardware_concurrency()))->UseRealTime();
+BENCHMARK_CAPTURE(BM_ShardedBankTransfer, zipf, Distribution::Zipf)
+        ->ThreadRange(1, static_cast<int>(std::thread::hardware_concurrency()))->UseRealTime();
+
+BENCHMARK_CAPTURE(BM_OptimisticTransfer, uniform, Distribution::Uniform)->Arg(2)->Arg(8)
+        ->ThreadRange(1, static_cast<int>(std::thread::hardware_concurrency()))->UseRealTime();
+BENCHMARK_CAPTURE(BM_OptimisticTransfer, zipf, Distribution::Zipf)->Arg(2)->Arg(8)
+        ->ThreadRange(1, static_cast<int>(std::thread::hardware_concurrency()))->UseRealTime();
+BENCHMARK_CAPTURE(BM_MutexTransfer, uniform, Distribution::Uniform)->Arg(2)->Arg(8)
+        ->ThreadRange(1, static_cast<int>(std::thread::hardware_concurrency()))->UseRealTime();
+BENCHMARK_CAPTURE(BM_MutexTransfer, zipf, Distribution::Zipf)->Arg(2)->Arg(8)
+        ->ThreadRange(1, static_cast<int>(std::thread::hardware_concurrency()))->UseRealTime();
+
+BENCHMARK(BM_SnapshotTransfer);
+BENCHMARK(BM_SnapshotTransferDuringScan)->Arg(0)->Arg(1)->Arg(2)->UseRealTime();
+BENCHMARK(BM_SnapshotTotal)->RangeMultiplier(2)->Range(1, 8)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+BENCHMARK(BM_ExportColumns)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_AnalyticsTotal)->Apply(analyticsArguments);
+BENCHMARK(BM_AnalyticsRange)->Apply(analyticsArguments);
+BENCHMARK(BM_AnalyticsTopK)->Apply(analyticsArguments);
+BENCHMARK(BM_AnalyticsQuantiles)->Apply(analyticsArguments);
+
+BENCHMARK(BM_JournalWriteBinary)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_JournalWriteText)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_JournalScanBinary)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_JournalScanText)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,190 @@
+#include <climits>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "ch05-flat-account-database.h"
+
+namespace {
+    // The table's own hash, repeated here to pick accounts that land in the same group or share a control
+    // byte. Should the table's hash change, these tests still pass; they just stop aiming at those paths.
+    unsigned long long tableHash(const long account) {
+        auto hash = static_cast<unsigned long long>(account);
+        hash ^= hash >> 33;
+        hash *= 0xFF51AFD7ED558CCDull;
+        hash ^= hash >> 33;
+
+        return hash;
+    }
+
+    // accounts whose probe sequence starts at group in a table of groupCount groups
+    std::vector<long> accountsInGroup(const size_t group, const size_t groupCount, const size_t count,
+                                      const bool sameControl = false) {
+        std::vector<long> accounts{};
+        for (long account{1}; accounts.size() < count; account++) {
+            const auto hash = tableHash(account);
+            if (((hash >> 7) & (groupCount - 1)) != group) {
+                continue;
+            }
+            if (sameControl && !accounts.empty() && (hash & 0x7F) != (tableHash(accounts.front()) & 0x7F)) {
+                continue;
+            }
+
+            accounts.push_back(account);
+        }
+
+        return accounts;
+    }
+}
+
+TEST(Ch05FlatAccountDatabase, ReadsZeroFromAnEmptyTable) {
+    const ch05::FlatAccountDatabase database{};
+    EXPECT_EQ(0u, database.getCapacity());
+    EXPECT_EQ(0, database.getAmount(42));
+}
+
+TEST(Ch05FlatAccountDatabase, MatchesAMapThroughGrowth) {
+    ch05::FlatAccountDatabase database{};
+    std::unordered_map<long, long long> oracle{};
+    std::mt19937_64 random{42};
+    size_t capacity{};
+    int rehashes{};
+
+    for (int i{}; i < 100'000; i++) {
+        const auto from = static_cast<long>(random() % 50'000) - 25'000;
+        const auto to = random() % 8 == 0 ? static_cast<long>(random()) : from + 1;
+        const auto amount = static_cast<long long>(random() % 1000);
+
+        if (random() % 4 == 0) {
+            database.setAmount(from, amount);
+            oracle[from] = amount;
+        } else {
+            database.transfer(from, to, amount);
+            oracle[from] -= amount;
+            oracle[to] += amount;
+        }
+
+        // seven eighths full at most, so every probe sequence meets an empty slot
+        ASSERT_LE(database.getSize(), database.getCapacity() - database.getCapacity() / 8);
+        rehashes += database.getCapacity() != capacity;
+        capacity = database.getCapacity();
+    }
+
+    EXPECT_GT(rehashes, 5);
+    EXPECT_EQ(oracle.size(), database.getSize());
+    for (const auto &[account, amount]: oracle) {
+        ASSERT_EQ(amount, database.getAmount(account)) << "account " << account;
+    }
+}
+
+TEST(Ch05FlatAccountDatabase, KeepsExtremeAccounts) {
+    ch05::FlatAccountDatabase database{};
+    database.setAmount(LONG_MIN, 1);
+    database.setAmount(LONG_MAX, 2);
+    database.setAmount(0, 3);
+    database.setAmount(-1, 4);
+
+    EXPECT_EQ(1, database.getAmount(LONG_MIN));
+    EXPECT_EQ(2, database.getAmount(LONG_MAX));
+    EXPECT_EQ(3, database.getAmount(0));
+    EXPECT_EQ(4, database.getAmount(-1));
+    EXPECT_EQ(4u, database.getSize());
+}
+
+TEST(Ch05FlatAccountDatabase, FullGroupsSpillOverAndProbesWrapAround) {
+    // four groups of sixteen slots, and 40 accounts all starting at the last group: they fill it, then probing
+    // wraps around to group 0 and goes on through the others
+    ch05::FlatAccountDatabase database{50};
+    ASSERT_EQ(64u, database.getCapacity());
+    const auto accounts = accountsInGroup(3, 4, 40);
+
+    for (size_t i{}; i < accounts.size(); i++) {
+        database.setAmount(accounts[i], static_cast<long long>(i) + 1);
+    }
+
+    EXPECT_EQ(64u, database.getCapacity());
+    for (size_t i{}; i < accounts.size(); i++) {
+        EXPECT_EQ(static_cast<long long>(i) + 1, database.getAmount(accounts[i])) << "account " << accounts[i];
+    }
+
+    // a missing account from the same group probes past the full ones before it finds it is not there
+    const auto missing = accountsInGroup(3, 4, 41).back();
+    EXPECT_EQ(0, database.getAmount(missing));
+    EXPECT_EQ(40u, database.getSize());
+}
+
+TEST(Ch05FlatAccountDatabase, TellsApartAccountsWithTheSameControlByte) {
+    ch05::FlatAccountDatabase database{50};
+    const auto accounts = accountsInGroup(1, 4, 20, true);
+
+    for (size_t i{}; i < accounts.size(); i++) {
+        database.setAmount(accounts[i], static_cast<long long>(i) * 10);
+    }
+
+    for (size_t i{}; i < accounts.size(); i++) {
+        EXPECT_EQ(static_cast<long long>(i) * 10, database.getAmount(accounts[i])) << "account " << accounts[i];
+    }
+    EXPECT_EQ(accounts.size(), database.getSize());
+}
+
+TEST(Ch05FlatAccountDatabase, GrowsWithCollidingAccounts) {
+    ch05::FlatAccountDatabase database{};
+    const auto accounts = accountsInGroup(0, 4, 500);
+
+    for (size_t i{}; i < accounts.size(); i++) {
+        database.setAmount(accounts[i], static_cast<long long>(i));
+    }
+
+    for (size_t i{}; i < accounts.size(); i++) {
+        ASSERT_EQ(static_cast<long long>(i), database.getAmount(accounts[i])) << "account " << accounts[i];
+    }
+}
+
+TEST(Ch05FlatAccountDatabase, LoadSizesTheTableOnce) {
+    std::vector<ch05::AccountBalance> accounts{};
+    for (long account{}; account < 1000; account++) {
+        accounts.push_back(ch05::AccountBalance{account * 7919, account});
+    }
+
+    ch05::FlatAccountDatabase reserved{};
+    reserved.reserve(accounts.size());
+
+    ch05::FlatAccountDatabase database{};
+    database.load(accounts);
+
+    EXPECT_EQ(reserved.getCapacity(), database.getCapacity());
+    EXPECT_EQ(accounts.size(), database.getSize());
+    for (const auto &account: accounts) {
+        ASSERT_EQ(account.amount, database.getAmount(account.account));
+    }
+}
+
+TEST(Ch05FlatAccountDatabase, AddsAmountsToNewAndExistingAccounts) {
+    ch05::FlatAccountDatabase database{};
+    database.setAmount(1, 100);
+
+    const ch05::AccountDelta deltas[]{{1, -30}, {2, 20}, {3, 10}, {2, 5}};
+    database.addAmounts(deltas);
+
+    EXPECT_EQ(70, database.getAmount(1));
+    EXPECT_EQ(25, database.getAmount(2));
+    EXPECT_EQ(10, database.getAmount(3));
+    EXPECT_EQ(3u, database.getSize());
+}
+
+TEST(Ch05FlatAccountDatabase, AddingToExistingAccountsDoesNotGrow) {
+    ch05::FlatAccountDatabase database{1000};
+    std::vector<ch05::AccountDelta> deltas{};
+    for (long account{}; account < 1000; account++) {
+        database.setAmount(account, 100);
+        deltas.push_back(ch05::AccountDelta{account, 1});
+    }
+    const auto capacity = database.getCapacity();
+
+    database.addAmounts(deltas);
+
+    EXPECT_EQ(capacity, database.getCapacity());
+    EXPECT_EQ(101, database.getAmount(999));
+}
@@ -0,0 +1,215 @@
+#ifndef CPPCRASHCOURSE_CH05_FLAT_ACCOUNT_DATABASE_H
+#define CPPCRASHCOURSE_CH05_FLAT_ACCOUNT_DATABASE_H
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <memory>
+#include <span>
+
+#if defined(__SSE2__)
+
+#include <emmintrin.h>
+
+#endif
+
+#include "ch05.h"
+
+namespace ch05 {
+    // Swiss-table style open addressing: one control byte per slot holding 7 bits of the hash, probed
+    // sixteen at a time, and the accounts themselves stored inline in one flat array.
+    class FlatAccountDatabase : public AccountDatabase {
+    public:
+        FlatAccountDatabase() = default;
+
+        explicit FlatAccountDatabase(const size_t accountCount) {
+            this->reserve(accountCount);
+        }
+
+        long long getAmount(const long account) const override {
+            const auto *slot = this->find(account);
+            if (slot == nullptr) {
+                return 0;
+            }
+
+            return slot->amount;
+        }
+
+        void setAmount(const long account, const long long amount) override {
+            this->findOrInsert(account).amount = amount;
+        }
+
+        void transfer(const long fromAccount, const long toAccount, const long long amount) override {
+            this->findOrInsert(fromAccount).amount -= amount;
+            this->findOrInsert(toAccount).amount += amount;
+        }
+
+        // Grows the table at most once, for the accounts the batch adds; a batch over existing accounts never
+        // rehashes. An account missing from several deltas is counted each time, which only sizes up a little.
+        void addAmounts(const std::span<const AccountDelta> deltas) override {
+            const auto missing = static_cast<size_t>(std::count_if(deltas.begin(), deltas.end(),
+                                                                   [this](const AccountDelta &delta) {
+                                                                       return this->find(delta.account) == nullptr;
+                                                                   }));
+            this->reserve(this->size + missing);
+
+            for (const auto &delta: deltas) {
+                this->findOrInsert(delta.account).amount += delta.amount;
+            }
+        }
+
+        void reserve(const size_t accountCount) {
+            const auto capacity = std::bit_ceil(std::max(GROUP_SIZE, accountCount + accountCount / 7 + 1));
+            if (capacity > this->capacity) {
+                this->rehash(capacity);
+            }
+        }
+
+        // Sizes the table once up front, so loading a snapshot of balances never rehashes.
+        void load(const std::span<const AccountBalance> accounts) {
+            this->reserve(this->size + accounts.size());
+
+            for (const auto &account: accounts) {
+                this->findOrInsert(account.account).amount = account.amount;
+            }
+        }
+
+        [[nodiscard]] size_t getSize() const {
+            return this->size;
+        }
+
+        [[nodiscard]] size_t getCapacity() const {
+            return this->capacity;
+        }
+
+    private:
+        static constexpr size_t GROUP_SIZE = 16;
+        static constexpr signed char EMPTY = -128;
+
+        struct alignas(GROUP_SIZE) Group {
+            signed char control[GROUP_SIZE];
+        };
+
+        struct Slot {
+            long account;
+            long long amount;
+        };
+
+        std::unique_ptr<Group[]> groups;
+        std::unique_ptr<Slot[]> slots;
+        size_t groupMask{};
+        size_t size{};
+        size_t capacity{};
+
+        static unsigned long long hash(const long account) {
+            auto hash = static_cast<unsigned long long>(account);
+            hash ^= hash >> 33;
+            hash *= 0xFF51AFD7ED558CCDull;
+            hash ^= hash >> 33;
+
+            return hash;
+        }
+
+        static unsigned match(const Group &group, const signed char control) {
+#if defined(__SSE2__)
+            const auto bytes = _mm_load_si128(reinterpret_cast<const __m128i *>(group.control));
+            return static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(control))));
+#else
+            unsigned bits{};
+            for (size_t i{}; i < GROUP_SIZE; i++) {
+                bits |= static_cast<unsigned>(group.control[i] == control) << i;
+            }
+
+            return bits;
+#endif
+        }
+
+        const Slot *find(const long account) const {
+            if (this->capacity == 0) {
+                return nullptr;
+            }
+
+            const auto hash = FlatAccountDatabase::hash(account);
+            const auto control = static_cast<signed char>(hash & 0x7F);
+            auto group = (hash >> 7) & this->groupMask;
+
+            // triangular probing visits every group once when the group count is a power of two
+            for (size_t step{1};; step++) {
+                for (auto bits = match(this->groups[group], control); bits != 0; bits &= bits - 1) {
+                    const auto &slot = this->slots[group * GROUP_SIZE + std::countr_zero(bits)];
+                    if (slot.account == account) {
+                        return &slot;
+                    }
+                }
+
+                if (match(this->groups[group], EMPTY) != 0) {
+                    return nullptr;
+                }
+
+                group = (group + step) & this->groupMask;
+            }
+        }
+
+        Slot &findOrInsert(const long account) {
+            if (auto *slot = this->find(account); slot != nullptr) {
+                return const_cast<Slot &>(*slot);
+            }
+
+            if (this->size + 1 > this->capacity - this->capacity / 8) {
+                this->rehash(std::max(GROUP_SIZE, 2 * this->capacity));
+            }
+
+            auto &slot = this->insert(account);
+            slot.amount = 0;
+
+            return slot;
+        }
+
+        // Places an account known to be absent into the first empty slot of its probe sequence.
+        Slot &insert(const long account) {
+            const auto hash = FlatAccountDatabase::hash(account);
+            const auto control = static_cast<signed char>(hash & 0x7F);
+            auto group = (hash >> 7) & this->groupMask;
+
+            for (size_t step{1};; step++) {
+                if (const auto empty = match(this->groups[group], EMPTY); empty != 0) {
+                    const auto index = static_cast<size_t>(std::countr_zero(empty));
+                    this->groups[group].control[index] = control;
+                    this->size++;
+
+                    auto &slot = this->slots[group * GROUP_SIZE + index];
+                    slot.account = account;
+
+                    return slot;
+                }
+
+                group = (group + step) & this->groupMask;
+            }
+        }
+
+        void rehash(const size_t capacity) {
+            auto groups = std::move(this->groups);
+            auto slots = std::move(this->slots);
+            const auto groupCount = this->capacity / GROUP_SIZE;
+
+            // slots are left uninitialized, so untouched pages never count towards the resident set
+            this->groups.reset(new Group[capacity / GROUP_SIZE]);
+            this->slots.reset(new Slot[capacity]);
+            std::memset(this->groups.get(), EMPTY, capacity);
+            this->groupMask = capacity / GROUP_SIZE - 1;
+            this->capacity = capacity;
+            this->size = 0;
+
+            for (size_t group{}; group < groupCount; group++) {
+                for (size_t index{}; index < GROUP_SIZE; index++) {
+                    if (groups[group].control[index] != EMPTY) {
+                        const auto &slot = slots[group * GROUP_SIZE + index];
+                        this->insert(slot.account).amount = slot.amount;
+                    }
+                }
+            }
+        }
+    };
+}
+
+#endif //CPPCRASHCOURSE_CH05_FLAT_ACCOUNT_DATABASE_H
@@ -0,0 +1,285 @@
+#include <algorithm>
+#include <csignal>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "gtest/gtest.h"
+
+#include "ch05-mmap-account-database.h"
+
+namespace {
+    std::string databasePath() {
+        return (std::filesystem::temp_directory_path() / "ch05-mmap-account-database-test.db").string();
+    }
+
+    std::string logPath() {
+        return databasePath() + ".wal";
+    }
+
+    void removeDatabase() {
+        std::filesystem::remove(databasePath());
+        std::filesystem::remove(logPath());
+    }
+
+    // ends the child process on the spot, with the database still open, as if the machine went down
+    [[noreturn]] void crash() {
+        _exit(::testing::Test::HasFailure() ? 1 : 0);
+    }
+
+    // Runs work in a child process, which must end with crash(), so only what work made durable with sync() is
+    // left in the log.
+    template<typename Work>
+    void crashAfter(Work work) {
+        const auto child = fork();
+        ASSERT_GE(child, 0);
+
+        if (child == 0) {
+            work();
+        }
+
+        int status{};
+        waitpid(child, &status, 0);
+        ASSERT_TRUE(WIFEXITED(status));
+        ASSERT_EQ(0, WEXITSTATUS(status));
+    }
+
+    class Ch05MmapAccountDatabase : public ::testing::Test {
+    protected:
+        void SetUp() override {
+            removeDatabase();
+        }
+
+        void TearDown() override {
+            removeDatabase();
+        }
+    };
+}
+
+TEST_F(Ch05MmapAccountDatabase, KeepsBalancesAcrossReopen) {
+    {
+        ch05::MmapAccountDatabase database{databasePath(), 64};
+        database.setAmount(1, 100);
+        database.transfer(1, 2, 30);
+    }
+
+    ch05::MmapAccountDatabase database{databasePath()};
+    EXPECT_EQ(70, database.getAmount(1));
+    EXPECT_EQ(30, database.getAmount(2));
+    EXPECT_EQ(2u, database.getSize());
+    EXPECT_EQ(0u, std::filesystem::file_size(logPath()));
+}
+
+TEST_F(Ch05MmapAccountDatabase, ReplaysSyncedTransfersAfterACrash) {
+    crashAfter([] {
+        ch05::MmapAccountDatabase database{databasePath(), 64, 1 << 10, 1ull << 40};
+        database.setAmount(1, 100);
+        database.transfer(1, 2, 30);
+        database.sync();
+
+        // never synced, so lost with the process
+        database.transfer(1, 2, 5);
+        crash();
+    });
+
+    EXPECT_GT(std::filesystem::file_size(logPath()), 0u);
+
+    ch05::MmapAccountDatabase database{databasePath()};
+    EXPECT_EQ(70, database.getAmount(1));
+    EXPECT_EQ(30, database.getAmount(2));
+    EXPECT_EQ(0u, std::filesystem::file_size(logPath()));
+}
+
+TEST_F(Ch05MmapAccountDatabase, IgnoresATornLastBlock) {
+    crashAfter([] {
+        ch05::MmapAccountDatabase database{databasePath(), 64, 1, 1ull << 40};
+        database.setAmount(1, 100);
+        database.transfer(1, 2, 30);
+        database.transfer(1, 3, 20);
+        crash();
+    });
+
+    // the last block, one transfer of two records, only made it halfway to disk
+    std::filesystem::resize_file(logPath(), std::filesystem::file_size(logPath()) - 8);
+
+    ch05::MmapAccountDatabase database{databasePath()};
+    EXPECT_EQ(70, database.getAmount(1));
+    EXPECT_EQ(30, database.getAmount(2));
+    EXPECT_EQ(0, database.getAmount(3));
+    EXPECT_EQ(2u, database.getSize());
+}
+
+TEST_F(Ch05MmapAccountDatabase, IgnoresACorruptLastBlock) {
+    crashAfter([] {
+        ch05::MmapAccountDatabase database{databasePath(), 64, 1, 1ull << 40};
+        database.setAmount(1, 100);
+        database.transfer(1, 2, 30);
+        crash();
+    });
+
+    // flips the last byte of the last record's amount, which the checksum catches
+    {
+        std::FILE *log = std::fopen(logPath().c_str(), "r+b");
+        ASSERT_NE(nullptr, log);
+        std::fseek(log, -1, SEEK_END);
+        std::fputc(0x7F, log);
+        std::fclose(log);
+    }
+
+    ch05::MmapAccountDatabase database{databasePath()};
+    EXPECT_EQ(100, database.getAmount(1));
+    EXPECT_EQ(0, database.getAmount(2));
+}
+
+TEST_F(Ch05MmapAccountDatabase, IgnoresAGarbageRecordCount) {
+    crashAfter([] {
+        ch05::MmapAccountDatabase database{databasePath(), 64, 1, 1ull << 40};
+        database.setAmount(1, 100);
+        database.transfer(1, 2, 30);
+        crash();
+    });
+
+    // a block header whose record count, times the record size, wraps around to zero bytes
+    {
+        std::FILE *log = std::fopen(logPath().c_str(), "ab");
+        ASSERT_NE(nullptr, log);
+        const unsigned long long block[2]{1ull << 60, 0};
+        std::fwrite(block, sizeof(block), 1, log);
+        std::fclose(log);
+    }
+
+    ch05::MmapAccountDatabase database{databasePath()};
+    EXPECT_EQ(70, database.getAmount(1));
+    EXPECT_EQ(30, database.getAmount(2));
+    EXPECT_EQ(0u, std::filesystem::file_size(logPath()));
+}
+
+namespace {
+    std::vector<char> readFile(const std::string &path) {
+        std::ifstream file{path, std::ios::binary};
+        return {std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+    }
+
+    void writeFile(const std::string &path, const std::vector<char> &bytes) {
+        std::ofstream file{path, std::ios::binary | std::ios::trunc};
+        file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    }
+}
+
+TEST_F(Ch05MmapAccountDatabase, RecountsAccountsAfterAnInterruptedCheckpoint) {
+    constexpr long ACCOUNTS{200};
+    crashAfter([] {
+        ch05::MmapAccountDatabase database{databasePath(), 1024, 1, 1ull << 40};
+        for (long account{}; account < ACCOUNTS; account++) {
+            database.setAmount(account, account + 1);
+        }
+        crash();
+    });
+
+    // the file as the crash left it, before any checkpoint, and as the checkpoint on reopening writes it
+    const auto log = readFile(logPath());
+    const auto before = readFile(databasePath());
+    {
+        ch05::MmapAccountDatabase database{databasePath()};
+    }
+    const auto after = readFile(databasePath());
+
+    const auto pageSize = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    ASSERT_EQ(before.size(), after.size());
+    ASSERT_GT(before.size(), pageSize);
+
+    // the checkpoint got only the header page to disk, then only the slot pages
+    for (const auto headerWritten: {true, false}) {
+        auto torn = headerWritten ? before : after;
+        std::copy_n((headerWritten ? after : before).begin(), pageSize, torn.begin());
+        writeFile(databasePath(), torn);
+        writeFile(logPath(), log);
+
+        ch05::MmapAccountDatabase database{databasePath()};
+        EXPECT_EQ(static_cast<size_t>(ACCOUNTS), database.getSize());
+        for (long account{}; account < ACCOUNTS; account++) {
+            EXPECT_EQ(account + 1, database.getAmount(account));
+        }
+    }
+}
+
+TEST_F(Ch05MmapAccountDatabase, CutsAShortWriteOffTheLogAndRetriesIt) {
+    crashAfter([] {
+        ch05::MmapAccountDatabase database{databasePath(), 64, 1, 1ull << 40};
+        database.setAmount(1, 100);
+        const auto size = std::filesystem::file_size(logPath());
+
+        // the next block only makes it halfway to disk, as on a full disk, and the process lives on
+        std::signal(SIGXFSZ, SIG_IGN);
+        rlimit limit{};
+        ::getrlimit(RLIMIT_FSIZE, &limit);
+        const auto unlimited = limit.rlim_cur;
+        limit.rlim_cur = size + 24;
+        ::setrlimit(RLIMIT_FSIZE, &limit);
+
+        EXPECT_THROW(database.transfer(1, 2, 30), std::system_error);
+        EXPECT_EQ(size, std::filesystem::file_size(logPath()));
+
+        limit.rlim_cur = unlimited;
+        ::setrlimit(RLIMIT_FSIZE, &limit);
+
+        // the transfer is still pending, and both blocks land where replay finds them
+        database.sync();
+        database.transfer(1, 3, 20);
+        crash();
+    });
+
+    ch05::MmapAccountDatabase database{databasePath()};
+    EXPECT_EQ(50, database.getAmount(1));
+    EXPECT_EQ(30, database.getAmount(2));
+    EXPECT_EQ(20, database.getAmount(3));
+}
+
+TEST_F(Ch05MmapAccountDatabase, RejectsATransferToANewAccountInAFullFile) {
+    // eight slots hold at most seven accounts
+    crashAfter([] {
+        ch05::MmapAccountDatabase database{databasePath(), 8, 1, 1ull << 40};
+        for (long account{}; account < 7; account++) {
+            database.setAmount(account, 100);
+        }
+
+        EXPECT_THROW(database.transfer(0, 7, 10), std::length_error);
+        EXPECT_EQ(100, database.getAmount(0));
+        EXPECT_EQ(7u, database.getSize());
+
+        const ch05::AccountDelta deltas[]{{1, -10}, {8, 5}, {9, 5}};
+        EXPECT_THROW(database.addAmounts(deltas), std::length_error);
+        EXPECT_EQ(100, database.getAmount(1));
+
+        database.transfer(0, 1, 10);
+        database.sync();
+        crash();
+    });
+
+    // the log holds no half of the rejected transfers
+    ch05::MmapAccountDatabase database{databasePath()};
+    EXPECT_EQ(90, database.getAmount(0));
+    EXPECT_EQ(110, database.getAmount(1));
+    EXPECT_EQ(0, database.getAmount(7));
+    EXPECT_EQ(7u, database.getSize());
+}
+
+TEST_F(Ch05MmapAccountDatabase, RejectsOtherFiles) {
+    {
+        std::FILE *file = std::fopen(databasePath().c_str(), "wb");
+        ASSERT_NE(nullptr, file);
+        std::fputs("not an account file, but long enough to hold a header", file);
+        std::fclose(file);
+    }
+
+    EXPECT_THROW(ch05::MmapAccountDatabase{databasePath()}, std::runtime_error);
+}
@@ -0,0 +1,448 @@
+#ifndef CPPCRASHCOURSE_CH05_MMAP_ACCOUNT_DATABASE_H
+#define CPPCRASHCOURSE_CH05_MMAP_ACCOUNT_DATABASE_H
+
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "ch05.h"
+
+namespace ch05 {
+    // Keeps the balances in a fixed-layout open-addressing table inside a file mapped copy-on-write, so opening
+    // an existing file costs one mmap. Every change is logged as an after-image to "<path>.wal" and committed in
+    // groups with one fdatasync; the file itself is only written by checkpoints, after the log is durable.
+    class MmapAccountDatabase : public AccountDatabase {
+    public:
+        explicit MmapAccountDatabase(const std::string &path, const size_t capacity = 1 << 20,
+                                     const size_t groupCommitSize = 256,
+                                     const size_t checkpointBytes = 64 << 20)
+                : groupCommitSize{groupCommitSize < 1 ? 1 : groupCommitSize}, checkpointBytes{checkpointBytes} {
+            this->dataFd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+            if (this->dataFd < 0) {
+                throw std::system_error{errno, std::generic_category(), "open " + path};
+            }
+
+            this->walFd = ::open((path + ".wal").c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+            if (this->walFd < 0) {
+                const auto error = errno;
+                ::close(this->dataFd);
+                throw std::system_error{error, std::generic_category(), "open " + path + ".wal"};
+            }
+
+            try {
+                this->map(std::bit_ceil(capacity < 8 ? 8 : capacity));
+                this->recover();
+            } catch (...) {
+                this->unmap();
+                throw;
+            }
+        }
+
+        ~MmapAccountDatabase() override {
+            try {
+                this->checkpoint();
+            } catch (const std::system_error &) {
+                // the log is still on disk and will be replayed by the next open
+            }
+
+            this->unmap();
+        }
+
+        MmapAccountDatabase(const MmapAccountDatabase &) = delete;
+
+        MmapAccountDatabase &operator=(const MmapAccountDatabase &) = delete;
+
+        long long getAmount(const long account) const override {
+            const auto *slot = this->find(account);
+            if (slot == nullptr) {
+                return 0;
+            }
+
+            return slot->amount;
+        }
+
+        void setAmount(const long account, const long long amount) override {
+            const AccountDelta legs[]{{account, amount}};
+            this->prepare(legs);
+
+            this->write(account, amount);
+            this->endTransaction();
+        }
+
+        void transfer(const long fromAccount, const long toAccount, const long long amount) override {
+            const AccountDelta legs[]{{fromAccount, -amount}, {toAccount, amount}};
+            this->prepare(legs);
+
+            this->write(fromAccount, this->getAmount(fromAccount) - amount);
+            this->write(toAccount, this->getAmount(toAccount) + amount);
+            this->endTransaction();
+        }
+
+        void addAmounts(const std::span<const AccountDelta> deltas) override {
+            this->prepare(deltas);
+
+            for (const auto &delta: deltas) {
+                this->write(delta.account, this->getAmount(delta.account) + delta.amount);
+            }
+
+            this->endTransaction();
+        }
+
+        // Makes every change so far durable.
+        void sync() {
+            this->commit();
+        }
+
+        // Writes the pages changed since the last checkpoint back to the file and empties the log.
+        void checkpoint() {
+            this->commit();
+
+            if (this->walSize == 0) {
+                return;
+            }
+
+            for (size_t page{}; page < this->dirtyPages.size(); page++) {
+                if (!this->dirtyPages[page]) {
+                    continue;
+                }
+
+                const auto offset = page * this->pageSize;
+                const auto length = std::min(this->pageSize, this->mappingSize - offset);
+                if (::pwrite(this->dataFd, this->mapping + offset, length, static_cast<off_t>(offset)) !=
+                    static_cast<ssize_t>(length)) {
+                    throw std::system_error{errno, std::generic_category(), "pwrite"};
+                }
+            }
+
+            if (::fdatasync(this->dataFd) != 0) {
+                throw std::system_error{errno, std::generic_category(), "fdatasync"};
+            }
+
+            if (::ftruncate(this->walFd, 0) != 0) {
+                throw std::system_error{errno, std::generic_category(), "ftruncate"};
+            }
+
+            this->dirtyPages.assign(this->dirtyPages.size(), false);
+            this->walSize = 0;
+        }
+
+        [[nodiscard]] size_t getSize() const {
+            return this->header->size;
+        }
+
+        [[nodiscard]] size_t getCapacity() const {
+            return this->header->capacity;
+        }
+
+    private:
+        static constexpr char MAGIC[8] = {'c', 'h', '0', '5', 'a', 'c', 'c', 't'};
+
+        struct FileHeader {
+            char magic[8];
+            unsigned long long capacity;
+            unsigned long long size;
+        };
+
+        struct Slot {
+            long account;
+            long long amount;
+            long long occupied;
+        };
+
+        struct LogBlock {
+            unsigned long long recordCount;
+            unsigned long long checksum;
+        };
+
+        struct LogRecord {
+            long account;
+            long long amount;
+        };
+
+        int dataFd{-1};
+        int walFd{-1};
+        size_t pageSize{static_cast<size_t>(::sysconf(_SC_PAGESIZE))};
+        char *mapping{};
+        size_t mappingSize{};
+        FileHeader *header{};
+        Slot *slots{};
+        std::vector<bool> dirtyPages;
+
+        size_t groupCommitSize;
+        size_t checkpointBytes;
+        size_t walSize{};
+        size_t pendingTransactions{};
+        std::vector<LogRecord> pending;
+        std::vector<long> missing;
+
+        static unsigned long long hash(const long account) {
+            auto hash = static_cast<unsigned long long>(account);
+            hash ^= hash >> 33;
+            hash *= 0xFF51AFD7ED558CCDull;
+            hash ^= hash >> 33;
+
+            return hash;
+        }
+
+        static unsigned long long checksum(const std::span<const LogRecord> records) {
+            auto checksum = 0xCBF29CE484222325ull;
+            for (const auto byte: std::as_bytes(records)) {
+                checksum = (checksum ^ static_cast<unsigned char>(byte)) * 0x100000001B3ull;
+            }
+
+            return checksum;
+        }
+
+        void map(const size_t capacity) {
+            struct stat status{};
+            if (::fstat(this->dataFd, &status) != 0) {
+                throw std::system_error{errno, std::generic_category(), "fstat"};
+            }
+
+            if (status.st_size == 0) {
+                const auto size = sizeof(FileHeader) + capacity * sizeof(Slot);
+                if (::ftruncate(this->dataFd, static_cast<off_t>(size)) != 0) {
+                    throw std::system_error{errno, std::generic_category(), "ftruncate"};
+                }
+
+                FileHeader header{};
+                std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+                header.capacity = capacity;
+
+                if (::pwrite(this->dataFd, &header, sizeof(header), 0) != sizeof(header) ||
+                    ::fdatasync(this->dataFd) != 0) {
+                    throw std::system_error{errno, std::generic_category(), "pwrite"};
+                }
+
+                status.st_size = static_cast<off_t>(size);
+            }
+
+            if (static_cast<size_t>(status.st_size) < sizeof(FileHeader)) {
+                throw std::runtime_error{"account file is truncated"};
+            }
+
+            this->mappingSize = static_cast<size_t>(status.st_size);
+            auto *mapping = ::mmap(nullptr, this->mappingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE, this->dataFd, 0);
+            if (mapping == MAP_FAILED) {
+                throw std::system_error{errno, std::generic_category(), "mmap"};
+            }
+
+            this->mapping = static_cast<char *>(mapping);
+            this->header = reinterpret_cast<FileHeader *>(this->mapping);
+            this->slots = reinterpret_cast<Slot *>(this->mapping + sizeof(FileHeader));
+
+            this->dirtyPages.assign((this->mappingSize + this->pageSize - 1) / this->pageSize, false);
+
+            if (std::memcmp(this->header->magic, MAGIC, sizeof(MAGIC)) != 0 ||
+                !std::has_single_bit(this->header->capacity) ||
+                sizeof(FileHeader) + this->header->capacity * sizeof(Slot) != this->mappingSize) {
+                throw std::runtime_error{"not an account file"};
+            }
+        }
+
+        void unmap() {
+            if (this->mapping != nullptr) {
+                ::munmap(this->mapping, this->mappingSize);
+            }
+
+            ::close(this->walFd);
+            ::close(this->dataFd);
+        }
+
+        // Replays every complete block of the log; a torn block at the end was never acknowledged by sync().
+        void recover() {
+            struct stat status{};
+            if (::fstat(this->walFd, &status) != 0) {
+                throw std::system_error{errno, std::generic_category(), "fstat"};
+            }
+
+            std::vector<char> log(static_cast<size_t>(status.st_size));
+            if (::pread(this->walFd, log.data(), log.size(), 0) != static_cast<ssize_t>(log.size())) {
+                throw std::system_error{errno, std::generic_category(), "pread"};
+            }
+
+            if (!log.empty()) {
+                this->recount();
+            }
+
+            size_t offset{};
+            while (offset + sizeof(LogBlock) <= log.size()) {
+                LogBlock block{};
+                std::memcpy(&block, log.data() + offset, sizeof(block));
+
+                // compared before multiplying, since a garbage count can wrap the length back into range
+                if (block.recordCount > (log.size() - offset - sizeof(LogBlock)) / sizeof(LogRecord)) {
+                    break;
+                }
+
+                const auto length = block.recordCount * sizeof(LogRecord);
+
+                std::vector<LogRecord> records(block.recordCount);
+                std::memcpy(records.data(), log.data() + offset + sizeof(LogBlock), length);
+                if (checksum(records) != block.checksum) {
+                    break;
+                }
+
+                for (const auto &record: records) {
+                    this->apply(record.account, record.amount);
+                }
+
+                offset += sizeof(LogBlock) + length;
+            }
+
+            if (!log.empty()) {
+                this->walSize = log.size();
+                this->checkpoint();
+            }
+        }
+
+        // A checkpoint cut short may have written the header without the slot pages or the other way round, so
+        // the stored size is only trusted once it matches the slots; the replay then counts its new accounts.
+        void recount() {
+            size_t size{};
+            for (size_t index{}; index < this->header->capacity; index++) {
+                size += this->slots[index].occupied != 0;
+            }
+
+            if (size != this->header->size) {
+                this->header->size = size;
+                this->dirtyPages[0] = true;
+            }
+        }
+
+        const Slot *find(const long account) const {
+            const auto mask = this->header->capacity - 1;
+
+            for (auto index = hash(account) & mask;; index = (index + 1) & mask) {
+                const auto &slot = this->slots[index];
+                if (!slot.occupied) {
+                    return nullptr;
+                }
+
+                if (slot.account == account) {
+                    return &slot;
+                }
+            }
+        }
+
+        void apply(const long account, const long long amount) {
+            const auto mask = this->header->capacity - 1;
+
+            auto index = hash(account) & mask;
+            while (this->slots[index].occupied && this->slots[index].account != account) {
+                index = (index + 1) & mask;
+            }
+
+            auto &slot = this->slots[index];
+            if (!slot.occupied) {
+                if (this->header->size + 1 > this->getMaxSize()) {
+                    throw std::length_error{"account file is full"};
+                }
+
+                slot.occupied = 1;
+                slot.account = account;
+                this->header->size++;
+                this->dirtyPages[0] = true;
+            }
+
+            slot.amount = amount;
+
+            const auto offset = static_cast<size_t>(reinterpret_cast<char *>(&slot) - this->mapping);
+            this->dirtyPages[offset / this->pageSize] = true;
+            this->dirtyPages[(offset + sizeof(Slot) - 1) / this->pageSize] = true;
+        }
+
+        // the table is never filled beyond seven eighths, so probes stay short
+        [[nodiscard]] size_t getMaxSize() const {
+            return this->header->capacity - this->header->capacity / 8;
+        }
+
+        // Throws before the first leg changes anything when the new accounts among legs do not fit, and makes
+        // room for the log records, so a transaction is applied and logged whole or not at all.
+        void prepare(const std::span<const AccountDelta> legs) {
+            this->missing.clear();
+            for (const auto &leg: legs) {
+                if (this->find(leg.account) == nullptr) {
+                    this->missing.push_back(leg.account);
+                }
+            }
+
+            std::sort(this->missing.begin(), this->missing.end());
+            const auto added = static_cast<size_t>(
+                    std::unique(this->missing.begin(), this->missing.end()) - this->missing.begin());
+            if (this->header->size + added > this->getMaxSize()) {
+                throw std::length_error{"account file is full"};
+            }
+
+            this->pending.reserve(this->pending.size() + legs.size());
+        }
+
+        void write(const long account, const long long amount) {
+            this->apply(account, amount);
+            this->pending.push_back(LogRecord{account, amount});
+        }
+
+        void endTransaction() {
+            if (++this->pendingTransactions >= this->groupCommitSize) {
+                this->commit();
+            }
+        }
+
+        // Appends the pending transactions as one checksummed block, so a transfer is replayed whole or not at all.
+        // When the block cannot be made durable it is cut off the log again and stays pending for the next commit,
+        // so no later block is ever appended behind a torn one that replay would stop at.
+        void commit() {
+            if (this->pending.empty()) {
+                return;
+            }
+
+            LogBlock block{this->pending.size(), checksum(this->pending)};
+
+            iovec buffers[] = {
+                    {&block, sizeof(LogBlock)},
+                    {this->pending.data(), this->pending.size() * sizeof(LogRecord)},
+            };
+            const auto length = buffers[0].iov_len + buffers[1].iov_len;
+
+            const auto written = ::writev(this->walFd, buffers, 2);
+            if (written != static_cast<ssize_t>(length)) {
+                // a short write sets no errno
+                this->rollBack(written < 0 ? errno : ENOSPC, "writev");
+            }
+
+            if (::fdatasync(this->walFd) != 0) {
+                this->rollBack(errno, "fdatasync");
+            }
+
+            this->walSize += length;
+            this->pending.clear();
+            this->pendingTransactions = 0;
+
+            if (this->walSize >= this->checkpointBytes) {
+                this->checkpoint();
+            }
+        }
+
+        [[noreturn]] void rollBack(const int error, const char *what) const {
+            if (::ftruncate(this->walFd, static_cast<off_t>(this->walSize)) != 0) {
+                throw std::system_error{errno, std::generic_category(), "ftruncate"};
+            }
+
+            throw std::system_error{error, std::generic_category(), what};
+        }
+    };
+}
+
+#endif //CPPCRASHCOURSE_CH05_MMAP_ACCOUNT_DATABASE_H
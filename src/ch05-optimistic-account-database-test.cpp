@@ -0,0 +1,183 @@
+#include <atomic>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "ch05-optimistic-account-database.h"
+
+namespace {
+    constexpr long ACCOUNT_COUNT{64};
+    constexpr long long OPENING_AMOUNT{1000};
+
+    void open(ch05::OptimisticAccountDatabase &database) {
+        for (long account{}; account < ACCOUNT_COUNT; account++) {
+            database.setAmount(account, OPENING_AMOUNT);
+        }
+    }
+
+    long long getTotal(const ch05::OptimisticAccountDatabase &database) {
+        long long total{};
+        for (long account{}; account < ACCOUNT_COUNT; account++) {
+            total += database.getAmount(account);
+        }
+
+        return total;
+    }
+
+    // 2 to 8 legs over random accounts, some of them more than once, netting to zero
+    std::vector<ch05::AccountDelta> randomLegs(std::mt19937_64 &random) {
+        std::uniform_int_distribution<long> account{0, ACCOUNT_COUNT - 1};
+        std::uniform_int_distribution<long long> amount{-50, 50};
+        std::uniform_int_distribution<size_t> legCount{2, 8};
+
+        std::vector<ch05::AccountDelta> legs(legCount(random));
+        long long sum{};
+        for (size_t i{}; i + 1 < legs.size(); i++) {
+            legs[i] = ch05::AccountDelta{account(random), amount(random)};
+            sum += legs[i].amount;
+        }
+        legs.back() = ch05::AccountDelta{account(random), -sum};
+
+        return legs;
+    }
+}
+
+TEST(Ch05OptimisticAccountDatabase, TransfersBetweenAccounts) {
+    ch05::OptimisticAccountDatabase database{ACCOUNT_COUNT};
+    open(database);
+
+    const ch05::AccountDelta legs[]{{1, -300}, {2, 100}, {3, 150}, {1, 50}};
+    EXPECT_EQ(1u, database.transfer(legs));
+
+    EXPECT_EQ(750, database.getAmount(1));
+    EXPECT_EQ(1100, database.getAmount(2));
+    EXPECT_EQ(1150, database.getAmount(3));
+    EXPECT_EQ(ACCOUNT_COUNT * OPENING_AMOUNT, getTotal(database));
+}
+
+TEST(Ch05OptimisticAccountDatabase, ConcurrentTransfersKeepTheTotal) {
+    constexpr int threadCount{4};
+    constexpr int transfersPerThread{5000};
+    ch05::OptimisticAccountDatabase database{ACCOUNT_COUNT};
+    open(database);
+
+    std::vector<std::thread> threads{};
+    for (int thread{}; thread < threadCount; thread++) {
+        threads.emplace_back([&database, thread] {
+            std::mt19937_64 random{static_cast<unsigned long long>(thread)};
+            for (int i{}; i < transfersPerThread; i++) {
+                database.transfer(randomLegs(random));
+            }
+        });
+    }
+
+    for (auto &thread: threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(ACCOUNT_COUNT * OPENING_AMOUNT, getTotal(database));
+}
+
+TEST(Ch05OptimisticAccountDatabase, ReadOnlyTransactionSeesAConsistentTotal) {
+    ch05::OptimisticAccountDatabase database{ACCOUNT_COUNT};
+    open(database);
+
+    std::atomic<bool> transferring{true};
+    std::thread writer{[&database, &transferring] {
+        std::mt19937_64 random{42};
+        for (int i{}; i < 20'000; i++) {
+            database.transfer(randomLegs(random));
+        }
+        transferring.store(false);
+    }};
+
+    int totals{};
+    do {
+        long long total{};
+        database.transact([&total](ch05::Transaction &transaction) {
+            total = 0;
+            for (long account{}; account < ACCOUNT_COUNT; account++) {
+                total += transaction.read(account);
+            }
+        });
+
+        ASSERT_EQ(ACCOUNT_COUNT * OPENING_AMOUNT, total);
+        totals++;
+    } while (transferring.load());
+
+    writer.join();
+    EXPECT_GT(totals, 0);
+}
+
+TEST(Ch05OptimisticAccountDatabase, AppliesABankBatchAsOneTransaction) {
+    ch05::OptimisticAccountDatabase database{ACCOUNT_COUNT};
+    open(database);
+    ch05::Bank bank{database};
+
+    std::map<long, long long> expected{};
+    for (long account{}; account < ACCOUNT_COUNT; account++) {
+        expected[account] = OPENING_AMOUNT;
+    }
+
+    // a small batch scans its few legs, a large one indexes them; each must leave the next one a clean slate
+    std::mt19937_64 random{7};
+    std::uniform_int_distribution<long> account{0, ACCOUNT_COUNT - 1};
+    std::uniform_int_distribution<long long> amount{1, 50};
+    for (const size_t count: {20'000, 2, 3, 20'000}) {
+        std::vector<ch05::Transfer> transfers(count);
+        for (auto &transfer: transfers) {
+            transfer = ch05::Transfer{account(random), account(random), amount(random)};
+            expected[transfer.fromAccount] -= transfer.amount;
+            expected[transfer.toAccount] += transfer.amount;
+        }
+
+        bank.transferBatch(transfers);
+    }
+
+    for (const auto &[account, amount]: expected) {
+        EXPECT_EQ(amount, database.getAmount(account));
+    }
+}
+
+TEST(Ch05OptimisticAccountDatabase, RejectsUnbalancedLegs) {
+    ch05::OptimisticAccountDatabase database{ACCOUNT_COUNT};
+    open(database);
+
+    const ch05::AccountDelta legs[]{{1, -100}, {2, 90}};
+    EXPECT_THROW(database.transfer(legs), std::invalid_argument);
+    EXPECT_EQ(OPENING_AMOUNT, database.getAmount(1));
+    EXPECT_EQ(OPENING_AMOUNT, database.getAmount(2));
+}
+
+TEST(Ch05OptimisticAccountDatabase, RejectsNestedTransactions) {
+    ch05::OptimisticAccountDatabase database{ACCOUNT_COUNT};
+    open(database);
+
+    EXPECT_THROW(database.transact([&database](ch05::Transaction &transaction) {
+        transaction.write(1, 0);
+        database.setAmount(2, 0);
+    }), std::logic_error);
+
+    // the outer transaction never committed, and the thread can start new ones
+    EXPECT_EQ(OPENING_AMOUNT, database.getAmount(1));
+    EXPECT_EQ(OPENING_AMOUNT, database.getAmount(2));
+    database.setAmount(1, 0);
+    EXPECT_EQ(0, database.getAmount(1));
+}
+
+TEST(Ch05OptimisticAccountDatabase, RejectsAccountsOutOfRange) {
+    ch05::OptimisticAccountDatabase database{ACCOUNT_COUNT};
+    open(database);
+
+    EXPECT_THROW(static_cast<void>(database.getAmount(-1)), std::out_of_range);
+    EXPECT_THROW(static_cast<void>(database.getAmount(ACCOUNT_COUNT)), std::out_of_range);
+    EXPECT_THROW(database.transfer(1, ACCOUNT_COUNT, 10), std::out_of_range);
+
+    // no leg of the rejected transfer was applied
+    EXPECT_EQ(OPENING_AMOUNT, database.getAmount(1));
+    EXPECT_EQ(ACCOUNT_COUNT * OPENING_AMOUNT, getTotal(database));
+}
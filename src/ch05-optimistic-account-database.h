@@ -0,0 +1,362 @@
+#ifndef CPPCRASHCOURSE_CH05_OPTIMISTIC_ACCOUNT_DATABASE_H
+#define CPPCRASHCOURSE_CH05_OPTIMISTIC_ACCOUNT_DATABASE_H
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "ch05.h"
+
+namespace ch05 {
+    class OptimisticAccountDatabase;
+
+    // The reads and buffered writes of one attempt. Reads see the value committed last, or the transaction's
+    // own pending write; nothing becomes visible to other threads before commit.
+    class Transaction {
+    public:
+        long long read(long account);
+
+        void write(long account, long long amount);
+
+    private:
+        friend class OptimisticAccountDatabase;
+
+        struct ReadEntry {
+            long account;
+            unsigned long long version;
+            long long amount;
+        };
+
+        struct WriteEntry {
+            long account;
+            long long amount;
+            unsigned long long lockedVersion;
+        };
+
+        // The entries of one attempt in the order they were added, found by account with a scan while there are
+        // few, as in a transfer, and through an open-addressing table of their positions once there are more, as
+        // in the addAmounts of a whole netted batch. The table is kept between attempts and at most half full.
+        template<typename Entry>
+        class Entries {
+        public:
+            std::vector<Entry> entries;
+
+            Entry *find(const long account) {
+                return const_cast<Entry *>(std::as_const(*this).find(account));
+            }
+
+            const Entry *find(const long account) const {
+                if (this->entries.size() <= SCAN_LIMIT) {
+                    for (const auto &entry: this->entries) {
+                        if (entry.account == account) {
+                            return &entry;
+                        }
+                    }
+
+                    return nullptr;
+                }
+
+                const auto mask = this->positions.size() - 1;
+                for (auto index = hash(account) & mask;; index = (index + 1) & mask) {
+                    const auto position = this->positions[index];
+                    if (position == 0) {
+                        return nullptr;
+                    }
+
+                    if (this->entries[position - 1].account == account) {
+                        return &this->entries[position - 1];
+                    }
+                }
+            }
+
+            // account must not be among the entries yet
+            void push_back(const Entry &entry) {
+                this->entries.push_back(entry);
+
+                const auto size = this->entries.size();
+                if (size <= SCAN_LIMIT) {
+                    return;
+                }
+
+                // the table still holds the positions of an earlier attempt when the scan limit is first passed
+                if (size == SCAN_LIMIT + 1 || 2 * size > this->positions.size()) {
+                    this->rebuild(std::max(this->positions.size(), std::bit_ceil(4 * size)));
+                } else {
+                    this->insert(size - 1);
+                }
+            }
+
+            void clear() {
+                this->entries.clear();
+            }
+
+        private:
+            static constexpr size_t SCAN_LIMIT{8};
+
+            // entry position + 1, 0 for an empty slot
+            std::vector<size_t> positions;
+
+            static size_t hash(const long account) {
+                auto hash = static_cast<unsigned long long>(account) * 0x9E3779B97F4A7C15ull;
+
+                return static_cast<size_t>(hash ^ (hash >> 32));
+            }
+
+            void rebuild(const size_t slotCount) {
+                this->positions.assign(slotCount, 0);
+                for (size_t position{}; position < this->entries.size(); position++) {
+                    this->insert(position);
+                }
+            }
+
+            void insert(const size_t position) {
+                const auto mask = this->positions.size() - 1;
+
+                auto index = hash(this->entries[position].account) & mask;
+                while (this->positions[index] != 0) {
+                    index = (index + 1) & mask;
+                }
+                this->positions[index] = position + 1;
+            }
+        };
+
+        OptimisticAccountDatabase *database{};
+        Entries<ReadEntry> reads;
+        Entries<WriteEntry> writes;
+        bool active{};
+    };
+
+    // Accounts 0 to accountCount - 1 in one array, each with a version word that is even while the account is
+    // unlocked and odd while a commit holds it. Transactions run without locks, remembering the version of every
+    // account they read; commit locks only the accounts written, checks that no account read has changed since,
+    // and otherwise drops the attempt and runs the transaction again. Disjoint transactions never wait for each
+    // other, and a hot account costs retries instead of a queue on one mutex.
+    class OptimisticAccountDatabase : public AccountDatabase {
+    public:
+        explicit OptimisticAccountDatabase(const size_t accountCount)
+                : accountCount{accountCount}, accounts{std::make_unique<Account[]>(accountCount)} {}
+
+        long long getAmount(const long account) const override {
+            return this->readConsistent(this->at(account)).amount;
+        }
+
+        void setAmount(const long account, const long long amount) override {
+            this->transact([account, amount](Transaction &transaction) {
+                transaction.write(account, amount);
+            });
+        }
+
+        void transfer(const long fromAccount, const long toAccount, const long long amount) override {
+            const AccountDelta legs[]{{fromAccount, -amount}, {toAccount, amount}};
+            this->transfer(legs);
+        }
+
+        // Moves money between any number of accounts at once; the legs must add up to zero. Returns the number
+        // of attempts it took.
+        unsigned transfer(const std::span<const AccountDelta> legs) {
+            long long sum{};
+            for (const auto &leg: legs) {
+                sum += leg.amount;
+            }
+            if (sum != 0) {
+                throw std::invalid_argument{"transfer legs add up to " + std::to_string(sum)};
+            }
+
+            return this->transact([legs](Transaction &transaction) {
+                for (const auto &leg: legs) {
+                    transaction.write(leg.account, transaction.read(leg.account) + leg.amount);
+                }
+            });
+        }
+
+        void addAmounts(const std::span<const AccountDelta> deltas) override {
+            this->transact([deltas](Transaction &transaction) {
+                for (const auto &delta: deltas) {
+                    transaction.write(delta.account, transaction.read(delta.account) + delta.amount);
+                }
+            });
+        }
+
+        // Runs body(transaction) until it commits and returns the number of attempts. The body may run more
+        // than once and may see accounts from different moments on an attempt that is going to be dropped, so
+        // it must not act on what it reads other than through transaction.write(). Transactions do not nest.
+        template<typename Body>
+        unsigned transact(Body &&body) {
+            auto &transaction = threadTransaction();
+            if (transaction.active) {
+                throw std::logic_error{"transactions do not nest"};
+            }
+
+            transaction.active = true;
+            transaction.database = this;
+
+            for (unsigned attempt{1};; attempt++) {
+                transaction.reads.clear();
+                transaction.writes.clear();
+
+                try {
+                    body(transaction);
+                } catch (...) {
+                    transaction.active = false;
+                    throw;
+                }
+
+                if (this->commit(transaction)) {
+                    transaction.active = false;
+                    return attempt;
+                }
+
+                backOff(attempt);
+            }
+        }
+
+        [[nodiscard]] size_t getAccountCount() const {
+            return this->accountCount;
+        }
+
+    private:
+        friend class Transaction;
+
+        struct alignas(16) Account {
+            std::atomic<unsigned long long> version{};
+            std::atomic<long long> amount{};
+        };
+
+        struct Snapshot {
+            unsigned long long version;
+            long long amount;
+        };
+
+        size_t accountCount;
+        std::unique_ptr<Account[]> accounts;
+
+        // One per thread, outside the transact template: every body type would otherwise get its own, and a
+        // transaction nested with a different body would go unnoticed.
+        static Transaction &threadTransaction() {
+            thread_local Transaction transaction{};
+            return transaction;
+        }
+
+        Account &at(const long account) const {
+            if (account < 0 || static_cast<size_t>(account) >= this->accountCount) {
+                throw std::out_of_range{"no account " + std::to_string(account)};
+            }
+
+            return this->accounts[static_cast<size_t>(account)];
+        }
+
+        // seqlock read: retried while a commit holds the account or committed in between
+        static Snapshot readConsistent(const Account &account) {
+            while (true) {
+                const auto version = account.version.load(std::memory_order_acquire);
+                const auto amount = account.amount.load(std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_acquire);
+
+                if (version % 2 == 0 && account.version.load(std::memory_order_relaxed) == version) {
+                    return Snapshot{version, amount};
+                }
+
+                std::this_thread::yield();
+            }
+        }
+
+        bool commit(Transaction &transaction) {
+            auto &writes = transaction.writes.entries;
+
+            // A held lock aborts the attempt instead of waiting, so the lock order does not matter for deadlock;
+            // two committers that keep aborting each other are pulled apart by backOff().
+            for (size_t locked{}; locked < writes.size(); locked++) {
+                auto &write = writes[locked];
+                auto &account = this->accounts[static_cast<size_t>(write.account)];
+
+                auto version = account.version.load(std::memory_order_relaxed);
+                const auto *read = transaction.reads.find(write.account);
+                if (version % 2 != 0 || (read != nullptr && read->version != version) ||
+                    !account.version.compare_exchange_strong(version, version + 1, std::memory_order_acquire,
+                                                             std::memory_order_relaxed)) {
+                    this->unlock(std::span{writes}.first(locked));
+                    return false;
+                }
+
+                write.lockedVersion = version;
+            }
+
+            // the accounts only read must still be at the versions the body saw
+            for (const auto &read: transaction.reads.entries) {
+                if (transaction.writes.find(read.account) != nullptr) {
+                    continue;
+                }
+
+                if (this->accounts[static_cast<size_t>(read.account)].version.load(std::memory_order_acquire) !=
+                    read.version) {
+                    this->unlock(writes);
+                    return false;
+                }
+            }
+
+            std::atomic_thread_fence(std::memory_order_release);
+            for (const auto &write: writes) {
+                auto &account = this->accounts[static_cast<size_t>(write.account)];
+                account.amount.store(write.amount, std::memory_order_relaxed);
+                account.version.store(write.lockedVersion + 2, std::memory_order_release);
+            }
+
+            return true;
+        }
+
+        // releases the locks without changing the versions, so readers see nothing happened
+        void unlock(const std::span<const Transaction::WriteEntry> writes) {
+            for (const auto &write: writes) {
+                this->accounts[static_cast<size_t>(write.account)].version.store(write.lockedVersion,
+                                                                                 std::memory_order_release);
+            }
+        }
+
+        // spins a little after the first aborts, then gives the core to whoever holds the account
+        static void backOff(const unsigned attempt) {
+            if (attempt < 4) {
+                for (unsigned i{}; i < (1u << (4 * attempt)); i++) {
+                    std::atomic_signal_fence(std::memory_order_seq_cst);
+                }
+                return;
+            }
+
+            std::this_thread::yield();
+        }
+    };
+
+    inline void Transaction::write(const long account, const long long amount) {
+        if (auto *entry = this->writes.find(account); entry != nullptr) {
+            entry->amount = amount;
+            return;
+        }
+
+        // checked here, so commit never finds a bad account while it holds locks
+        this->database->at(account);
+        this->writes.push_back(WriteEntry{account, amount, 0});
+    }
+
+    inline long long Transaction::read(const long account) {
+        if (const auto *entry = this->writes.find(account); entry != nullptr) {
+            return entry->amount;
+        }
+
+        if (const auto *entry = this->reads.find(account); entry != nullptr) {
+            return entry->amount;
+        }
+
+        const auto snapshot = OptimisticAccountDatabase::readConsistent(this->database->at(account));
+        this->reads.push_back(ReadEntry{account, snapshot.version, snapshot.amount});
+
+        return snapshot.amount;
+    }
+}
+
+#endif //CPPCRASHCOURSE_CH05_OPTIMISTIC_ACCOUNT_DATABASE_H
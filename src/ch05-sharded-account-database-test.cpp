@@ -0,0 +1,103 @@
+#include <set>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "ch05-sharded-account-database.h"
+
+namespace {
+    // The database's own shard choice, repeated here to pick accounts in the same or in different shards.
+    // Should it change, these tests still pass; they just stop aiming at those cases.
+    size_t shardOf(const long account, const size_t shardCount) {
+        const auto hash = static_cast<unsigned long long>(account) * 0x9E3779B97F4A7C15ull;
+        return (hash >> 32) & (shardCount - 1);
+    }
+
+    // the first two accounts from 1 on whose shards are (or are not) the same
+    std::pair<long, long> accountPair(const size_t shardCount, const bool sameShard) {
+        for (long second{2};; second++) {
+            if ((shardOf(1, shardCount) == shardOf(second, shardCount)) == sameShard) {
+                return {1, second};
+            }
+        }
+    }
+}
+
+TEST(Ch05ShardedAccountDatabase, RoundsTheShardCountUpToAPowerOfTwo) {
+    EXPECT_EQ(1u, ch05::ShardedAccountDatabase{0}.getShardCount());
+    EXPECT_EQ(1u, ch05::ShardedAccountDatabase{1}.getShardCount());
+    EXPECT_EQ(8u, ch05::ShardedAccountDatabase{5}.getShardCount());
+    EXPECT_GE(ch05::ShardedAccountDatabase{}.getShardCount(), 1u);
+}
+
+TEST(Ch05ShardedAccountDatabase, TransfersWithinOneShard) {
+    ch05::ShardedAccountDatabase database{8};
+    const auto [from, to] = accountPair(8, true);
+    database.setAmount(from, 100);
+    database.setAmount(to, 5);
+
+    database.transfer(from, to, 30);
+    database.transfer(from, from, 1000);
+
+    EXPECT_EQ(70, database.getAmount(from));
+    EXPECT_EQ(35, database.getAmount(to));
+}
+
+TEST(Ch05ShardedAccountDatabase, TransfersCreateTheirAccounts) {
+    ch05::ShardedAccountDatabase database{8};
+    const auto [from, to] = accountPair(8, false);
+
+    database.transfer(from, to, 30);
+
+    EXPECT_EQ(-30, database.getAmount(from));
+    EXPECT_EQ(30, database.getAmount(to));
+}
+
+TEST(Ch05ShardedAccountDatabase, AddsAmountsAcrossShards) {
+    constexpr size_t shardCount{4};
+    ch05::ShardedAccountDatabase database{shardCount};
+    database.setAmount(3, 100);
+
+    std::vector<ch05::AccountDelta> deltas{};
+    std::set<size_t> shards{};
+    for (long account{}; account < 32; account++) {
+        deltas.push_back(ch05::AccountDelta{account, account * 10 - 5});
+        shards.insert(shardOf(account, shardCount));
+    }
+    deltas.push_back(ch05::AccountDelta{3, 1});
+    ASSERT_EQ(shardCount, shards.size());
+
+    database.addAmounts(deltas);
+
+    for (long account{}; account < 32; account++) {
+        EXPECT_EQ(account * 10 - 5 + (account == 3 ? 101 : 0), database.getAmount(account)) << "account " << account;
+    }
+}
+
+TEST(Ch05ShardedAccountDatabase, OppositeTransfersKeepTheTotalWithoutDeadlock) {
+    constexpr int transferCount{200'000};
+    ch05::ShardedAccountDatabase database{8};
+    const auto [first, second] = accountPair(8, false);
+    database.setAmount(first, 1000);
+    database.setAmount(second, 1000);
+
+    // each thread holds one shard and wants the other's, the interleaving in which unordered locking deadlocks
+    std::thread forward{[&database, first, second] {
+        for (int i{}; i < transferCount; i++) {
+            database.transfer(first, second, 3);
+        }
+    }};
+    std::thread backward{[&database, first, second] {
+        for (int i{}; i < transferCount; i++) {
+            database.transfer(second, first, 3);
+        }
+    }};
+
+    forward.join();
+    backward.join();
+
+    EXPECT_EQ(1000, database.getAmount(first));
+    EXPECT_EQ(1000, database.getAmount(second));
+}
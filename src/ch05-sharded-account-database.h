@@ -0,0 +1,103 @@
+#ifndef CPPCRASHCOURSE_CH05_SHARDED_ACCOUNT_DATABASE_H
+#define CPPCRASHCOURSE_CH05_SHARDED_ACCOUNT_DATABASE_H
+
+#include <bit>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <unordered_map>
+
+#include "ch05.h"
+
+namespace ch05 {
+    // Splits the accounts over a power-of-two number of independently locked shards, so transfers
+    // touching different shards can run on different threads.
+    class ShardedAccountDatabase : public AccountDatabase {
+    public:
+        explicit ShardedAccountDatabase(const size_t shardCount = 4 * std::thread::hardware_concurrency())
+                : shardMask{std::bit_ceil(shardCount < 1 ? 1 : shardCount) - 1},
+                  shards{std::make_unique<Shard[]>(shardMask + 1)} {}
+
+        long long getAmount(const long account) const override {
+            const auto &shard = this->shardFor(account);
+            std::lock_guard lock{shard.mutex};
+
+            return find(shard, account);
+        }
+
+        void setAmount(const long account, const long long amount) override {
+            auto &shard = this->shardFor(account);
+            std::lock_guard lock{shard.mutex};
+
+            shard.accounts[account] = amount;
+        }
+
+        void transfer(const long fromAccount, const long toAccount, const long long amount) override {
+            auto &fromShard = this->shardFor(fromAccount);
+            auto &toShard = this->shardFor(toAccount);
+
+            if (&fromShard == &toShard) {
+                std::lock_guard lock{fromShard.mutex};
+
+                apply(fromShard, fromAccount, toShard, toAccount, amount);
+                return;
+            }
+
+            // always lock the shard with the lower address first, so two opposite transfers cannot deadlock
+            auto &first = &fromShard < &toShard ? fromShard : toShard;
+            auto &second = &fromShard < &toShard ? toShard : fromShard;
+
+            std::lock_guard firstLock{first.mutex};
+            std::lock_guard secondLock{second.mutex};
+
+            apply(fromShard, fromAccount, toShard, toAccount, amount);
+        }
+
+        void addAmounts(const std::span<const AccountDelta> deltas) override {
+            for (const auto &delta: deltas) {
+                auto &shard = this->shardFor(delta.account);
+                std::lock_guard lock{shard.mutex};
+
+                shard.accounts[delta.account] += delta.amount;
+            }
+        }
+
+        [[nodiscard]] size_t getShardCount() const {
+            return this->shardMask + 1;
+        }
+
+    private:
+        struct alignas(64) Shard {
+            mutable std::mutex mutex;
+            std::unordered_map<long, long long> accounts;
+        };
+
+        size_t shardMask;
+        std::unique_ptr<Shard[]> shards;
+
+        Shard &shardFor(const long account) const {
+            // fibonacci hashing, so sequential account ids still spread over all shards
+            const auto hash = static_cast<unsigned long long>(account) * 0x9E3779B97F4A7C15ull;
+
+            return this->shards[(hash >> 32) & this->shardMask];
+        }
+
+        static long long find(const Shard &shard, const long account) {
+            auto it = shard.accounts.find(account);
+            if (it == shard.accounts.end()) {
+                return 0;
+            }
+
+            return it->second;
+        }
+
+        static void apply(Shard &fromShard, const long fromAccount, Shard &toShard, const long toAccount,
+                          const long long amount) {
+            fromShard.accounts[fromAccount] -= amount;
+            toShard.accounts[toAccount] += amount;
+        }
+    };
+}
+
+#endif //CPPCRASHCOURSE_CH05_SHARDED_ACCOUNT_DATABASE_H
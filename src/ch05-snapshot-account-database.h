@@ -0,0 +1,64 @@
+#ifndef CPPCRASHCOURSE_CH05_SNAPSHOT_ACCOUNT_DATABASE_H
+#define CPPCRASHCOURSE_CH05_SNAPSHOT_ACCOUNT_DATABASE_H
+
+#include <mutex>
+#include <span>
+
+#include "ch05.h"
+#include "ch05-account-trie.h"
+
+namespace ch05 {
+    // Balances in a persistent trie behind a mutex held only for single lookups and updates. snapshot() hands
+    // out a consistent read-only view in O(1) that other threads can scan, in parallel if they like, while
+    // transfers go on.
+    //
+    // That costs every lookup a mutex and a walk of three to four trie nodes where InMemoryAccountDatabase hashes
+    // once into one table; BM_SnapshotLookup and BM_InMemoryLookup measure the difference. Use it where readers
+    // need a consistent view of all balances, and InMemoryAccountDatabase otherwise.
+    class SnapshotAccountDatabase : public AccountDatabase {
+    public:
+        long long getAmount(const long account) const override {
+            std::lock_guard lock{this->mutex};
+
+            const auto *entry = this->accounts.find(account);
+            if (entry == nullptr) {
+                return 0;
+            }
+
+            return entry->amount;
+        }
+
+        void setAmount(const long account, const long long amount) override {
+            std::lock_guard lock{this->mutex};
+
+            this->accounts.findOrInsert(account) = amount;
+        }
+
+        void transfer(const long fromAccount, const long toAccount, const long long amount) override {
+            std::lock_guard lock{this->mutex};
+
+            this->accounts.findOrInsert(fromAccount) -= amount;
+            this->accounts.findOrInsert(toAccount) += amount;
+        }
+
+        void addAmounts(const std::span<const AccountDelta> deltas) override {
+            std::lock_guard lock{this->mutex};
+
+            for (const auto &delta: deltas) {
+                this->accounts.findOrInsert(delta.account) += delta.amount;
+            }
+        }
+
+        [[nodiscard]] AccountSnapshot snapshot() const {
+            std::lock_guard lock{this->mutex};
+
+            return this->accounts.snapshot();
+        }
+
+    private:
+        mutable std::mutex mutex;
+        AccountTrie accounts;
+    };
+}
+
+#endif //CPPCRASHCOURSE_CH05_SNAPSHOT_ACCOUNT_DATABASE_H
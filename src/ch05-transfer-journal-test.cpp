@@ -0,0 +1,296 @@
+#include <csignal>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <sys/resource.h>
+
+#include "gtest/gtest.h"
+
+#include "ch05-transfer-journal.h"
+
+namespace {
+    std::string journalPath() {
+        return (std::filesystem::temp_directory_path() / "ch05-transfer-journal-test.bin").string();
+    }
+
+    const std::vector<ch05::Transfer> TRANSFERS{
+            {1, 2, 100},
+            {2, 1, 50},
+            {1'000'000, 7, -3},
+            {-5, 5, 0},
+            {std::numeric_limits<long>::max(), std::numeric_limits<long>::min(), std::numeric_limits<long long>::max()},
+            {std::numeric_limits<long>::min(), 0, std::numeric_limits<long long>::min()},
+            {42, 42, 1},
+    };
+
+    std::vector<ch05::JournalRecord> readAll(const ch05::TransferJournalReader &reader) {
+        std::vector<ch05::JournalRecord> records{};
+        reader.forEach([&records](const ch05::JournalRecord &record) {
+            records.push_back(record);
+        });
+
+        return records;
+    }
+
+    void expectTransfers(const std::vector<ch05::JournalRecord> &records, const size_t count) {
+        ASSERT_EQ(count, records.size());
+        for (size_t i{}; i < count; i++) {
+            const auto &transfer = TRANSFERS[i % TRANSFERS.size()];
+            EXPECT_EQ(transfer.fromAccount, records[i].fromAccount);
+            EXPECT_EQ(transfer.toAccount, records[i].toAccount);
+            EXPECT_EQ(transfer.amount, records[i].amount);
+        }
+    }
+}
+
+TEST(Ch05TransferJournal, LogsBankTransfers) {
+    ch05::InMemoryAccountDatabase database{};
+    ch05::Bank bank{database};
+    {
+        ch05::TransferJournal journal{journalPath()};
+        bank.setLogger(&journal);
+        bank.transfer(1, 2, 100);
+        bank.transfer(2, 1, 50);
+        bank.setLogger(nullptr);
+    }
+
+    const ch05::TransferJournalReader reader{journalPath()};
+    const auto records = readAll(reader);
+    ASSERT_EQ(2u, records.size());
+    EXPECT_EQ((ch05::JournalRecord{records[0].timestamp, 1, 2, 100}), records[0]);
+    EXPECT_EQ((ch05::JournalRecord{records[1].timestamp, 2, 1, 50}), records[1]);
+    EXPECT_LE(records[0].timestamp, records[1].timestamp);
+
+    std::filesystem::remove(journalPath());
+}
+
+TEST(Ch05TransferJournal, RoundTripsAnyTransfer) {
+    {
+        ch05::TransferJournal journal{journalPath(), 3};
+        for (const auto &transfer: TRANSFERS) {
+            journal.transfer(transfer.fromAccount, transfer.toAccount, transfer.amount);
+        }
+    }
+
+    const ch05::TransferJournalReader reader{journalPath()};
+    EXPECT_TRUE(reader.isComplete());
+    EXPECT_EQ(3u, reader.getBlocks().size());
+    EXPECT_EQ(TRANSFERS.size(), reader.getRecordCount());
+
+    const auto records = readAll(reader);
+    expectTransfers(records, TRANSFERS.size());
+    EXPECT_EQ(reader.getBlocks()[1].firstTimestamp, records[3].timestamp);
+
+    std::filesystem::remove(journalPath());
+}
+
+TEST(Ch05TransferJournal, BatchSharesOneTimestamp) {
+    {
+        ch05::TransferJournal journal{journalPath(), 4};
+        journal.transferBatch(TRANSFERS);
+    }
+
+    const ch05::TransferJournalReader reader{journalPath()};
+    const auto records = readAll(reader);
+    expectTransfers(records, TRANSFERS.size());
+    for (const auto &record: records) {
+        EXPECT_EQ(records.front().timestamp, record.timestamp);
+    }
+
+    // both blocks start at that timestamp, so a search for it must start at the first
+    EXPECT_EQ(0u, reader.findBlock(records.front().timestamp));
+
+    std::filesystem::remove(journalPath());
+}
+
+TEST(Ch05TransferJournal, BlockBytesPointIntoTheFile) {
+    {
+        ch05::TransferJournal journal{journalPath(), 2};
+        journal.transferBatch(TRANSFERS);
+        journal.close();
+        EXPECT_THROW(journal.transfer(1, 2, 3), std::logic_error);
+    }
+
+    const ch05::TransferJournalReader reader{journalPath()};
+    const auto blocks = reader.getBlocks();
+    ASSERT_EQ(4u, blocks.size());
+
+    for (size_t i{1}; i < blocks.size(); i++) {
+        const auto previous = reader.getBlockBytes(blocks[i - 1]);
+        EXPECT_LT(previous.data(), reader.getBlockBytes(blocks[i]).data());
+        EXPECT_EQ(blocks[i - 1].offset + sizeof(ch05::journal::BlockHeader) + previous.size(), blocks[i].offset);
+    }
+
+    std::filesystem::remove(journalPath());
+}
+
+TEST(Ch05TransferJournal, ReadsUnclosedJournalUpToTheLastCompleteBlock) {
+    {
+        ch05::TransferJournal journal{journalPath(), 2};
+        journal.transferBatch(TRANSFERS);
+    }
+
+    unsigned long long lastBlock{};
+    {
+        const ch05::TransferJournalReader reader{journalPath()};
+        lastBlock = reader.getBlocks().back().offset;
+    }
+
+    // the trailer, the index and the end of the last block never made it to disk
+    std::filesystem::resize_file(journalPath(), lastBlock + sizeof(ch05::journal::BlockHeader) + 1);
+
+    const ch05::TransferJournalReader reader{journalPath()};
+    EXPECT_FALSE(reader.isComplete());
+    EXPECT_EQ(3u, reader.getBlocks().size());
+    expectTransfers(readAll(reader), 6);
+
+    std::filesystem::remove(journalPath());
+}
+
+TEST(Ch05TransferJournal, RejectsOtherFiles) {
+    {
+        std::ofstream file{journalPath()};
+        file << "consoleLogger: transfer from account: 1 to account: 2 amount: 100\n";
+    }
+
+    EXPECT_THROW(ch05::TransferJournalReader{journalPath()}, std::runtime_error);
+
+    std::filesystem::remove(journalPath());
+}
+
+namespace {
+    // overwrites the file at offset with value
+    template<typename T>
+    void patch(const unsigned long long offset, const T &value) {
+        std::fstream file{journalPath(), std::ios::in | std::ios::out | std::ios::binary};
+        file.seekp(static_cast<std::streamoff>(offset));
+        file.write(reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+
+    std::vector<ch05::JournalBlock> closedJournalBlocks() {
+        {
+            ch05::TransferJournal journal{journalPath(), 2};
+            journal.transferBatch(TRANSFERS);
+        }
+
+        const ch05::TransferJournalReader reader{journalPath()};
+        const auto blocks = reader.getBlocks();
+        return {blocks.begin(), blocks.end()};
+    }
+
+    unsigned long long indexOffset() {
+        const auto size = std::filesystem::file_size(journalPath());
+        return size - sizeof(ch05::journal::Trailer) - 4 * sizeof(ch05::JournalBlock);
+    }
+}
+
+TEST(Ch05TransferJournal, RebuildsADamagedIndexFromTheBlocks) {
+    const auto blocks = closedJournalBlocks();
+    ASSERT_EQ(4u, blocks.size());
+
+    // the second entry points far beyond the end of the file
+    auto damaged = blocks[1];
+    damaged.offset = 1ull << 40;
+    patch(indexOffset() + sizeof(ch05::JournalBlock), damaged);
+
+    const ch05::TransferJournalReader reader{journalPath()};
+    EXPECT_FALSE(reader.isComplete());
+    ASSERT_EQ(4u, reader.getBlocks().size());
+    EXPECT_EQ(blocks[1].offset, reader.getBlocks()[1].offset);
+    expectTransfers(readAll(reader), TRANSFERS.size());
+
+    std::filesystem::remove(journalPath());
+}
+
+TEST(Ch05TransferJournal, StopsAtADamagedBlockOfAClosedFile) {
+    const auto blocks = closedJournalBlocks();
+
+    // a byte of the third block's records, which its checksum no longer matches
+    patch(blocks[2].offset + sizeof(ch05::journal::BlockHeader), std::byte{0xFF});
+
+    const ch05::TransferJournalReader reader{journalPath()};
+    EXPECT_FALSE(reader.isComplete());
+    EXPECT_EQ(2u, reader.getBlocks().size());
+    expectTransfers(readAll(reader), 4);
+
+    std::filesystem::remove(journalPath());
+}
+
+TEST(Ch05TransferJournal, RejectsBlocksOutsideTheFile) {
+    const auto blocks = closedJournalBlocks();
+    const ch05::TransferJournalReader reader{journalPath()};
+
+    EXPECT_THROW(static_cast<void>(reader.getBlockBytes(ch05::JournalBlock{1ull << 40, 0, 2})), std::out_of_range);
+    EXPECT_THROW(reader.forEachInBlock(ch05::JournalBlock{blocks[1].offset + 1, 0, 2}, [](const auto &) {}),
+                 std::out_of_range);
+
+    std::filesystem::remove(journalPath());
+}
+
+namespace {
+    // Caps the size of every file the process writes while it lives; a write past the cap is cut short, as on a
+    // full disk, instead of raising SIGXFSZ.
+    class FileSizeLimit {
+    public:
+        explicit FileSizeLimit(const rlim_t size) {
+            ::getrlimit(RLIMIT_FSIZE, &this->previous);
+            this->handler = std::signal(SIGXFSZ, SIG_IGN);
+
+            rlimit limit{size, this->previous.rlim_max};
+            ::setrlimit(RLIMIT_FSIZE, &limit);
+        }
+
+        ~FileSizeLimit() {
+            ::setrlimit(RLIMIT_FSIZE, &this->previous);
+            std::signal(SIGXFSZ, this->handler);
+        }
+
+        FileSizeLimit(const FileSizeLimit &) = delete;
+
+        FileSizeLimit &operator=(const FileSizeLimit &) = delete;
+
+    private:
+        rlimit previous{};
+        void (*handler)(int){};
+    };
+}
+
+TEST(Ch05TransferJournal, CutsAFailedBlockOffAndRetriesIt) {
+    {
+        ch05::TransferJournal journal{journalPath(), 3};
+        for (size_t i{}; i < 5; i++) {
+            journal.transfer(TRANSFERS[i].fromAccount, TRANSFERS[i].toAccount, TRANSFERS[i].amount);
+        }
+        const auto size = journal.getSize();
+
+        {
+            // room for part of the second block's header only
+            const FileSizeLimit limit{size + 10};
+
+            // the record fills the block, which is kept when its write fails
+            EXPECT_THROW(journal.transfer(TRANSFERS[5].fromAccount, TRANSFERS[5].toAccount, TRANSFERS[5].amount),
+                         std::system_error);
+            EXPECT_EQ(size, std::filesystem::file_size(journalPath()));
+            EXPECT_EQ(size, journal.getSize());
+
+            // the full block is written again first, and the record is not taken while that fails
+            EXPECT_THROW(journal.transfer(TRANSFERS[6].fromAccount, TRANSFERS[6].toAccount, TRANSFERS[6].amount),
+                         std::system_error);
+            EXPECT_EQ(size, std::filesystem::file_size(journalPath()));
+        }
+
+        journal.transfer(TRANSFERS[6].fromAccount, TRANSFERS[6].toAccount, TRANSFERS[6].amount);
+    }
+
+    const ch05::TransferJournalReader reader{journalPath()};
+    EXPECT_TRUE(reader.isComplete());
+    EXPECT_EQ(3u, reader.getBlocks().size());
+    expectTransfers(readAll(reader), TRANSFERS.size());
+
+    std::filesystem::remove(journalPath());
+}
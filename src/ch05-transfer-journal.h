@@ -0,0 +1,527 @@
+#ifndef CPPCRASHCOURSE_CH05_TRANSFER_JOURNAL_H
+#define CPPCRASHCOURSE_CH05_TRANSFER_JOURNAL_H
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "ch05.h"
+
+// The journal file is a header, then blocks of transfers, then an index of the blocks and a trailer:
+//
+//   FileHeader | BlockHeader bytes | BlockHeader bytes | ... | padding | JournalBlock[blockCount] | Trailer
+//
+// Inside a block every record is four varints: the zigzagged differences of the timestamp and the from account
+// to those of the record before, the to account as a difference to the from account, and the zigzagged amount.
+// The first record of a block is relative to zero, so every block decodes on its own. A file without a trailer,
+// left by a writer that never closed it, or whose index does not match its blocks, is read up to its last intact
+// block.
+
+namespace ch05 {
+    struct JournalRecord {
+        long long timestamp;
+        long fromAccount;
+        long toAccount;
+        long long amount;
+
+        bool operator==(const JournalRecord &) const = default;
+    };
+
+    // one entry of the block index, also used for the index rebuilt from an unclosed file
+    struct JournalBlock {
+        unsigned long long offset;
+        long long firstTimestamp;
+        unsigned long long recordCount;
+    };
+
+    namespace journal {
+        constexpr char MAGIC[8] = {'c', 'h', '0', '5', 'j', 'r', 'n', 'l'};
+
+        struct FileHeader {
+            char magic[8];
+            unsigned long long version;
+        };
+
+        struct BlockHeader {
+            unsigned long long recordCount;
+            unsigned long long byteCount;
+            long long firstTimestamp;
+            unsigned long long checksum;
+        };
+
+        struct Trailer {
+            unsigned long long indexOffset;
+            unsigned long long blockCount;
+            char magic[8];
+        };
+
+        // ten bytes hold any 64-bit varint
+        constexpr size_t MAX_VARINT = 10;
+
+        inline unsigned long long zigzag(const long long value) {
+            return (static_cast<unsigned long long>(value) << 1) ^ static_cast<unsigned long long>(value >> 63);
+        }
+
+        inline long long unzigzag(const unsigned long long value) {
+            return static_cast<long long>(value >> 1) ^ -static_cast<long long>(value & 1);
+        }
+
+        inline std::byte *writeVarint(std::byte *out, unsigned long long value) {
+            while (value >= 0x80) {
+                *out++ = static_cast<std::byte>(value | 0x80);
+                value >>= 7;
+            }
+            *out++ = static_cast<std::byte>(value);
+
+            return out;
+        }
+
+        inline unsigned long long readVarint(const std::byte *&in, const std::byte *end) {
+            unsigned long long value{};
+            for (unsigned shift{}; shift < 64 && in != end; shift += 7) {
+                const auto byte = static_cast<unsigned long long>(*in++);
+                value |= (byte & 0x7F) << shift;
+                if (byte < 0x80) {
+                    return value;
+                }
+            }
+
+            throw std::runtime_error{"journal block is corrupt"};
+        }
+
+        inline unsigned long long checksum(const std::span<const std::byte> bytes) {
+            auto checksum = 0xCBF29CE484222325ull;
+            for (const auto byte: bytes) {
+                checksum = (checksum ^ static_cast<unsigned char>(byte)) * 0x100000001B3ull;
+            }
+
+            return checksum;
+        }
+    }
+
+    // Appends every transfer to a binary journal, a block of blockSize records at a time with one writev.
+    // Records carry the wall-clock time in nanoseconds at which they were logged. The index and trailer are
+    // written by close(), or by the destructor if close() was not called. A write that fails is cut off the file
+    // again; a full block that could not be written is kept and written before the next record is taken.
+    class TransferJournal : public Logger {
+    public:
+        explicit TransferJournal(const std::string &path, const size_t blockSize = 4096)
+                : blockSize{blockSize < 1 ? 1 : blockSize} {
+            this->fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if (this->fd < 0) {
+                throw std::system_error{errno, std::generic_category(), "open " + path};
+            }
+
+            journal::FileHeader header{};
+            std::memcpy(header.magic, journal::MAGIC, sizeof(journal::MAGIC));
+            header.version = 1;
+
+            try {
+                this->writeAll(std::as_bytes(std::span{&header, 1}));
+            } catch (...) {
+                ::close(this->fd);
+                throw;
+            }
+
+            this->block.resize(this->blockSize * 4 * journal::MAX_VARINT);
+        }
+
+        ~TransferJournal() override {
+            try {
+                this->close();
+            } catch (const std::system_error &) {
+                // the blocks already written are still readable without the index
+            }
+
+            if (this->fd >= 0) {
+                ::close(this->fd);
+            }
+        }
+
+        TransferJournal(const TransferJournal &) = delete;
+
+        TransferJournal &operator=(const TransferJournal &) = delete;
+
+        void transfer(const long fromAccount, const long toAccount, const long long amount) const override {
+            std::lock_guard lock{this->mutex};
+
+            this->append(JournalRecord{now(), fromAccount, toAccount, amount});
+        }
+
+        // one timestamp for the whole batch
+        void transferBatch(const std::span<const Transfer> transfers) const override {
+            std::lock_guard lock{this->mutex};
+
+            const auto timestamp = now();
+            for (const auto &transfer: transfers) {
+                this->append(JournalRecord{timestamp, transfer.fromAccount, transfer.toAccount, transfer.amount});
+            }
+        }
+
+        // Writes out the last block, the index and the trailer; the journal takes no records afterwards.
+        void close() {
+            std::lock_guard lock{this->mutex};
+            if (this->closed) {
+                return;
+            }
+
+            this->flushBlock();
+
+            const auto padding = (8 - this->offset % 8) % 8;
+            const char zeros[8]{};
+            this->writeAll(std::as_bytes(std::span{zeros, padding}));
+
+            journal::Trailer trailer{this->offset, this->index.size(), {}};
+            std::memcpy(trailer.magic, journal::MAGIC, sizeof(journal::MAGIC));
+
+            this->writeAll(std::as_bytes(std::span{this->index}));
+            this->writeAll(std::as_bytes(std::span{&trailer, 1}));
+            this->closed = true;
+        }
+
+        // bytes in the file so far, not counting the block being filled
+        [[nodiscard]] unsigned long long getSize() const {
+            std::lock_guard lock{this->mutex};
+
+            return this->offset;
+        }
+
+    private:
+        int fd{-1};
+        size_t blockSize;
+
+        mutable std::mutex mutex;
+        mutable std::vector<std::byte> block;
+        mutable size_t blockBytes{};
+        mutable unsigned long long recordCount{};
+        mutable long long firstTimestamp{};
+        mutable JournalRecord previous{};
+        mutable std::vector<JournalBlock> index;
+        mutable unsigned long long offset{};
+        mutable bool closed{};
+
+        static long long now() {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::system_clock::now().time_since_epoch()).count();
+        }
+
+        void append(const JournalRecord &record) const {
+            if (this->closed) {
+                throw std::logic_error{"transfer journal is closed"};
+            }
+
+            // a full block whose write failed is retried before it takes another record
+            if (this->recordCount >= this->blockSize) {
+                this->flushBlock();
+            }
+
+            if (this->recordCount == 0) {
+                this->firstTimestamp = record.timestamp;
+                this->previous = JournalRecord{};
+            }
+
+            // unsigned differences, so no account or timestamp pair can overflow
+            const auto difference = [](const long long value, const long long base) {
+                return static_cast<long long>(static_cast<unsigned long long>(value) -
+                                              static_cast<unsigned long long>(base));
+            };
+
+            auto *out = this->block.data() + this->blockBytes;
+            out = journal::writeVarint(out, journal::zigzag(difference(record.timestamp, this->previous.timestamp)));
+            out = journal::writeVarint(out, journal::zigzag(difference(record.fromAccount,
+                                                                       this->previous.fromAccount)));
+            out = journal::writeVarint(out, journal::zigzag(difference(record.toAccount, record.fromAccount)));
+            out = journal::writeVarint(out, journal::zigzag(record.amount));
+
+            this->blockBytes = static_cast<size_t>(out - this->block.data());
+            this->previous = record;
+
+            if (++this->recordCount >= this->blockSize) {
+                this->flushBlock();
+            }
+        }
+
+        void flushBlock() const {
+            if (this->recordCount == 0) {
+                return;
+            }
+
+            const std::span<const std::byte> bytes{this->block.data(), this->blockBytes};
+            journal::BlockHeader header{this->recordCount, bytes.size(), this->firstTimestamp,
+                                        journal::checksum(bytes)};
+
+            iovec parts[2]{{&header, sizeof(header)}, {this->block.data(), bytes.size()}};
+            const auto length = sizeof(header) + bytes.size();
+            const auto written = ::pwritev(this->fd, parts, 2, static_cast<off_t>(this->offset));
+            if (written != static_cast<ssize_t>(length)) {
+                // a short write sets no errno
+                this->rollBack(written < 0 ? errno : ENOSPC, "pwritev");
+            }
+
+            this->index.push_back(JournalBlock{this->offset, this->firstTimestamp, this->recordCount});
+            this->offset += length;
+            this->blockBytes = 0;
+            this->recordCount = 0;
+        }
+
+        void writeAll(const std::span<const std::byte> bytes) const {
+            const auto written = ::pwrite(this->fd, bytes.data(), bytes.size(), static_cast<off_t>(this->offset));
+            if (written != static_cast<ssize_t>(bytes.size())) {
+                this->rollBack(written < 0 ? errno : ENOSPC, "pwrite");
+            }
+
+            this->offset += bytes.size();
+        }
+
+        // Cuts a short or failed write off the file and throws; offset and the block being filled are left as
+        // they were, so the same write can be retried and every index entry still points at its block.
+        [[noreturn]] void rollBack(const int error, const char *what) const {
+            if (::ftruncate(this->fd, static_cast<off_t>(this->offset)) != 0) {
+                throw std::system_error{errno, std::generic_category(), "ftruncate"};
+            }
+
+            throw std::system_error{error, std::generic_category(), what};
+        }
+    };
+
+    // Maps a journal read-only. The block index and every block's encoded bytes are spans into the mapping;
+    // records are decoded on the fly as they are visited, never copied into a buffer.
+    class TransferJournalReader {
+    public:
+        explicit TransferJournalReader(const std::string &path) {
+            const auto fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0) {
+                throw std::system_error{errno, std::generic_category(), "open " + path};
+            }
+
+            struct stat status{};
+            if (::fstat(fd, &status) != 0) {
+                const auto error = errno;
+                ::close(fd);
+                throw std::system_error{error, std::generic_category(), "fstat"};
+            }
+
+            this->mappingSize = static_cast<size_t>(status.st_size);
+            if (this->mappingSize > 0) {
+                auto *mapping = ::mmap(nullptr, this->mappingSize, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (mapping == MAP_FAILED) {
+                    const auto error = errno;
+                    ::close(fd);
+                    throw std::system_error{error, std::generic_category(), "mmap"};
+                }
+                this->mapping = static_cast<const std::byte *>(mapping);
+            }
+            ::close(fd);
+
+            try {
+                this->open();
+            } catch (...) {
+                this->unmap();
+                throw;
+            }
+        }
+
+        ~TransferJournalReader() {
+            this->unmap();
+        }
+
+        TransferJournalReader(const TransferJournalReader &) = delete;
+
+        TransferJournalReader &operator=(const TransferJournalReader &) = delete;
+
+        [[nodiscard]] std::span<const JournalBlock> getBlocks() const {
+            return this->blocks;
+        }
+
+        // the encoded records of block, straight from the mapping
+        [[nodiscard]] std::span<const std::byte> getBlockBytes(const JournalBlock &block) const {
+            const auto header = this->findBlockHeader(block.offset, this->mappingSize);
+            if (!header || header->recordCount != block.recordCount) {
+                throw std::out_of_range{"no journal block at offset " + std::to_string(block.offset)};
+            }
+
+            return {this->mapping + block.offset + sizeof(journal::BlockHeader), header->byteCount};
+        }
+
+        // the first block that can hold records logged at timestamp or later: the one before the first block
+        // starting at timestamp or later, since it may run past it
+        [[nodiscard]] size_t findBlock(const long long timestamp) const {
+            const auto it = std::lower_bound(this->blocks.begin(), this->blocks.end(), timestamp,
+                                             [](const JournalBlock &block, const long long value) {
+                                                 return block.firstTimestamp < value;
+                                             });
+
+            return it == this->blocks.begin() ? 0 : static_cast<size_t>(it - this->blocks.begin()) - 1;
+        }
+
+        // true when the file was closed properly and its index checks out, false when the index was rebuilt from
+        // the blocks
+        [[nodiscard]] bool isComplete() const {
+            return this->complete;
+        }
+
+        [[nodiscard]] unsigned long long getRecordCount() const {
+            unsigned long long count{};
+            for (const auto &block: this->blocks) {
+                count += block.recordCount;
+            }
+
+            return count;
+        }
+
+        // calls visitor(record) for every record of block, in the order they were logged
+        template<typename Visitor>
+        void forEachInBlock(const JournalBlock &block, Visitor &&visitor) const {
+            const auto bytes = this->getBlockBytes(block);
+            const auto *in = bytes.data();
+            const auto *end = in + bytes.size();
+
+            JournalRecord record{};
+            for (unsigned long long i{}; i < block.recordCount; i++) {
+                const auto add = [](const long long base, const unsigned long long encoded) {
+                    return static_cast<long long>(static_cast<unsigned long long>(base) +
+                                                  static_cast<unsigned long long>(journal::unzigzag(encoded)));
+                };
+
+                record.timestamp = add(record.timestamp, journal::readVarint(in, end));
+                record.fromAccount = static_cast<long>(add(record.fromAccount, journal::readVarint(in, end)));
+                record.toAccount = static_cast<long>(add(record.fromAccount, journal::readVarint(in, end)));
+                record.amount = journal::unzigzag(journal::readVarint(in, end));
+
+                visitor(static_cast<const JournalRecord &>(record));
+            }
+        }
+
+        template<typename Visitor>
+        void forEach(Visitor &&visitor) const {
+            for (const auto &block: this->blocks) {
+                this->forEachInBlock(block, visitor);
+            }
+        }
+
+    private:
+        const std::byte *mapping{};
+        size_t mappingSize{};
+        std::span<const JournalBlock> blocks;
+        std::vector<JournalBlock> rebuilt;
+        bool complete{};
+
+        // the header of the block at offset, if the block has records and fits before end
+        std::optional<journal::BlockHeader> findBlockHeader(const unsigned long long offset,
+                                                            const unsigned long long end) const {
+            if (offset < sizeof(journal::FileHeader) || end > this->mappingSize || offset > end ||
+                end - offset < sizeof(journal::BlockHeader)) {
+                return std::nullopt;
+            }
+
+            journal::BlockHeader header{};
+            std::memcpy(&header, this->mapping + offset, sizeof(header));
+            if (header.recordCount == 0 || header.byteCount > end - offset - sizeof(header)) {
+                return std::nullopt;
+            }
+
+            return header;
+        }
+
+        // the header of the block at offset, if the whole block fits before end and matches its checksum
+        std::optional<journal::BlockHeader> readBlockHeader(const unsigned long long offset,
+                                                            const unsigned long long end) const {
+            const auto header = this->findBlockHeader(offset, end);
+            if (!header || journal::checksum({this->mapping + offset + sizeof(journal::BlockHeader),
+                                              header->byteCount}) != header->checksum) {
+                return std::nullopt;
+            }
+
+            return header;
+        }
+
+        void open() {
+            journal::FileHeader header{};
+            if (this->mappingSize < sizeof(header)) {
+                throw std::runtime_error{"not a transfer journal"};
+            }
+
+            std::memcpy(&header, this->mapping, sizeof(header));
+            if (std::memcmp(header.magic, journal::MAGIC, sizeof(journal::MAGIC)) != 0 || header.version != 1) {
+                throw std::runtime_error{"not a transfer journal"};
+            }
+
+            if (this->mappingSize >= sizeof(header) + sizeof(journal::Trailer)) {
+                journal::Trailer trailer{};
+                std::memcpy(&trailer, this->mapping + this->mappingSize - sizeof(trailer), sizeof(trailer));
+
+                const auto indexEnd = this->mappingSize - sizeof(trailer);
+                if (std::memcmp(trailer.magic, journal::MAGIC, sizeof(journal::MAGIC)) == 0 &&
+                    trailer.indexOffset % alignof(JournalBlock) == 0 && trailer.indexOffset <= indexEnd &&
+                    trailer.blockCount == (indexEnd - trailer.indexOffset) / sizeof(JournalBlock)) {
+                    // the writer padded the index to eight bytes, so the mapping holds it as is
+                    this->blocks = {reinterpret_cast<const JournalBlock *>(this->mapping + trailer.indexOffset),
+                                    trailer.blockCount};
+                    if (this->isIndexIntact(trailer.indexOffset)) {
+                        this->complete = true;
+                        return;
+                    }
+
+                    this->rebuildIndex(trailer.indexOffset);
+                    return;
+                }
+            }
+
+            this->rebuildIndex(this->mappingSize);
+        }
+
+        // Every entry must describe the block that follows the one before, with the same first timestamp and
+        // record count as its header and bytes that match the checksum; the blocks must end within the padding
+        // before the index. Reading every block once is the price of never decoding from a damaged index.
+        [[nodiscard]] bool isIndexIntact(const unsigned long long indexOffset) const {
+            auto offset = static_cast<unsigned long long>(sizeof(journal::FileHeader));
+            for (const auto &block: this->blocks) {
+                const auto header = this->readBlockHeader(block.offset, indexOffset);
+                if (block.offset != offset || !header || header->recordCount != block.recordCount ||
+                    header->firstTimestamp != block.firstTimestamp) {
+                    return false;
+                }
+
+                offset += sizeof(journal::BlockHeader) + header->byteCount;
+            }
+
+            return offset <= indexOffset && indexOffset - offset < alignof(JournalBlock);
+        }
+
+        // Walks the blocks before end, of an unclosed file or one with a damaged index; a torn or corrupt block
+        // ends the walk, since nothing after it can be trusted to start where the walk would look.
+        void rebuildIndex(const unsigned long long end) {
+            auto offset = static_cast<unsigned long long>(sizeof(journal::FileHeader));
+            for (auto header = this->readBlockHeader(offset, end); header; header = this->readBlockHeader(offset, end)) {
+                this->rebuilt.push_back(JournalBlock{offset, header->firstTimestamp, header->recordCount});
+                offset += sizeof(journal::BlockHeader) + header->byteCount;
+            }
+
+            this->blocks = this->rebuilt;
+        }
+
+        void unmap() {
+            if (this->mapping != nullptr) {
+                ::munmap(const_cast<std::byte *>(this->mapping), this->mappingSize);
+                this->mapping = nullptr;
+            }
+        }
+    };
+}
+
+#endif //CPPCRASHCOURSE_CH05_TRANSFER_JOURNAL_H
@@ -0,0 +1,245 @@
+#ifndef CPPCRASHCOURSE_CH05_H
+#define CPPCRASHCOURSE_CH05_H
+
+#include <algorithm>
+#include <unordered_map>
+#include <iostream>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "ch04-trace-span.h"
+
+namespace ch05 {
+    struct Transfer {
+        long fromAccount;
+        long toAccount;
+        long long amount;
+    };
+
+    struct AccountDelta {
+        long account;
+        long long amount;
+    };
+
+    // what an account holds, as opposed to an AccountDelta, which is a change to it
+    struct AccountBalance {
+        long account;
+        long long amount;
+
+        bool operator==(const AccountBalance &) const = default;
+    };
+
+    class Logger {
+    public:
+        Logger() = default;
+
+        virtual ~Logger() = default;
+
+        virtual void transfer(long fromAccount, long toAccount, long long amount) const = 0;
+
+        virtual void transferBatch(const std::span<const Transfer> transfers) const {
+            for (const auto &transfer: transfers) {
+                this->transfer(transfer.fromAccount, transfer.toAccount, transfer.amount);
+            }
+        }
+    };
+
+    class ConsoleLogger : public Logger {
+    public:
+        explicit ConsoleLogger(const char *name) : name{name} {}
+
+        void transfer(const long fromAccount, const long toAccount, const long long amount) const override {
+            std::cout << this->name << ": " <<
+                      "transfer from account: " << fromAccount <<
+                      " to account: " << toAccount <<
+                      " amount: " << amount <<
+                      std::endl;
+        }
+
+        void transferBatch(const std::span<const Transfer> transfers) const override {
+            for (const auto &transfer: transfers) {
+                std::cout << this->name << ": " <<
+                          "transfer from account: " << transfer.fromAccount <<
+                          " to account: " << transfer.toAccount <<
+                          " amount: " << transfer.amount <<
+                          '\n';
+            }
+
+            std::cout.flush();
+        }
+
+    private:
+        const char *name;
+    };
+
+    class AccountDatabase {
+    public:
+        AccountDatabase() = default;
+
+        virtual ~AccountDatabase() = default;
+
+        [[nodiscard]] virtual long long getAmount(long account) const = 0;
+
+        virtual void setAmount(long account, long long amount) = 0;
+
+        virtual void transfer(const long fromAccount, const long toAccount, const long long amount) {
+            auto fromAccountAmount = this->getAmount(fromAccount);
+            auto toAccountAmount = this->getAmount(toAccount);
+
+            this->setAmount(fromAccount, fromAccountAmount - amount);
+            this->setAmount(toAccount, toAccountAmount + amount);
+        }
+
+        virtual void addAmounts(const std::span<const AccountDelta> deltas) {
+            for (const auto &delta: deltas) {
+                this->setAmount(delta.account, this->getAmount(delta.account) + delta.amount);
+            }
+        }
+    };
+
+    class InMemoryAccountDatabase : public AccountDatabase {
+    public:
+        long long getAmount(const long account) const override {
+            auto it = this->accounts.find(account);
+            if (it == this->accounts.end()) {
+                return 0;
+            }
+
+            return it->second;
+        }
+
+        void setAmount(const long account, const long long amount) override {
+            this->accounts[account] = amount;
+        }
+
+        void addAmounts(const std::span<const AccountDelta> deltas) override {
+            for (const auto &delta: deltas) {
+                this->accounts[delta.account] += delta.amount;
+            }
+        }
+
+    private:
+        std::unordered_map<long, long long> accounts;
+    };
+
+    class Bank {
+    public:
+        explicit Bank(AccountDatabase &accountDatabase) : m_accountDatabase{accountDatabase} {}
+
+        void setLogger(Logger *logger) {
+            this->m_logger = logger;
+        }
+
+        void transfer(const long fromAccount, const long toAccount, const long long amount) {
+            CH04_TRACE_SPAN("Bank::transfer");
+
+            if (this->m_logger != nullptr) {
+                this->m_logger->transfer(fromAccount, toAccount, amount);
+            }
+
+            this->m_accountDatabase.transfer(fromAccount, toAccount, amount);
+        }
+
+        // Nets the batch down to one delta per touched account, so the database is hit once per account
+        // instead of four times per transfer.
+        void transferBatch(const std::span<const Transfer> transfers) {
+            CH04_TRACE_SPAN("Bank::transferBatch");
+
+            if (this->m_logger != nullptr) {
+                this->m_logger->transferBatch(transfers);
+            }
+
+            auto &cached = threadBuffers();
+            BatchBuffers buffers{std::move(cached)};
+            auto &deltas = buffers.deltas;
+
+            deltas.clear();
+            deltas.reserve(2 * transfers.size());
+
+            for (const auto &transfer: transfers) {
+                deltas.push_back(AccountDelta{transfer.fromAccount, -transfer.amount});
+                deltas.push_back(AccountDelta{transfer.toAccount, transfer.amount});
+            }
+
+            sortDeltasByAccount(buffers);
+
+            size_t size{};
+            for (const auto &delta: deltas) {
+                if (size > 0 && deltas[size - 1].account == delta.account) {
+                    deltas[size - 1].amount += delta.amount;
+                } else {
+                    deltas[size++] = delta;
+                }
+            }
+
+            this->m_accountDatabase.addAmounts(std::span{deltas.data(), size});
+            cached = std::move(buffers);
+        }
+
+    private:
+        // Reused by every batch on a thread, so batches allocate nothing once the buffers have grown, and any
+        // number of threads can share one Bank. A batch takes the buffers for as long as it runs: one nested in
+        // it, from a logger or database calling back into a bank, starts with empty ones.
+        struct BatchBuffers {
+            std::vector<AccountDelta> deltas;
+            std::vector<AccountDelta> scratch;
+            std::vector<size_t> counts;
+        };
+
+        AccountDatabase &m_accountDatabase;
+        Logger *m_logger{};
+
+        static BatchBuffers &threadBuffers() {
+            thread_local BatchBuffers buffers{};
+            return buffers;
+        }
+
+        // LSD radix sort over the account bytes, skipping the bytes every account has in common
+        static void sortDeltasByAccount(BatchBuffers &buffers) {
+            auto &deltas = buffers.deltas;
+            const auto size = deltas.size();
+            if (size < 1024) {
+                std::sort(deltas.begin(), deltas.end(), [](const auto &left, const auto &right) {
+                    return left.account < right.account;
+                });
+                return;
+            }
+
+            const auto key = [](const AccountDelta &delta) {
+                return static_cast<unsigned long long>(delta.account) ^ (1ull << 63);
+            };
+
+            auto &counts = buffers.counts;
+            counts.assign(8 * 256, 0);
+            for (const auto &delta: deltas) {
+                for (unsigned byte{}; byte < 8; byte++) {
+                    counts[byte * 256 + ((key(delta) >> (8 * byte)) & 0xFF)]++;
+                }
+            }
+
+            auto &scratch = buffers.scratch;
+            scratch.resize(size);
+
+            for (unsigned byte{}; byte < 8; byte++) {
+                auto offsets = counts.begin() + byte * 256;
+                if (offsets[(key(deltas[0]) >> (8 * byte)) & 0xFF] == size) {
+                    continue;
+                }
+
+                size_t offset{};
+                for (auto it = offsets; it != offsets + 256; it++) {
+                    offset += std::exchange(*it, offset);
+                }
+
+                for (const auto &delta: deltas) {
+                    scratch[offsets[(key(delta) >> (8 * byte)) & 0xFF]++] = delta;
+                }
+
+                deltas.swap(scratch);
+            }
+        }
+    };
+}
+
+#endif //CPPCRASHCOURSE_CH05_H
@@ -0,0 +1,132 @@
+#include <cstdint>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "ch06.1.h"
+#include "ch06.1-mode-tracker.h"
+
+namespace {
+    template<ch06_1::Integer T>
+    std::vector<T> sampleValues(const size_t count, const long long range) {
+        std::mt19937_64 random{1};
+        std::uniform_int_distribution<long long> uniform{0, range - 1};
+        std::vector<T> values(count);
+
+        for (auto &value: values) {
+            value = static_cast<T>(uniform(random));
+        }
+
+        return values;
+    }
+
+    // the original single-threaded implementation, kept as the baseline
+    template<ch06_1::Integer T>
+    T unorderedMapMode(const std::vector<T> &values) {
+        std::unordered_map<T, int> counts;
+
+        for (const auto &value: values) {
+            counts[value]++;
+        }
+
+        T result{};
+        int max_count = 0;
+
+        for (const auto &pair: counts) {
+            if (pair.second > max_count) {
+                result = pair.first;
+                max_count = pair.second;
+            }
+        }
+
+        if (std::any_of(counts.begin(), counts.end(), [max_count, result](const std::pair<const T, int> &pair) {
+            return pair.second == max_count && pair.first != result;
+        })) {
+            return T{};
+        }
+
+        return result;
+    }
+
+    template<ch06_1::Integer T>
+    void BM_UnorderedMapMode(benchmark::State &state) {
+        auto values = sampleValues<T>(static_cast<size_t>(state.range(0)), state.range(1));
+
+        for (auto _: state) {
+            benchmark::DoNotOptimize(unorderedMapMode(values));
+        }
+
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+
+    template<ch06_1::Integer T>
+    void BM_Mode(benchmark::State &state) {
+        auto values = sampleValues<T>(static_cast<size_t>(state.range(0)), state.range(1));
+
+        for (auto _: state) {
+            benchmark::DoNotOptimize(ch06_1::mode(values));
+        }
+
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+
+    constexpr size_t WINDOW = 1'000'000;
+
+    // every iteration slides the window by one value and asks for the mode of the new window
+    void BM_SlidingWindowMode(benchmark::State &state) {
+        auto values = sampleValues<int>(WINDOW + (1 << 12), 1 << 16);
+        size_t start{};
+
+        for (auto _: state) {
+            start = (start + 1) % (values.size() - WINDOW);
+            benchmark::DoNotOptimize(ch06_1::mode(std::span<const int>{values}.subspan(start, WINDOW)));
+        }
+
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    void BM_SlidingWindowModeTracker(benchmark::State &state) {
+        auto values = sampleValues<int>(2 * WINDOW, 1 << 16);
+
+        ch06_1::ModeTracker<int> tracker;
+        for (size_t i{}; i < WINDOW; i++) {
+            tracker.push(values[i]);
+        }
+
+        size_t start{};
+        for (auto _: state) {
+            tracker.pop(values[start]);
+            tracker.push(values[start + WINDOW]);
+            benchmark::DoNotOptimize(tracker.current());
+
+            if (++start == WINDOW) {
+                state.PauseTiming();
+                for (size_t i{}; i < WINDOW; i++) {
+                    tracker.pop(values[WINDOW + i]);
+                    tracker.push(values[i]);
+                }
+                start = 0;
+                state.ResumeTiming();
+            }
+        }
+
+        state.SetItemsProcessed(state.iterations());
+    }
+}
+
+BENCHMARK(BM_UnorderedMapMode<std::uint8_t>)->Args({1 << 24, 256})->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Mode<std::uint8_t>)->Args({1 << 24, 256})->Args({1 << 28, 256})->Unit(benchmark::kMillisecond)->UseRealTime();
+
+BENCHMARK(BM_UnorderedMapMode<std::int16_t>)->Args({1 << 24, 1 << 16})->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Mode<std::int16_t>)->Args({1 << 24, 1 << 16})->Args({1 << 28, 1 << 16})->Unit(benchmark::kMillisecond)->UseRealTime();
+
+BENCHMARK(BM_UnorderedMapMode<int>)->Args({1 << 24, 1 << 10})->Args({1 << 24, 1 << 20})->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Mode<int>)->Args({1 << 24, 1 << 10})->Args({1 << 24, 1 << 20})->Unit(benchmark::kMillisecond)->UseRealTime();
+
+BENCHMARK(BM_UnorderedMapMode<long>)->Args({1 << 24, 1 << 20})->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Mode<long>)->Args({1 << 24, 1 << 20})->Unit(benchmark::kMillisecond)->UseRealTime();
+
+BENCHMARK(BM_SlidingWindowMode)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_SlidingWindowModeTracker);
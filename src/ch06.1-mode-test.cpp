@@ -0,0 +1,130 @@
+#include <cstdint>
+#include <list>
+#include <map>
+#include <random>
+#include <ranges>
+#include <span>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "ch06.1.h"
+
+namespace {
+    // the most frequent value, or zero when there is none or several share the highest count
+    template<typename T, typename Range>
+    T referenceMode(const Range &values) {
+        std::map<T, size_t> counts{};
+        for (const auto value: values) {
+            counts[value]++;
+        }
+
+        T mode{};
+        size_t best{};
+        bool tie{};
+        for (const auto &[value, count]: counts) {
+            if (count > best) {
+                mode = value;
+                best = count;
+                tie = false;
+            } else if (count == best) {
+                tie = true;
+            }
+        }
+
+        return tie ? T{} : mode;
+    }
+
+    // values spread over [min, max], with an extra share of winner so that there usually is a single mode
+    template<typename T>
+    std::vector<T> randomValues(const size_t size, const long long min, const long long max, const T winner,
+                                const unsigned seed) {
+        std::mt19937_64 random{seed};
+        std::uniform_int_distribution<long long> distribution{min, max};
+
+        std::vector<T> values(size);
+        for (auto &value: values) {
+            value = random() % 64 == 0 ? winner : static_cast<T>(distribution(random));
+        }
+
+        return values;
+    }
+
+    template<typename T>
+    void expectEveryModeAgrees(const std::vector<T> &values) {
+        const auto expected = referenceMode<T>(values);
+        const std::span<const T> span{values};
+
+        if constexpr (sizeof(T) <= 2) {
+            EXPECT_EQ(expected, ch06_1::denseMode(span)) << values.size() << " values";
+        }
+        EXPECT_EQ(expected, ch06_1::hashMode<T>(values)) << values.size() << " values";
+        EXPECT_EQ(expected, ch06_1::parallelHashMode(span)) << values.size() << " values";
+        EXPECT_EQ(expected, ch06_1::mode(span)) << values.size() << " values";
+        EXPECT_EQ(expected, ch06_1::mode(values)) << values.size() << " values";
+    }
+}
+
+TEST(Ch06Mode, FindsTheMostFrequentValue) {
+    expectEveryModeAgrees(std::vector<int>{1, 2, 3, 4, 5, 6, 7, 8, 9, 9});
+    expectEveryModeAgrees(std::vector<int>{7});
+    EXPECT_EQ(9, ch06_1::mode(std::vector<int>{1, 2, 3, 4, 5, 6, 7, 8, 9, 9}));
+}
+
+TEST(Ch06Mode, TiesAndNoValuesGiveZero) {
+    expectEveryModeAgrees(std::vector<int>{});
+    expectEveryModeAgrees(std::vector<int>{3, 3, 5, 5, 1});
+    expectEveryModeAgrees(std::vector<std::int8_t>{-4, -4, 100, 100});
+    EXPECT_EQ(0, ch06_1::mode(std::vector<long>{3, 3, 5, 5, 1}));
+}
+
+TEST(Ch06Mode, NegativeValues) {
+    expectEveryModeAgrees(std::vector<int>{-1, -1, -2, 5, -1});
+    expectEveryModeAgrees(std::vector<std::int16_t>{-32768, -32768, 32767});
+    expectEveryModeAgrees(std::vector<std::int8_t>{-128, -128, 127, 0, 0, -128});
+    expectEveryModeAgrees(randomValues<long>(10'000, -1'000'000'000'000, -1'000'000'000'000 + 500, -1, 1));
+}
+
+TEST(Ch06Mode, EightBitValues) {
+    for (const size_t size: {1, 3, 255, 4096, 100'000}) {
+        expectEveryModeAgrees(randomValues<std::int8_t>(size, -128, 127, std::int8_t{-7}, 2));
+        expectEveryModeAgrees(randomValues<std::uint8_t>(size, 0, 255, std::uint8_t{200}, 3));
+    }
+}
+
+TEST(Ch06Mode, SixteenBitValues) {
+    // mode() counts fewer values than there are bins in a hash map, and more in a dense histogram
+    for (const size_t size: {1000, 1 << 16, 1 << 20}) {
+        expectEveryModeAgrees(randomValues<std::int16_t>(size, -32768, 32767, std::int16_t{-12345}, 4));
+        expectEveryModeAgrees(randomValues<std::uint16_t>(size, 0, 65535, std::uint16_t{40000}, 5));
+    }
+}
+
+TEST(Ch06Mode, WideValuesAcrossChunks) {
+    // enough values for parallelHashMode to split them between threads on a machine with several cores
+    expectEveryModeAgrees(randomValues<int>(1 << 20, -5000, 5000, 4242, 6));
+    expectEveryModeAgrees(randomValues<long>(1 << 20, 0, 1 << 30, 1L << 40, 7));
+}
+
+TEST(Ch06Mode, NonContiguousRanges) {
+    const std::list<int> list{4, -2, 4, 8, -2, 4};
+    EXPECT_EQ(referenceMode<int>(list), ch06_1::mode(list));
+    EXPECT_EQ(4, ch06_1::mode(list));
+
+    const std::vector<int> values{1, 2, 2, 3, 3, 3, 4, 4, 4, 4};
+    const auto odd = [](const int value) { return value % 2 != 0; };
+    EXPECT_EQ(3, ch06_1::mode(values | std::views::filter(odd)));
+
+    auto filtered = values | std::views::filter(odd);
+    EXPECT_EQ(3, ch06_1::mode(filtered));
+    EXPECT_EQ(3, ch06_1::mode(values | std::views::take(8)));
+}
+
+TEST(Ch06Mode, ArraysAndSpans) {
+    const int values[]{1, 2, 3, 4, 5, 6, 7, 8, 9, 9};
+    EXPECT_EQ(9, ch06_1::mode(values));
+
+    long mutableValues[]{5, 5, 1};
+    EXPECT_EQ(5, ch06_1::mode(mutableValues));
+    EXPECT_EQ(5, ch06_1::mode(std::span<long>{mutableValues}));
+}
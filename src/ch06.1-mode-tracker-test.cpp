@@ -0,0 +1,140 @@
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <random>
+#include <stdexcept>
+
+#include "gtest/gtest.h"
+
+#include "ch06.1-mode-tracker.h"
+
+template<typename T>
+concept Trackable = requires { typename ch06_1::ModeTracker<T>; };
+
+static_assert(Trackable<std::int8_t> && Trackable<unsigned long long> && Trackable<long>);
+static_assert(!Trackable<__int128> && !Trackable<unsigned __int128> && !Trackable<double>);
+
+namespace {
+    // the mode of the counts from scratch, or zero when there is none or several share the highest count
+    template<typename T>
+    T recount(const std::map<T, size_t> &counts) {
+        T mode{};
+        size_t best{};
+        bool tie{};
+        for (const auto &[value, count]: counts) {
+            if (count > best) {
+                mode = value;
+                best = count;
+                tie = false;
+            } else if (count == best && count > 0) {
+                tie = true;
+            }
+        }
+
+        return tie ? T{} : mode;
+    }
+
+    // a sliding window over random values, checked against a full recount after every step
+    template<typename T>
+    void expectSlidingWindowMatches(const size_t window, const long long min, const long long max,
+                                    const unsigned seed) {
+        std::mt19937_64 random{seed};
+        std::uniform_int_distribution<long long> distribution{min, max};
+
+        ch06_1::ModeTracker<T> tracker{};
+        std::deque<T> values{};
+        std::map<T, size_t> counts{};
+
+        for (int step{}; step < 20'000; step++) {
+            const auto value = static_cast<T>(distribution(random));
+            tracker.push(value);
+            values.push_back(value);
+            counts[value]++;
+
+            if (values.size() > window) {
+                tracker.pop(values.front());
+                if (--counts[values.front()] == 0) {
+                    counts.erase(values.front());
+                }
+                values.pop_front();
+            }
+
+            ASSERT_EQ(recount(counts), tracker.current()) << "step " << step;
+            ASSERT_EQ(counts.size(), tracker.size()) << "step " << step;
+        }
+    }
+}
+
+TEST(Ch06ModeTracker, StartsEmpty) {
+    const ch06_1::ModeTracker<int> tracker{};
+    EXPECT_EQ(0, tracker.current());
+    EXPECT_EQ(0u, tracker.size());
+}
+
+TEST(Ch06ModeTracker, PushAndPopKeepTheMode) {
+    ch06_1::ModeTracker<int> tracker{};
+    tracker.push(5);
+    EXPECT_EQ(5, tracker.current());
+
+    tracker.push(-3);
+    tracker.push(-3);
+    EXPECT_EQ(-3, tracker.current());
+
+    tracker.push(5);
+    tracker.push(5);
+    EXPECT_EQ(5, tracker.current());
+
+    tracker.pop(5);
+    tracker.pop(5);
+    EXPECT_EQ(-3, tracker.current());
+
+    tracker.pop(-3);
+    tracker.pop(-3);
+    EXPECT_EQ(5, tracker.current());
+    EXPECT_EQ(1u, tracker.size());
+
+    tracker.pop(5);
+    EXPECT_EQ(0, tracker.current());
+    EXPECT_EQ(0u, tracker.size());
+}
+
+TEST(Ch06ModeTracker, TiesGiveZero) {
+    ch06_1::ModeTracker<long> tracker{};
+    tracker.push(7);
+    tracker.push(9);
+    EXPECT_EQ(0, tracker.current());
+
+    tracker.push(9);
+    EXPECT_EQ(9, tracker.current());
+
+    tracker.push(7);
+    tracker.push(11);
+    tracker.push(11);
+    EXPECT_EQ(0, tracker.current());
+
+    tracker.pop(11);
+    tracker.pop(9);
+    EXPECT_EQ(7, tracker.current());
+}
+
+TEST(Ch06ModeTracker, PoppingAnUntrackedValueThrows) {
+    ch06_1::ModeTracker<int> tracker{};
+    EXPECT_THROW(tracker.pop(1), std::invalid_argument);
+
+    tracker.push(1);
+    tracker.push(2);
+    tracker.pop(1);
+    EXPECT_THROW(tracker.pop(1), std::invalid_argument);
+
+    // the failed pops changed nothing
+    EXPECT_EQ(2, tracker.current());
+    EXPECT_EQ(1u, tracker.size());
+}
+
+TEST(Ch06ModeTracker, MatchesARecountOfASlidingWindow) {
+    expectSlidingWindowMatches<int>(64, -20, 20, 1);
+    expectSlidingWindowMatches<int>(1000, 0, 100, 2);
+    expectSlidingWindowMatches<std::int8_t>(300, -128, 127, 3);
+    expectSlidingWindowMatches<std::uint16_t>(50, 0, 65535, 4);
+    expectSlidingWindowMatches<long long>(200, -(1LL << 62), -(1LL << 62) + 30, 5);
+}
@@ -0,0 +1,92 @@
+#ifndef CPPCRASHCOURSE_CH06_1_MODE_TRACKER_H
+#define CPPCRASHCOURSE_CH06_1_MODE_TRACKER_H
+
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+#include "ch06.1.h"
+
+namespace ch06_1 {
+    // Keeps the mode of a multiset that changes one value at a time. Values are grouped into buckets by how often
+    // they occur; a bucket only stores its size and the XOR of its values, which is the value itself when the
+    // bucket holds exactly one. current() returns T{} on a tie, like mode. The XOR is kept in 64 bits, so wider
+    // integers are rejected rather than silently truncated.
+    template<Integer T> requires (sizeof(T) <= sizeof(unsigned long long))
+    class ModeTracker {
+    public:
+        void push(const T value) {
+            auto &count = this->counts[value];
+
+            if (count > 0) {
+                this->remove(count, value);
+            }
+
+            count++;
+            this->add(count, value);
+
+            if (count > this->maxCount) {
+                this->maxCount = count;
+            }
+        }
+
+        void pop(const T value) {
+            auto it = this->counts.find(value);
+            if (it == this->counts.end()) {
+                throw std::invalid_argument{"value is not tracked"};
+            }
+
+            auto &count = it->second;
+            this->remove(count, value);
+            count--;
+
+            if (count > 0) {
+                this->add(count, value);
+            } else {
+                this->counts.erase(it);
+            }
+
+            if (this->buckets[this->maxCount].size == 0) {
+                this->maxCount--;
+            }
+        }
+
+        [[nodiscard]] T current() const {
+            if (this->maxCount == 0 || this->buckets[this->maxCount].size != 1) {
+                return T{};
+            }
+
+            return static_cast<T>(this->buckets[this->maxCount].values);
+        }
+
+        [[nodiscard]] size_t size() const {
+            return this->counts.size();
+        }
+
+    private:
+        struct Bucket {
+            size_t size;
+            unsigned long long values;
+        };
+
+        std::unordered_map<T, size_t> counts;
+        std::vector<Bucket> buckets{Bucket{}};
+        size_t maxCount{};
+
+        void add(const size_t count, const T value) {
+            if (count == this->buckets.size()) {
+                this->buckets.push_back(Bucket{});
+            }
+
+            this->buckets[count].size++;
+            this->buckets[count].values ^= static_cast<unsigned long long>(value);
+        }
+
+        void remove(const size_t count, const T value) {
+            this->buckets[count].size--;
+            this->buckets[count].values ^= static_cast<unsigned long long>(value);
+        }
+    };
+}
+
+#endif //CPPCRASHCOURSE_CH06_1_MODE_TRACKER_H
@@ -0,0 +1,224 @@
+#ifndef CPPCRASHCOURSE_CH06_1_H
+#define CPPCRASHCOURSE_CH06_1_H
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <ranges>
+#include <span>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace ch06_1 {
+    template<typename T>
+    concept Integer = std::is_integral<T>::value;
+
+    // Below this many values per thread, starting threads costs more than it saves.
+    constexpr size_t PARALLEL_CHUNK_SIZE = 1 << 18;
+
+    template<Integer T>
+    struct ModeCandidate {
+        T value{};
+        size_t count{};
+        bool tie{};
+
+        void add(const T candidate, const size_t candidateCount) {
+            if (candidateCount > this->count) {
+                this->value = candidate;
+                this->count = candidateCount;
+                this->tie = false;
+            } else if (candidateCount == this->count && candidate != this->value) {
+                this->tie = true;
+            }
+        }
+
+        void add(const ModeCandidate &other) {
+            this->add(other.value, other.count);
+            if (other.tie && other.count == this->count) {
+                this->tie = true;
+            }
+        }
+
+        [[nodiscard]] T result() const {
+            return this->tie ? T{} : this->value;
+        }
+    };
+
+    inline size_t threadCountFor(const size_t size) {
+        const auto hardware = std::max(1u, std::thread::hardware_concurrency());
+        return std::clamp<size_t>(size / PARALLEL_CHUNK_SIZE, 1, hardware);
+    }
+
+    template<typename Function>
+    void parallelFor(const size_t threadCount, Function function) {
+        std::vector<std::thread> threads;
+        threads.reserve(threadCount - 1);
+
+        for (size_t thread{1}; thread < threadCount; thread++) {
+            threads.emplace_back(function, thread);
+        }
+
+        function(0);
+
+        for (auto &thread: threads) {
+            thread.join();
+        }
+    }
+
+    // Types of at most 16 bits get one counter per possible value. Each thread counts into four interleaved
+    // histograms, so consecutive equal values do not serialize on the same counter.
+    template<Integer T>
+    T denseMode(const std::span<const T> values) {
+        using Unsigned = std::make_unsigned_t<std::conditional_t<std::is_same_v<T, bool>, unsigned char, T>>;
+        constexpr size_t BINS = size_t{1} << (8 * sizeof(T));
+        constexpr size_t LANES = 4;
+
+        const auto threadCount = threadCountFor(values.size());
+        const auto chunkSize = (values.size() + threadCount - 1) / threadCount;
+        std::vector<size_t> counts(threadCount * BINS);
+
+        parallelFor(threadCount, [&](const size_t thread) {
+            const auto begin = std::min(values.size(), thread * chunkSize);
+            const auto chunk = values.subspan(begin, std::min(chunkSize, values.size() - begin));
+
+            auto lanes = std::make_unique<unsigned[]>(LANES * BINS);
+            const auto flush = [&] {
+                for (size_t bin{}; bin < BINS; bin++) {
+                    counts[thread * BINS + bin] += lanes[bin] + lanes[BINS + bin] + lanes[2 * BINS + bin] +
+                                                   lanes[3 * BINS + bin];
+                }
+                std::fill_n(lanes.get(), LANES * BINS, 0u);
+            };
+
+            // flush before the 32 bit lane counters can overflow
+            constexpr size_t BLOCK = size_t{std::numeric_limits<unsigned>::max()} & ~(LANES - 1);
+
+            for (size_t start{}; start < chunk.size(); start += BLOCK) {
+                const auto block = chunk.subspan(start, std::min(BLOCK, chunk.size() - start));
+
+                size_t i{};
+                for (; i + LANES <= block.size(); i += LANES) {
+                    lanes[static_cast<Unsigned>(block[i])]++;
+                    lanes[BINS + static_cast<Unsigned>(block[i + 1])]++;
+                    lanes[2 * BINS + static_cast<Unsigned>(block[i + 2])]++;
+                    lanes[3 * BINS + static_cast<Unsigned>(block[i + 3])]++;
+                }
+                for (; i < block.size(); i++) {
+                    lanes[static_cast<Unsigned>(block[i])]++;
+                }
+
+                flush();
+            }
+        });
+
+        for (size_t thread{1}; thread < threadCount; thread++) {
+            std::transform(counts.begin(), counts.begin() + BINS, counts.begin() + thread * BINS,
+                           counts.begin(), std::plus<>{});
+        }
+
+        // the maximum is found with a plain (vectorizable) scan first, then only the winners are compared
+        const auto maxCount = *std::max_element(counts.begin(), counts.begin() + BINS);
+        if (maxCount == 0 || std::count(counts.begin(), counts.begin() + BINS, maxCount) > 1) {
+            return T{};
+        }
+
+        const auto bin = std::find(counts.begin(), counts.begin() + BINS, maxCount) - counts.begin();
+        return static_cast<T>(static_cast<Unsigned>(bin));
+    }
+
+    template<Integer T, typename Range>
+    T hashMode(Range &&values) {
+        std::unordered_map<T, size_t> counts;
+
+        for (const auto &value: values) {
+            counts[value]++;
+        }
+
+        ModeCandidate<T> candidate{};
+        for (const auto &[value, count]: counts) {
+            candidate.add(value, count);
+        }
+
+        return candidate.result();
+    }
+
+    // Every thread counts its chunk into one hash map per partition of the key space, then every thread
+    // merges one partition from all the others, so no map is ever shared between threads.
+    template<Integer T>
+    T parallelHashMode(const std::span<const T> values) {
+        const auto threadCount = threadCountFor(values.size());
+        if (threadCount == 1) {
+            return hashMode<T>(values);
+        }
+
+        const auto chunkSize = (values.size() + threadCount - 1) / threadCount;
+        std::vector<std::vector<std::unordered_map<T, size_t>>> partitions(
+                threadCount, std::vector<std::unordered_map<T, size_t>>(threadCount));
+        std::vector<ModeCandidate<T>> candidates(threadCount);
+
+        parallelFor(threadCount, [&](const size_t thread) {
+            const auto begin = std::min(values.size(), thread * chunkSize);
+            const auto end = std::min(values.size(), begin + chunkSize);
+            const std::hash<T> hash{};
+
+            for (auto i = begin; i < end; i++) {
+                partitions[thread][hash(values[i]) % threadCount][values[i]]++;
+            }
+        });
+
+        parallelFor(threadCount, [&](const size_t partition) {
+            auto &merged = partitions[0][partition];
+            for (size_t thread{1}; thread < threadCount; thread++) {
+                for (const auto &[value, count]: partitions[thread][partition]) {
+                    merged[value] += count;
+                }
+            }
+
+            for (const auto &[value, count]: merged) {
+                candidates[partition].add(value, count);
+            }
+        });
+
+        ModeCandidate<T> candidate{};
+        for (const auto &partitionCandidate: candidates) {
+            candidate.add(partitionCandidate);
+        }
+
+        return candidate.result();
+    }
+
+    template<Integer T>
+    T mode(const std::span<const T> values) {
+        if constexpr (sizeof(T) <= 2) {
+            if (sizeof(T) == 1 || values.size() >= (size_t{1} << (8 * sizeof(T)))) {
+                return denseMode(values);
+            }
+
+            return hashMode<T>(values);
+        } else {
+            return parallelHashMode(values);
+        }
+    }
+
+    // Taken by forwarding reference: views such as filter_view can only be iterated when they are not const.
+    template<std::ranges::input_range Range> requires Integer<std::ranges::range_value_t<Range>>
+    std::ranges::range_value_t<Range> mode(Range &&values) {
+        using T = std::ranges::range_value_t<Range>;
+
+        if constexpr (std::ranges::contiguous_range<Range> && std::ranges::sized_range<Range>) {
+            return mode(std::span<const T>{std::ranges::data(values), std::ranges::size(values)});
+        } else {
+            return hashMode<T>(values);
+        }
+    }
+
+    template<Integer T, size_t Length>
+    T mode(const T (&values)[Length]) { // TODO: Why (&values)[Length]
+        return mode(std::span<const T>{values});
+    }
+}
+
+#endif //CPPCRASHCOURSE_CH06_1_H
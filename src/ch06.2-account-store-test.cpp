@@ -0,0 +1,90 @@
+#include <limits>
+#include <string>
+
+#include "gtest/gtest.h"
+
+#include "ch06.2-account-store.h"
+
+namespace {
+    // checking and saving accounts in turns, with amounts of either sign
+    ch06_2::AccountStore mixedStore(const long long count) {
+        ch06_2::AccountStore store{};
+        for (long long i{}; i < count; i++) {
+            const auto type = i % 2 == 0 ? ch06_2::AccountType::Checking : ch06_2::AccountType::Saving;
+            store.add(type, "owner " + std::to_string(i % 3), (i - count / 2) * 10'001);
+        }
+
+        return store;
+    }
+}
+
+TEST(Ch06AccountStore, AddsAccountsWithInternedNames) {
+    ch06_2::AccountStore store{};
+    const auto first = store.add(ch06_2::AccountType::Checking, "alice", 100);
+    const auto second = store.add(ch06_2::AccountType::Saving, "alice");
+
+    EXPECT_EQ(2u, store.size());
+    EXPECT_EQ(100, store.getAmount(first));
+    EXPECT_EQ(0, store.getAmount(second));
+    EXPECT_EQ(store.getName(first), store.getName(second));
+    EXPECT_STREQ("checking", store.getTypeName(first));
+    EXPECT_STREQ("saving", store.getTypeName(second));
+}
+
+TEST(Ch06AccountStore, AppliesTheRateOnlyToItsType) {
+    // more accounts than one vector register holds, and an odd count so a scalar tail is left
+    auto store = mixedStore(101);
+    auto expected = mixedStore(101);
+
+    store.applyRate(ch06_2::AccountType::Saving, 125);
+
+    for (size_t account{}; account < store.size(); account++) {
+        const auto before = expected.getAmount(account);
+        if (store.getType(account) == ch06_2::AccountType::Saving) {
+            // truncated towards zero, for credits and debts alike
+            EXPECT_EQ(before + before * 125 / 10000, store.getAmount(account)) << "account " << account;
+        } else {
+            EXPECT_EQ(before, store.getAmount(account)) << "account " << account;
+        }
+    }
+}
+
+TEST(Ch06AccountStore, NegativeRatesChargeAFee) {
+    ch06_2::AccountStore store{};
+    const auto account = store.add(ch06_2::AccountType::Checking, "bob", 20'000);
+    const auto debt = store.add(ch06_2::AccountType::Checking, "bob", -20'000);
+
+    store.applyRate(ch06_2::AccountType::Checking, -50);
+
+    EXPECT_EQ(19'900, store.getAmount(account));
+    EXPECT_EQ(-19'900, store.getAmount(debt));
+}
+
+TEST(Ch06AccountStore, LargeBalancesOfOtherTypesAreLeftAlone) {
+    ch06_2::AccountStore store{};
+    const auto largest = store.add(ch06_2::AccountType::Checking, "carol", std::numeric_limits<long long>::max());
+    const auto smallest = store.add(ch06_2::AccountType::Checking, "carol", std::numeric_limits<long long>::min());
+    const auto saving = store.add(ch06_2::AccountType::Saving, "carol", 10'000);
+
+    // multiplying the checking balances by the rate would overflow
+    store.applyRate(ch06_2::AccountType::Saving, 10'000);
+
+    EXPECT_EQ(std::numeric_limits<long long>::max(), store.getAmount(largest));
+    EXPECT_EQ(std::numeric_limits<long long>::min(), store.getAmount(smallest));
+    EXPECT_EQ(20'000, store.getAmount(saving));
+}
+
+TEST(Ch06AccountStore, SumsAmountsPerType) {
+    EXPECT_EQ(0, ch06_2::AccountStore{}.sumAmounts(ch06_2::AccountType::Checking));
+
+    const auto store = mixedStore(100);
+    long long checking{};
+    long long saving{};
+    for (size_t account{}; account < store.size(); account++) {
+        (store.getType(account) == ch06_2::AccountType::Checking ? checking : saving) += store.getAmount(account);
+    }
+
+    EXPECT_EQ(checking, store.sumAmounts(ch06_2::AccountType::Checking));
+    EXPECT_EQ(saving, store.sumAmounts(ch06_2::AccountType::Saving));
+    EXPECT_NE(checking, saving);
+}
@@ -0,0 +1,101 @@
+#ifndef CPPCRASHCOURSE_CH06_2_ACCOUNT_STORE_H
+#define CPPCRASHCOURSE_CH06_2_ACCOUNT_STORE_H
+
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace ch06_2 {
+    enum class AccountType : unsigned char {
+        Checking,
+        Saving,
+    };
+
+    // Structure-of-arrays storage: an account is an index into parallel arrays of amounts, type tags and
+    // interned name ids, so bulk jobs stream through exactly the columns they need.
+    class AccountStore {
+    public:
+        size_t add(const AccountType type, const std::string_view name, const long long amount = 0) {
+            this->m_amounts.push_back(amount);
+            this->m_types.push_back(type);
+            this->m_nameIds.push_back(this->intern(name));
+
+            return this->m_amounts.size() - 1;
+        }
+
+        [[nodiscard]] long long getAmount(const size_t account) const {
+            return this->m_amounts[account];
+        }
+
+        void setAmount(const size_t account, const long long amount) {
+            this->m_amounts[account] = amount;
+        }
+
+        [[nodiscard]] AccountType getType(const size_t account) const {
+            return this->m_types[account];
+        }
+
+        [[nodiscard]] const char *getTypeName(const size_t account) const {
+            return this->m_types[account] == AccountType::Checking ? "checking" : "saving";
+        }
+
+        [[nodiscard]] const char *getName(const size_t account) const {
+            return this->m_names[this->m_nameIds[account]].c_str();
+        }
+
+        [[nodiscard]] size_t size() const {
+            return this->m_amounts.size();
+        }
+
+        // Adds amount * basisPoints / 10000 (truncated) to every account of the type, e.g. interest or a negative fee.
+        void applyRate(const AccountType type, const long long basisPoints) {
+            auto *amounts = this->m_amounts.data();
+            const auto *types = this->m_types.data();
+            const auto count = this->m_amounts.size();
+
+            // the rate is selected before multiplying, so a balance of another type never takes part in a product
+            // that could overflow
+            for (size_t i{}; i < count; i++) {
+                const auto factor = types[i] == type ? basisPoints : 0;
+                amounts[i] += amounts[i] * factor / 10000;
+            }
+        }
+
+        [[nodiscard]] long long sumAmounts(const AccountType type) const {
+            const auto *amounts = this->m_amounts.data();
+            const auto *types = this->m_types.data();
+            const auto count = this->m_amounts.size();
+
+            long long sum{};
+            for (size_t i{}; i < count; i++) {
+                sum += types[i] == type ? amounts[i] : 0;
+            }
+
+            return sum;
+        }
+
+    private:
+        std::vector<long long> m_amounts;
+        std::vector<AccountType> m_types;
+        std::vector<unsigned> m_nameIds;
+        std::deque<std::string> m_names;
+        std::unordered_map<std::string_view, unsigned> m_nameIndex;
+
+        unsigned intern(const std::string_view name) {
+            auto it = this->m_nameIndex.find(name);
+            if (it != this->m_nameIndex.end()) {
+                return it->second;
+            }
+
+            const auto id = static_cast<unsigned>(this->m_names.size());
+            const auto &stored = this->m_names.emplace_back(name);
+            this->m_nameIndex.emplace(stored, id);
+
+            return id;
+        }
+    };
+}
+
+#endif //CPPCRASHCOURSE_CH06_2_ACCOUNT_STORE_H
@@ -0,0 +1,96 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <type_traits>
+
+#include "gtest/gtest.h"
+
+#include "ch06.2.h"
+
+namespace {
+    // has an amount, but no type or name
+    struct Wallet {
+        long long amount;
+
+        [[nodiscard]] long long getAmount() const {
+            return this->amount;
+        }
+
+        void setAmount(const long long value) {
+            this->amount = value;
+        }
+    };
+
+    template<typename T>
+    concept Bankable = requires { typename ch06_2::Bank<T>; };
+
+    // what the bank writes to std::cout while running the function
+    template<typename Function>
+    std::string captureOutput(Function function) {
+        std::ostringstream output{};
+        auto *const original = std::cout.rdbuf(output.rdbuf());
+        function();
+        std::cout.rdbuf(original);
+
+        return output.str();
+    }
+}
+
+static_assert(ch06_2::AccountLike<ch06_2::Account> && ch06_2::AccountLike<ch06_2::CheckingAccount> &&
+              ch06_2::AccountLike<ch06_2::SavingAccount> && ch06_2::AccountLike<ch06_2::AccountVariant>);
+static_assert(!ch06_2::AccountLike<int> && !ch06_2::AccountLike<Wallet> && !ch06_2::AccountLike<const char *>);
+static_assert(Bankable<ch06_2::SavingAccount> && !Bankable<int> && !Bankable<Wallet>);
+
+// a variant is a copy, so it is never made behind the caller's back
+static_assert(std::is_constructible_v<ch06_2::AccountVariant, const ch06_2::CheckingAccount &>);
+static_assert(!std::is_convertible_v<const ch06_2::CheckingAccount &, ch06_2::AccountVariant>);
+static_assert(!std::is_convertible_v<const ch06_2::SavingAccount &, ch06_2::AccountVariant>);
+
+TEST(Ch06Bank, LogsEveryTransfer) {
+    ch06_2::CheckingAccount checking{"alice"};
+    ch06_2::SavingAccount saving{"bob"};
+    checking.setAmount(100);
+    ch06_2::Bank<ch06_2::Account> bank{};
+
+    const auto output = captureOutput([&] { bank.transfer(checking, saving, 40); });
+
+    EXPECT_EQ("transfer from account: checking/alice to account: saving/bob amount: 40\n", output);
+    EXPECT_EQ(60, checking.getAmount());
+    EXPECT_EQ(40, saving.getAmount());
+}
+
+TEST(Ch06Bank, WithoutLoggingOnlyMovesTheAmount) {
+    ch06_2::CheckingAccount first{"alice"};
+    ch06_2::CheckingAccount second{"bob"};
+    ch06_2::Bank<ch06_2::CheckingAccount, false> bank{};
+
+    const auto output = captureOutput([&] {
+        bank.transfer(first, second, 25);
+        bank.transfer(second, first, 5);
+    });
+
+    EXPECT_EQ("", output);
+    EXPECT_EQ(-20, first.getAmount());
+    EXPECT_EQ(20, second.getAmount());
+}
+
+TEST(Ch06Bank, VariantsHoldTheirOwnAccounts) {
+    ch06_2::CheckingAccount checking{"alice"};
+    checking.setAmount(100);
+    const ch06_2::SavingAccount saving{"bob"};
+
+    ch06_2::AccountVariant from{checking};
+    ch06_2::AccountVariant to{saving};
+    ch06_2::Bank<ch06_2::AccountVariant, false> bank{};
+    bank.transfer(from, to, 30);
+
+    EXPECT_EQ(70, from.getAmount());
+    EXPECT_EQ(30, to.getAmount());
+    EXPECT_STREQ("checking", from.getType());
+    EXPECT_STREQ("saving", to.getType());
+    EXPECT_STREQ("bob", to.getName());
+
+    // the accounts the variants were made from are untouched
+    EXPECT_EQ(100, checking.getAmount());
+    EXPECT_EQ(0, saving.getAmount());
+}
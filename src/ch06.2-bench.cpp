@@ -0,0 +1,182 @@
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "ch06.2.h"
+#include "ch06.2-account-store.h"
+
+namespace {
+    constexpr size_t ACCOUNT_COUNT = 1024;
+    constexpr long TRANSFER_COUNT = 10'000'000;
+
+    template<typename Account, typename Bank>
+    void runTransfers(benchmark::State &state, std::vector<Account *> &accounts, Bank &bank) {
+        for (auto _: state) {
+            for (long i{}; i < TRANSFER_COUNT; i++) {
+                bank.transfer(*accounts[i % ACCOUNT_COUNT], *accounts[(i * 7 + 1) % ACCOUNT_COUNT], 1);
+            }
+            benchmark::ClobberMemory();
+        }
+
+        state.SetItemsProcessed(state.iterations() * TRANSFER_COUNT);
+    }
+
+    // half checking and half saving accounts behind Account *, the way main uses Bank<Account>
+    void BM_VirtualBank(benchmark::State &state) {
+        std::vector<std::unique_ptr<ch06_2::Account>> owners;
+        std::vector<ch06_2::Account *> accounts;
+
+        for (size_t i{}; i < ACCOUNT_COUNT; i++) {
+            if (i % 2 == 0) {
+                owners.push_back(std::make_unique<ch06_2::CheckingAccount>("checking"));
+            } else {
+                owners.push_back(std::make_unique<ch06_2::SavingAccount>("saving"));
+            }
+            accounts.push_back(owners.back().get());
+        }
+
+        ch06_2::Bank<ch06_2::Account, false> bank{};
+        runTransfers(state, accounts, bank);
+    }
+
+    void BM_CheckingAccountBank(benchmark::State &state) {
+        std::vector<ch06_2::CheckingAccount> owners(ACCOUNT_COUNT, ch06_2::CheckingAccount{"checking"});
+        std::vector<ch06_2::CheckingAccount *> accounts;
+
+        for (auto &owner: owners) {
+            accounts.push_back(&owner);
+        }
+
+        ch06_2::Bank<ch06_2::CheckingAccount, false> bank{};
+        runTransfers(state, accounts, bank);
+    }
+
+    void BM_AccountVariantBank(benchmark::State &state) {
+        std::vector<ch06_2::AccountVariant> owners;
+        std::vector<ch06_2::AccountVariant *> accounts;
+
+        for (size_t i{}; i < ACCOUNT_COUNT; i++) {
+            if (i % 2 == 0) {
+                owners.emplace_back(ch06_2::CheckingAccount{"checking"});
+            } else {
+                owners.emplace_back(ch06_2::SavingAccount{"saving"});
+            }
+        }
+        for (auto &owner: owners) {
+            accounts.push_back(&owner);
+        }
+
+        ch06_2::Bank<ch06_2::AccountVariant, false> bank{};
+        runTransfers(state, accounts, bank);
+    }
+
+    constexpr size_t STORE_ACCOUNT_COUNT = 1 << 22;
+
+    std::vector<std::string> accountNames() {
+        std::vector<std::string> names(STORE_ACCOUNT_COUNT);
+        for (size_t i{}; i < STORE_ACCOUNT_COUNT; i++) {
+            names[i] = "account-" + std::to_string(i % 4096);
+        }
+
+        return names;
+    }
+
+    // separately allocated accounts in creation order, checked by type name through the Account interface
+    std::vector<std::unique_ptr<ch06_2::Account>> objectAccounts(const std::vector<std::string> &names) {
+        std::vector<std::unique_ptr<ch06_2::Account>> accounts;
+
+        for (size_t i{}; i < STORE_ACCOUNT_COUNT; i++) {
+            if (i % 3 == 0) {
+                accounts.push_back(std::make_unique<ch06_2::SavingAccount>(names[i].c_str()));
+            } else {
+                accounts.push_back(std::make_unique<ch06_2::CheckingAccount>(names[i].c_str()));
+            }
+            accounts.back()->setAmount(static_cast<long long>(i % 100'000));
+        }
+
+        return accounts;
+    }
+
+    ch06_2::AccountStore storeAccounts(const std::vector<std::string> &names) {
+        ch06_2::AccountStore store;
+
+        for (size_t i{}; i < STORE_ACCOUNT_COUNT; i++) {
+            const auto type = i % 3 == 0 ? ch06_2::AccountType::Saving : ch06_2::AccountType::Checking;
+            store.add(type, names[i], static_cast<long long>(i % 100'000));
+        }
+
+        return store;
+    }
+
+    void BM_ObjectApplyRate(benchmark::State &state) {
+        const auto names = accountNames();
+        auto accounts = objectAccounts(names);
+
+        for (auto _: state) {
+            for (auto &account: accounts) {
+                if (std::strcmp(account->getType(), "saving") == 0) {
+                    account->setAmount(account->getAmount() + account->getAmount() * 125 / 10000);
+                }
+            }
+            benchmark::ClobberMemory();
+        }
+
+        state.SetItemsProcessed(state.iterations() * STORE_ACCOUNT_COUNT);
+    }
+
+    void BM_StoreApplyRate(benchmark::State &state) {
+        const auto names = accountNames();
+        auto store = storeAccounts(names);
+
+        for (auto _: state) {
+            store.applyRate(ch06_2::AccountType::Saving, 125);
+            benchmark::ClobberMemory();
+        }
+
+        state.SetItemsProcessed(state.iterations() * STORE_ACCOUNT_COUNT);
+    }
+
+    void BM_ObjectSumByType(benchmark::State &state) {
+        const auto names = accountNames();
+        auto accounts = objectAccounts(names);
+
+        for (auto _: state) {
+            long long checking{}, saving{};
+            for (const auto &account: accounts) {
+                if (std::strcmp(account->getType(), "saving") == 0) {
+                    saving += account->getAmount();
+                } else {
+                    checking += account->getAmount();
+                }
+            }
+            benchmark::DoNotOptimize(checking);
+            benchmark::DoNotOptimize(saving);
+        }
+
+        state.SetItemsProcessed(state.iterations() * STORE_ACCOUNT_COUNT);
+    }
+
+    void BM_StoreSumByType(benchmark::State &state) {
+        const auto names = accountNames();
+        auto store = storeAccounts(names);
+
+        for (auto _: state) {
+            benchmark::DoNotOptimize(store.sumAmounts(ch06_2::AccountType::Checking));
+            benchmark::DoNotOptimize(store.sumAmounts(ch06_2::AccountType::Saving));
+        }
+
+        state.SetItemsProcessed(state.iterations() * STORE_ACCOUNT_COUNT);
+    }
+}
+
+BENCHMARK(BM_VirtualBank)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_CheckingAccountBank)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_AccountVariantBank)->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_ObjectApplyRate)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_StoreApplyRate)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ObjectSumByType)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_StoreSumByType)->Unit(benchmark::kMillisecond);
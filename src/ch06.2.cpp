@@ -1,84 +1,6 @@
 #include <iostream>
 
-namespace ch06_2 {
-    template<typename T>
-    class Bank {
-    public:
-        void transfer(T &fromAccount, T &toAccount, const long long amount) {
-            std::cout <<
-                      "transfer from account: " << fromAccount.getType() << "/" << fromAccount.getName() <<
-                      " to account: " << toAccount.getType() << "/" << toAccount.getName() <<
-                      " amount: " << amount <<
-                      std::endl;
-
-            fromAccount.setAmount(fromAccount.getAmount() - amount);
-            toAccount.setAmount(toAccount.getAmount() + amount);
-        }
-    };
-
-    class Account {
-    public:
-        virtual ~Account() = default;
-
-        [[nodiscard]] virtual long long getAmount() const = 0;
-
-        virtual void setAmount(long long amount) = 0;
-
-        [[nodiscard]] virtual const char *getType() const = 0;
-
-        [[nodiscard]] virtual const char *getName() const = 0;
-    };
-
-    class CheckingAccount : public Account {
-    public:
-        explicit CheckingAccount(const char *name) : m_name{name}, m_amount{0} {}
-
-        [[nodiscard]] long long getAmount() const override {
-            return this->m_amount;
-        };
-
-        void setAmount(const long long amount) override {
-            this->m_amount = amount;
-        };
-
-        [[nodiscard]] const char *getType() const override {
-            return "checking";
-        };
-
-        [[nodiscard]] const char *getName() const override {
-            return this->m_name;
-        };
-
-    private:
-        const char *m_name;
-        long long m_amount;
-    };
-
-    class SavingAccount : public Account {
-    public:
-        explicit SavingAccount(const char *name) : m_name{name}, m_amount{0} {}
-
-        [[nodiscard]] long long getAmount() const override {
-            return this->m_amount;
-        };
-
-        void setAmount(const long long amount) override {
-            this->m_amount = amount;
-        };
-
-        [[nodiscard]] const char *getType() const override {
-            return "saving";
-        };
-
-        [[nodiscard]] const char *getName() const override {
-            return this->m_name;
-        };
-
-    private:
-        const char *m_name;
-        long long m_amount;
-    };
-}
+#include "ch06.2.h"
 
 int main() {
     ch06_2::CheckingAccount account1{"one"};
@@ -0,0 +1,130 @@
+#ifndef CPPCRASHCOURSE_CH06_2_H
+#define CPPCRASHCOURSE_CH06_2_H
+
+#include <concepts>
+#include <iostream>
+#include <variant>
+
+namespace ch06_2 {
+    template<typename T>
+    concept AccountLike = requires(T &account, const T &constAccount, const long long amount) {
+        { constAccount.getAmount() } -> std::convertible_to<long long>;
+        account.setAmount(amount);
+        { constAccount.getType() } -> std::convertible_to<const char *>;
+        { constAccount.getName() } -> std::convertible_to<const char *>;
+    };
+
+    // With a concrete (final) account type every call below is resolved at compile time and inlined; with
+    // Logging = false the transfer is just the two amount updates.
+    template<AccountLike T, bool Logging = true>
+    class Bank {
+    public:
+        void transfer(T &fromAccount, T &toAccount, const long long amount) {
+            if constexpr (Logging) {
+                std::cout <<
+                          "transfer from account: " << fromAccount.getType() << "/" << fromAccount.getName() <<
+                          " to account: " << toAccount.getType() << "/" << toAccount.getName() <<
+                          " amount: " << amount <<
+                          std::endl;
+            }
+
+            fromAccount.setAmount(fromAccount.getAmount() - amount);
+            toAccount.setAmount(toAccount.getAmount() + amount);
+        }
+    };
+
+    class Account {
+    public:
+        virtual ~Account() = default;
+
+        [[nodiscard]] virtual long long getAmount() const = 0;
+
+        virtual void setAmount(long long amount) = 0;
+
+        [[nodiscard]] virtual const char *getType() const = 0;
+
+        [[nodiscard]] virtual const char *getName() const = 0;
+    };
+
+    class CheckingAccount final : public Account {
+    public:
+        explicit CheckingAccount(const char *name) : m_name{name}, m_amount{0} {}
+
+        [[nodiscard]] long long getAmount() const override {
+            return this->m_amount;
+        };
+
+        void setAmount(const long long amount) override {
+            this->m_amount = amount;
+        };
+
+        [[nodiscard]] const char *getType() const override {
+            return "checking";
+        };
+
+        [[nodiscard]] const char *getName() const override {
+            return this->m_name;
+        };
+
+    private:
+        const char *m_name;
+        long long m_amount;
+    };
+
+    class SavingAccount final : public Account {
+    public:
+        explicit SavingAccount(const char *name) : m_name{name}, m_amount{0} {}
+
+        [[nodiscard]] long long getAmount() const override {
+            return this->m_amount;
+        };
+
+        void setAmount(const long long amount) override {
+            this->m_amount = amount;
+        };
+
+        [[nodiscard]] const char *getType() const override {
+            return "saving";
+        };
+
+        [[nodiscard]] const char *getName() const override {
+            return this->m_name;
+        };
+
+    private:
+        const char *m_name;
+        long long m_amount;
+    };
+
+    // Holds either account type by value and dispatches through std::visit instead of the vtable, so a
+    // Bank<AccountVariant> can move money between checking and saving accounts without virtual calls. The
+    // variant owns a copy of the account it was built from: transfers change the variant, never the original,
+    // which is why building one has to be spelled out.
+    class AccountVariant {
+    public:
+        explicit AccountVariant(const CheckingAccount &account) : m_account{account} {}
+
+        explicit AccountVariant(const SavingAccount &account) : m_account{account} {}
+
+        [[nodiscard]] long long getAmount() const {
+            return std::visit([](const auto &account) { return account.getAmount(); }, this->m_account);
+        }
+
+        void setAmount(const long long amount) {
+            std::visit([amount](auto &account) { account.setAmount(amount); }, this->m_account);
+        }
+
+        [[nodiscard]] const char *getType() const {
+            return std::visit([](const auto &account) { return account.getType(); }, this->m_account);
+        }
+
+        [[nodiscard]] const char *getName() const {
+            return std::visit([](const auto &account) { return account.getName(); }, this->m_account);
+        }
+
+    private:
+        std::variant<CheckingAccount, SavingAccount> m_account;
+    };
+}
+
+#endif //CPPCRASHCOURSE_CH06_2_H
@@ -0,0 +1,259 @@
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "ch10.h"
+#include "ch10-async-service-bus.h"
+#include "ch10-bounded-queue.h"
+
+TEST(Ch10BoundedQueue, PopsInPushOrder) {
+    ch10::BoundedQueue<int> queue{4};
+    for (int i{}; i < 4; i++) {
+        ASSERT_TRUE(queue.try_push(i));
+    }
+
+    int value{};
+    for (int i{}; i < 4; i++) {
+        ASSERT_TRUE(queue.try_pop(value));
+        EXPECT_EQ(i, value);
+    }
+    EXPECT_FALSE(queue.try_pop(value));
+}
+
+TEST(Ch10BoundedQueue, RejectsPushWhenFull) {
+    ch10::BoundedQueue<int> queue{3};
+    ASSERT_EQ(4, queue.capacity());
+
+    for (int i{}; i < 4; i++) {
+        ASSERT_TRUE(queue.try_push(i));
+    }
+    EXPECT_FALSE(queue.try_push(4));
+
+    int value{};
+    ASSERT_TRUE(queue.try_pop(value));
+    EXPECT_TRUE(queue.try_push(4));
+}
+
+TEST(Ch10BoundedQueue, CountsOnlySuccessfulPushes) {
+    ch10::BoundedQueue<int> queue{2};
+    EXPECT_EQ(0u, queue.push_count());
+
+    ASSERT_TRUE(queue.try_push(1));
+    ASSERT_TRUE(queue.try_push(2));
+    EXPECT_FALSE(queue.try_push(3));
+    EXPECT_EQ(2u, queue.push_count());
+
+    int value{};
+    ASSERT_TRUE(queue.try_pop(value));
+    EXPECT_EQ(2u, queue.push_count());
+    ASSERT_TRUE(queue.try_push(3));
+    EXPECT_EQ(3u, queue.push_count());
+}
+
+TEST(Ch10BoundedQueue, KeepsEveryValueFromManyProducers) {
+    constexpr int per_producer{10000};
+    ch10::BoundedQueue<int> queue{64};
+
+    std::vector<std::thread> producers{};
+    for (int p{}; p < 4; p++) {
+        producers.emplace_back([&queue, p] {
+            for (int i{}; i < per_producer; i++) {
+                while (!queue.try_push(p * per_producer + i)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    std::vector<int> last(4, -1);
+    int value{};
+    for (int received{}; received < 4 * per_producer;) {
+        if (!queue.try_pop(value)) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        // values of one producer arrive in the order they were pushed
+        const auto producer = value / per_producer;
+        EXPECT_LT(last[producer], value);
+        last[producer] = value;
+        received++;
+    }
+
+    for (auto& producer: producers) {
+        producer.join();
+    }
+}
+
+struct Ch10AsyncServiceBus : public ::testing::Test {
+    ch10::AsyncServiceBus bus{};
+    ch10::AutoBrake auto_brake{bus};
+
+    std::vector<ch10::TimedBrakeCommand> stop_and_drain() {
+        bus.stop();
+
+        std::vector<ch10::TimedBrakeCommand> commands{};
+        ch10::TimedBrakeCommand command{};
+        while (bus.try_pop(command)) {
+            commands.push_back(command);
+        }
+
+        return commands;
+    }
+};
+
+TEST_F(Ch10AsyncServiceBus, AlertWhenImminentCollisionDetected) {
+    bus.start();
+    ASSERT_TRUE(bus.try_publish(ch10::SpeedUpdate{100.0}));
+    ASSERT_TRUE(bus.try_publish(ch10::CarDetected{100.0, 0.0}));
+
+    const auto commands = stop_and_drain();
+    ASSERT_EQ(1, commands.size());
+    EXPECT_EQ(1.0, commands[0].command.time_to_collision_s);
+    EXPECT_EQ(100.0, auto_brake.get_velocity_mps());
+}
+
+TEST_F(Ch10AsyncServiceBus, KeepsOrderAcrossMessageTypes) {
+    ASSERT_TRUE(bus.try_publish(ch10::SpeedUpdate{100.0}));
+    ASSERT_TRUE(bus.try_publish(ch10::CarDetected{100.0, 0.0}));
+    ASSERT_TRUE(bus.try_publish(ch10::SpeedUpdate{10.0}));
+    ASSERT_TRUE(bus.try_publish(ch10::CarDetected{100.0, 0.0}));
+    bus.start();
+
+    const auto commands = stop_and_drain();
+    ASSERT_EQ(1, commands.size());
+    EXPECT_EQ(1.0, commands[0].command.time_to_collision_s);
+    EXPECT_EQ(10.0, auto_brake.get_velocity_mps());
+}
+
+TEST_F(Ch10AsyncServiceBus, StampsCommandWithSensorTime) {
+    bus.start();
+    ASSERT_TRUE(bus.try_publish(ch10::SpeedUpdate{100.0}));
+    const auto before = std::chrono::steady_clock::now();
+    ASSERT_TRUE(bus.try_publish(ch10::CarDetected{100.0, 0.0}));
+    const auto after = std::chrono::steady_clock::now();
+
+    const auto commands = stop_and_drain();
+    ASSERT_EQ(1, commands.size());
+    EXPECT_LE(before, commands[0].sensed_at);
+    EXPECT_GE(after, commands[0].sensed_at);
+}
+
+TEST_F(Ch10AsyncServiceBus, ConcurrentSensorsDoNotLoseDetections) {
+    // more commands than the output queue holds, so the consumer has to wait for this thread at times
+    constexpr int detections{5000};
+    bus.start();
+    ASSERT_TRUE(bus.try_publish(ch10::SpeedUpdate{100.0}));
+
+    std::thread radar{[this] {
+        for (int i{}; i < detections; i++) {
+            while (!bus.try_publish(ch10::CarDetected{100.0, 0.0})) {
+                std::this_thread::yield();
+            }
+        }
+    }};
+    std::thread speed_sensor{[this] {
+        for (int i{}; i < detections; i++) {
+            while (!bus.try_publish(ch10::SpeedUpdate{100.0})) {
+                std::this_thread::yield();
+            }
+        }
+    }};
+
+    size_t commands{};
+    ch10::TimedBrakeCommand command{};
+    while (commands < detections) {
+        if (bus.try_pop(command)) {
+            commands++;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+
+    radar.join();
+    speed_sensor.join();
+    bus.stop();
+    EXPECT_FALSE(bus.try_pop(command));
+    EXPECT_EQ(0, bus.get_dropped_commands());
+}
+
+TEST_F(Ch10AsyncServiceBus, SleepingConsumerWakesForTheNextMessage) {
+    bus.start();
+
+    for (int round{}; round < 3; round++) {
+        // long enough for the consumer to run out of spins and sleep
+        std::this_thread::sleep_for(std::chrono::milliseconds{20});
+        ASSERT_TRUE(bus.try_publish(ch10::SpeedUpdate{100.0}));
+        ASSERT_TRUE(bus.try_publish(ch10::CarDetected{100.0, 0.0}));
+
+        ch10::TimedBrakeCommand command{};
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds{10};
+        while (!bus.try_pop(command)) {
+            ASSERT_LT(std::chrono::steady_clock::now(), deadline);
+            std::this_thread::yield();
+        }
+    }
+}
+
+TEST(Ch10AsyncServiceBusThreads, FullOutputQueueHoldsBackTheConsumer) {
+    constexpr int detections{100};
+    ch10::AsyncServiceBus bus{1 << 8, 2};
+    ch10::AutoBrake auto_brake{bus};
+    ASSERT_TRUE(bus.try_publish(ch10::SpeedUpdate{100.0}));
+    for (int i{}; i < detections; i++) {
+        ASSERT_TRUE(bus.try_publish(ch10::CarDetected{100.0, 0.0}));
+    }
+    bus.start();
+
+    int commands{};
+    ch10::TimedBrakeCommand command{};
+    while (commands < detections) {
+        if (bus.try_pop(command)) {
+            commands++;
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds{100});
+        }
+    }
+
+    bus.stop();
+    EXPECT_EQ(0, bus.get_dropped_commands());
+}
+
+TEST_F(Ch10AsyncServiceBus, RejectsBrakeCommandsFromOtherThreads) {
+    bus.start();
+    EXPECT_THROW(bus.publish(ch10::BrakeCommand{1.0}), std::logic_error);
+}
+
+TEST_F(Ch10AsyncServiceBus, RejectsASecondStart) {
+    bus.start();
+    EXPECT_THROW(bus.start(), std::logic_error);
+
+    bus.stop();
+    bus.start();
+}
+
+TEST(Ch10AsyncServiceBusThreads, StopRethrowsASubscribersException) {
+    ch10::AsyncServiceBus bus{};
+    ch10::AutoBrake auto_brake{bus};
+    bus.subscribe([](const ch10::SpeedUpdate& update) {
+        if (update.velocity_mps < 0.0) {
+            throw std::runtime_error{"negative speed"};
+        }
+    });
+    bus.start();
+
+    ASSERT_TRUE(bus.try_publish(ch10::SpeedUpdate{-1.0}));
+    ASSERT_TRUE(bus.try_publish(ch10::SpeedUpdate{100.0}));
+    ASSERT_TRUE(bus.try_publish(ch10::CarDetected{100.0, 0.0}));
+
+    EXPECT_THROW(bus.stop(), std::runtime_error);
+    EXPECT_EQ(1, bus.get_failed_messages());
+    EXPECT_EQ(100.0, auto_brake.get_velocity_mps());
+
+    ch10::TimedBrakeCommand command{};
+    EXPECT_TRUE(bus.try_pop(command));
+    EXPECT_NO_THROW(bus.stop());
+}
@@ -0,0 +1,243 @@
+#ifndef CPPCRASHCOURSE_CH10_ASYNC_SERVICE_BUS_H
+#define CPPCRASHCOURSE_CH10_ASYNC_SERVICE_BUS_H
+
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "ch04-trace-span.h"
+#include "ch10.h"
+#include "ch10-bounded-queue.h"
+
+namespace ch10 {
+    struct TimedBrakeCommand {
+        BrakeCommand command;
+        std::chrono::steady_clock::time_point sensed_at;
+    };
+
+    // Sensor threads push SpeedUpdate/CarDetected into one bounded lock-free queue, so they keep their relative
+    // order. A single consumer thread drains it and runs the subscribers (e.g. AutoBrake), so subscriber state is
+    // only ever touched by that thread. Brake commands go out through a second queue, stamped with the time the
+    // message that caused them was published. An idle consumer spins briefly, then sleeps until a sensor publishes.
+    // A subscriber that throws does not end the consumer: the rest of that message's subscribers are skipped, the
+    // next message is dispatched as usual, and stop() rethrows the first exception.
+    class AsyncServiceBus : public IServiceBus {
+    public:
+        explicit AsyncServiceBus(const size_t input_capacity = 1 << 12, const size_t output_capacity = 1 << 12)
+                : m_input{input_capacity}, m_output{output_capacity} {}
+
+        ~AsyncServiceBus() override {
+            try {
+                stop();
+            } catch (...) {
+                // a subscriber's exception nobody called stop() to receive
+            }
+        }
+
+        AsyncServiceBus(const AsyncServiceBus&) = delete;
+
+        AsyncServiceBus& operator=(const AsyncServiceBus&) = delete;
+
+        // Only from subscribers, which run on the consumer thread: that thread alone knows which message is being
+        // dispatched. While the output queue is full the consumer waits for the actuator, so the input queue fills
+        // up and try_publish starts failing instead of commands getting lost. Once stop() was called, commands
+        // that do not fit are counted by get_dropped_commands.
+        void publish(const BrakeCommand& cmd) override {
+            if (t_dispatching != this) {
+                throw std::logic_error{"AsyncServiceBus::publish(BrakeCommand) called outside a subscriber"};
+            }
+
+            const TimedBrakeCommand command{cmd, m_current_sensed_at};
+            for (int attempt{}; !m_output.try_push(command); attempt++) {
+                if (!m_running.load(std::memory_order_acquire)) {
+                    m_dropped_commands.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+
+                if (attempt < SPIN_LIMIT) {
+                    std::this_thread::yield();
+                } else {
+                    std::this_thread::sleep_for(std::chrono::microseconds{50});
+                }
+            }
+        }
+
+        void subscribe(const InplaceFunction<void(const SpeedUpdate&)>& callback) override {
+            m_speed_update_callbacks.push_back(callback);
+        }
+
+        void subscribe(const InplaceFunction<void(const CarDetected&)>& callback) override {
+            m_car_detected_callbacks.push_back(callback);
+        }
+
+        // Safe from any number of sensor threads; returns false when the input queue is full.
+        bool try_publish(const SpeedUpdate& update) {
+            return push_input(update);
+        }
+
+        bool try_publish(const CarDetected& detection) {
+            return push_input(detection);
+        }
+
+        // Safe from one brake actuator thread.
+        bool try_pop(TimedBrakeCommand& command) {
+            return m_output.try_pop(command);
+        }
+
+        // Subscriptions must be made before start, e.g. by constructing AutoBrake first.
+        void start() {
+            if (m_consumer.joinable()) {
+                throw std::logic_error{"AsyncServiceBus already started"};
+            }
+
+            m_subscriber_exception = nullptr;
+            m_running.store(true, std::memory_order_release);
+            m_consumer = std::thread{[this] { run(); }};
+        }
+
+        // Dispatches everything published before the call, then joins the consumer thread and rethrows the first
+        // exception a subscriber threw since start().
+        void stop() {
+            if (!m_consumer.joinable()) {
+                return;
+            }
+
+            m_running.store(false, std::memory_order_release);
+            wake_consumer();
+            m_consumer.join();
+
+            if (m_subscriber_exception) {
+                std::rethrow_exception(std::exchange(m_subscriber_exception, nullptr));
+            }
+        }
+
+        [[nodiscard]] unsigned long long get_dropped_commands() const {
+            return m_dropped_commands.load(std::memory_order_relaxed);
+        }
+
+        // messages whose subscribers threw
+        [[nodiscard]] unsigned long long get_failed_messages() const {
+            return m_failed_messages.load(std::memory_order_relaxed);
+        }
+
+    private:
+        struct Envelope {
+            std::variant<SpeedUpdate, CarDetected> message;
+            std::chrono::steady_clock::time_point published_at;
+        };
+
+        // rounds of yield before the consumer sleeps, or before it backs off from a full output queue
+        static constexpr int SPIN_LIMIT{64};
+
+        // the bus whose consumer runs on this thread, so publish(BrakeCommand) can tell subscribers from others
+        static inline thread_local const AsyncServiceBus* t_dispatching{};
+
+        BoundedQueue<Envelope> m_input;
+        BoundedQueue<TimedBrakeCommand> m_output;
+        std::vector<InplaceFunction<void(const SpeedUpdate&)>> m_speed_update_callbacks{};
+        std::vector<InplaceFunction<void(const CarDetected&)>> m_car_detected_callbacks{};
+        // only touched by the consumer thread
+        std::chrono::steady_clock::time_point m_current_sensed_at{};
+        std::atomic<unsigned long long> m_dropped_commands{};
+        std::atomic<unsigned long long> m_failed_messages{};
+        // written by the consumer thread, read by stop() once it is joined
+        std::exception_ptr m_subscriber_exception{};
+        std::atomic<bool> m_running{};
+        std::atomic<bool> m_sleeping{};
+        std::atomic<unsigned> m_wakeups{};
+        std::thread m_consumer{};
+
+        template<typename Message>
+        bool push_input(const Message& message) {
+            if (!m_input.try_push(Envelope{message, std::chrono::steady_clock::now()})) {
+                return false;
+            }
+
+            // Pairs with the fence in sleep(): either the consumer sees this message before it waits, or this
+            // thread sees it sleeping. Sensors only make the futex call when the consumer actually sleeps.
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (m_sleeping.load(std::memory_order_relaxed)) {
+                wake_consumer();
+            }
+
+            return true;
+        }
+
+        void wake_consumer() {
+            m_wakeups.fetch_add(1, std::memory_order_release);
+            m_wakeups.notify_one();
+        }
+
+        void run() {
+            t_dispatching = this;
+            Envelope envelope{};
+
+            for (int idle{};;) {
+                const auto stopping = !m_running.load(std::memory_order_acquire);
+
+                auto drained = false;
+                while (m_input.try_pop(envelope)) {
+                    try {
+                        dispatch(envelope);
+                    } catch (...) {
+                        if (!m_subscriber_exception) {
+                            m_subscriber_exception = std::current_exception();
+                        }
+                        m_failed_messages.fetch_add(1, std::memory_order_relaxed);
+                    }
+                    drained = true;
+                }
+
+                if (stopping) {
+                    t_dispatching = nullptr;
+                    return;
+                }
+
+                if (drained) {
+                    idle = 0;
+                } else if (++idle < SPIN_LIMIT) {
+                    std::this_thread::yield();
+                } else {
+                    sleep();
+                    idle = 0;
+                }
+            }
+        }
+
+        // Waits on m_wakeups as read before the last look at the queue, so a wake-up that comes after that look
+        // returns at once instead of being lost.
+        void sleep() {
+            const auto wakeups = m_wakeups.load(std::memory_order_acquire);
+            m_sleeping.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+
+            if (m_input.empty() && m_running.load(std::memory_order_acquire)) {
+                m_wakeups.wait(wakeups, std::memory_order_acquire);
+            }
+            m_sleeping.store(false, std::memory_order_relaxed);
+        }
+
+        void dispatch(const Envelope& envelope) {
+            CH04_TRACE_SPAN("AsyncServiceBus::dispatch");
+            m_current_sensed_at = envelope.published_at;
+
+            if (const auto* update = std::get_if<SpeedUpdate>(&envelope.message)) {
+                for (const auto& callback: m_speed_update_callbacks) {
+                    callback(*update);
+                }
+            } else {
+                const auto& detection = std::get<CarDetected>(envelope.message);
+                for (const auto& callback: m_car_detected_callbacks) {
+                    callback(detection);
+                }
+            }
+        }
+    };
+}
+
+#endif //CPPCRASHCOURSE_CH10_ASYNC_SERVICE_BUS_H
@@ -0,0 +1,458 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <malloc.h>
+
+#include <benchmark/benchmark.h>
+
+#include "ch10.h"
+#include "ch10-async-service-bus.h"
+#include "ch10-coroutine-bus.h"
+#include "ch10-inplace-function.h"
+#include "ch10-service-bus.h"
+#include "ch10-trace.h"
+#include "ch10-tracking-auto-brake.h"
+
+namespace {
+    void BM_ServiceBusPublish(benchmark::State &state) {
+        ch10::ServiceBus bus{};
+        double sum{};
+
+        for (long i{}; i < state.range(0); i++) {
+            bus.subscribe<ch10::SpeedUpdate>([&sum](const ch10::SpeedUpdate &update) {
+                sum += update.velocity_mps;
+            });
+        }
+
+        for (auto _: state) {
+            bus.publish(ch10::SpeedUpdate{1.0});
+        }
+
+        benchmark::DoNotOptimize(sum);
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    // every callback records how long after the start of publish it ran
+    void BM_ServiceBusPublishLatency(benchmark::State &state) {
+        ch10::ServiceBus bus{};
+        std::chrono::steady_clock::time_point published{};
+        std::vector<long long> latencies;
+        latencies.reserve(1 << 22);
+
+        for (long i{}; i < state.range(0); i++) {
+            bus.subscribe<ch10::SpeedUpdate>([&published, &latencies](const ch10::SpeedUpdate &) {
+                if (latencies.size() < latencies.capacity()) {
+                    latencies.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            std::chrono::steady_clock::now() - published).count());
+                }
+            });
+        }
+
+        for (auto _: state) {
+            published = std::chrono::steady_clock::now();
+            bus.publish(ch10::SpeedUpdate{1.0});
+        }
+
+        std::sort(latencies.begin(), latencies.end());
+        state.counters["p50_ns"] = static_cast<double>(latencies[latencies.size() / 2]);
+        state.counters["p99_ns"] = static_cast<double>(latencies[latencies.size() * 99 / 100]);
+        state.counters["p999_ns"] = static_cast<double>(latencies[latencies.size() * 999 / 1000]);
+        state.counters["max_ns"] = static_cast<double>(latencies.back());
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    std::vector<ch10::CarDetected> make_frame(const size_t size) {
+        std::mt19937_64 random{42};
+        std::uniform_real_distribution<double> distance_m{1.0, 500.0};
+        std::uniform_real_distribution<double> velocity_mps{0.0, 60.0};
+
+        std::vector<ch10::CarDetected> frame(size);
+        for (auto &detection: frame) {
+            detection = ch10::CarDetected{distance_m(random), velocity_mps(random)};
+        }
+
+        return frame;
+    }
+
+    void set_frame_counters(benchmark::State &state) {
+        const auto detections = static_cast<double>(state.iterations() * state.range(0));
+        state.counters["per_detection"] = benchmark::Counter{detections, benchmark::Counter::kIsRate | benchmark::Counter::kInvert};
+        state.counters["per_frame"] = benchmark::Counter{static_cast<double>(state.iterations()), benchmark::Counter::kIsRate | benchmark::Counter::kInvert};
+    }
+
+    // one bus message per detection, as the radar front-end would have to deliver a frame today
+    void BM_AutoBrakeObserve(benchmark::State &state) {
+        ch10::ServiceBus bus{};
+        ch10::AutoBrake auto_brake{bus};
+        size_t commands{};
+        bus.subscribe<ch10::BrakeCommand>([&commands](const ch10::BrakeCommand &) {
+            commands++;
+        });
+        bus.publish(ch10::SpeedUpdate{30.0});
+        const auto frame = make_frame(static_cast<size_t>(state.range(0)));
+
+        for (auto _: state) {
+            for (const auto &detection: frame) {
+                bus.publish(detection);
+            }
+        }
+
+        benchmark::DoNotOptimize(commands);
+        set_frame_counters(state);
+    }
+
+    void BM_AutoBrakeObserveBatch(benchmark::State &state) {
+        ch10::ServiceBus bus{};
+        ch10::AutoBrake auto_brake{bus};
+        size_t commands{};
+        bus.subscribe<ch10::BrakeCommand>([&commands](const ch10::BrakeCommand &) {
+            commands++;
+        });
+        bus.publish(ch10::SpeedUpdate{30.0});
+        const auto frame = make_frame(static_cast<size_t>(state.range(0)));
+
+        for (auto _: state) {
+            auto_brake.observe_batch(frame);
+        }
+
+        benchmark::DoNotOptimize(commands);
+        set_frame_counters(state);
+    }
+
+    // state.range(0) tracks reported every frame; state.range(1) percent of them move between frames, the rest
+    // repeat their last report
+    void BM_TrackingAutoBrakeFrame(benchmark::State &state) {
+        ch10::ServiceBus bus{};
+        ch10::TrackingAutoBrake auto_brake{bus};
+        size_t commands{};
+        bus.subscribe<ch10::BrakeCommand>([&commands](const ch10::BrakeCommand &) {
+            commands++;
+        });
+        bus.publish(ch10::SpeedUpdate{30.0});
+
+        const auto tracks = static_cast<size_t>(state.range(0));
+        const auto moving = tracks * static_cast<size_t>(state.range(1)) / 100;
+        std::mt19937_64 random{42};
+        std::uniform_real_distribution<double> step_m{-0.5, 0.5};
+
+        std::vector<ch10::TrackedCarDetected> frame{};
+        for (const auto &detection: make_frame(tracks)) {
+            frame.push_back(ch10::TrackedCarDetected{static_cast<unsigned>(random()), detection.distance_m, detection.velocity_mps});
+        }
+
+        // let the smoothed state of the still tracks settle on their reports
+        for (int i{}; i < 64; i++) {
+            auto_brake.observe_frame(frame);
+        }
+
+        const auto evaluations = auto_brake.get_evaluations();
+        for (auto _: state) {
+            state.PauseTiming();
+            for (size_t i{}; i < moving; i++) {
+                frame[i].distance_m = std::max(1.0, frame[i].distance_m + step_m(random));
+            }
+            state.ResumeTiming();
+
+            auto_brake.observe_frame(frame);
+        }
+
+        benchmark::DoNotOptimize(commands);
+        state.counters["evaluations_per_frame"] = static_cast<double>(auto_brake.get_evaluations() - evaluations)
+                / static_cast<double>(state.iterations());
+        state.counters["per_frame"] = benchmark::Counter{static_cast<double>(state.iterations()), benchmark::Counter::kIsRate | benchmark::Counter::kInvert};
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+
+    // CH10_TRACE may name a trace recorded from real traffic; otherwise one is synthesized: a speed update
+    // followed by a radar frame of 16 detections, repeated. The synthesized trace is written afresh by every run,
+    // once, so a file left by an older format or an aborted run is never replayed.
+    std::string trace_path() {
+        if (const auto *path = std::getenv("CH10_TRACE")) {
+            return path;
+        }
+
+        static const auto path = [] {
+            auto path = (std::filesystem::temp_directory_path() / "ch10-bench.trace").string();
+
+            ch10::ServiceBus bus{};
+            ch10::TraceRecorder recorder{bus, path};
+            ch10::AutoBrake auto_brake{recorder};
+
+            std::mt19937_64 random{42};
+            std::uniform_real_distribution<double> speed_mps{20.0, 40.0};
+            const auto frame = make_frame(1 << 16);
+            for (size_t i{}; i < frame.size(); i++) {
+                if (i % 16 == 0) {
+                    bus.publish(ch10::SpeedUpdate{speed_mps(random)});
+                }
+                bus.publish(frame[i]);
+            }
+
+            return path;
+        }();
+
+        return path;
+    }
+
+    void BM_TraceReplay(benchmark::State &state) {
+        ch10::TraceReplayer replayer{trace_path()};
+        ch10::AutoBrake auto_brake{replayer};
+
+        ch10::ReplayResult result{};
+        for (auto _: state) {
+            result = replayer.replay();
+        }
+
+        if (result.brake_commands != result.recorded_brake_commands) {
+            state.SkipWithError("replay produced different brake commands than the recording");
+        }
+        state.counters["brake_commands"] = static_cast<double>(result.brake_commands);
+        state.SetItemsProcessed(state.iterations() * static_cast<long long>(result.messages));
+    }
+
+    // a subscriber capturing three references, like a controller wired to a bus and two of its own members
+    template<typename Function>
+    void BM_Subscribe(benchmark::State &state) {
+        double velocity_mps{};
+        size_t updates{};
+        std::vector<Function> callbacks{};
+        callbacks.reserve(1 << 16);
+
+        // glibc's count of heap bytes in use, read only around the clears, so the loop runs on the plain allocator
+        size_t heap_bytes{};
+        auto before = mallinfo2().uordblks;
+        for (auto _: state) {
+            if (callbacks.size() == callbacks.capacity()) {
+                state.PauseTiming();
+                heap_bytes += mallinfo2().uordblks - before;
+                callbacks.clear();
+                before = mallinfo2().uordblks;
+                state.ResumeTiming();
+            }
+
+            callbacks.emplace_back([&state, &velocity_mps, &updates](const ch10::SpeedUpdate &update) {
+                velocity_mps = update.velocity_mps;
+                updates += static_cast<size_t>(state.range(0));
+            });
+        }
+        heap_bytes += mallinfo2().uordblks - before;
+
+        state.counters["heap_bytes_per_subscribe"] = static_cast<double>(heap_bytes)
+                / static_cast<double>(state.iterations());
+    }
+
+    template<typename Function>
+    void BM_Dispatch(benchmark::State &state) {
+        double velocity_mps{};
+        size_t updates{};
+        std::vector<Function> callbacks{};
+        for (long i{}; i < state.range(0); i++) {
+            callbacks.emplace_back([&state, &velocity_mps, &updates](const ch10::SpeedUpdate &update) {
+                velocity_mps = update.velocity_mps;
+                updates += static_cast<size_t>(state.range(0));
+            });
+        }
+
+        const ch10::SpeedUpdate update{1.0};
+        for (auto _: state) {
+            for (const auto &callback: callbacks) {
+                callback(update);
+            }
+        }
+
+        benchmark::DoNotOptimize(velocity_mps);
+        benchmark::DoNotOptimize(updates);
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+
+    using StdFunction = std::function<void(const ch10::SpeedUpdate &)>;
+    using InplaceFunction = ch10::InplaceFunction<void(const ch10::SpeedUpdate &)>;
+
+    // state.range(0) coroutine controllers on one executor; every iteration delivers a SpeedUpdate and a
+    // CarDetected to all of them
+    void BM_CoroutineControllers(benchmark::State &state) {
+        ch10::Executor executor{};
+        ch10::CoroutineBus bus{executor};
+        size_t commands{};
+        bus.subscribe([&commands](const ch10::BrakeCommand &) {
+            commands++;
+        });
+
+        for (long i{}; i < state.range(0); i++) {
+            executor.spawn(ch10::auto_brake_controller(bus));
+        }
+        executor.run();
+
+        for (auto _: state) {
+            bus.publish(ch10::SpeedUpdate{30.0});
+            bus.publish(ch10::CarDetected{100.0, 0.0});
+        }
+
+        benchmark::DoNotOptimize(commands);
+        state.counters["controller_messages"] = benchmark::Counter{
+                static_cast<double>(state.iterations() * state.range(0) * 2), benchmark::Counter::kIsRate};
+    }
+
+    // The same controllers with one thread each, blocked on a condition variable until the next message; the
+    // publisher waits until every controller has handled it before sending the next one.
+    void BM_ThreadControllers(benchmark::State &state) {
+        const auto controllers = static_cast<size_t>(state.range(0));
+        std::mutex mutex{};
+        std::condition_variable published{};
+        std::condition_variable handled{};
+        unsigned long long generation{};
+        size_t remaining{};
+        auto stopping = false;
+        ch10::SpeedUpdate update{};
+        ch10::CarDetected detection{};
+        std::atomic<size_t> commands{};
+
+        std::vector<std::thread> threads{};
+        for (size_t i{}; i < controllers; i++) {
+            threads.emplace_back([&] {
+                unsigned long long seen{};
+                ch10::SpeedUpdate speed{};
+
+                for (;;) {
+                    std::unique_lock lock{mutex};
+                    published.wait(lock, [&] { return generation != seen || stopping; });
+                    if (stopping) {
+                        return;
+                    }
+                    seen = generation;
+
+                    // odd generations carry a SpeedUpdate, even ones a CarDetected
+                    if (seen % 2 == 1) {
+                        speed = update;
+                    } else {
+                        const auto car = detection;
+                        lock.unlock();
+
+                        const auto relative_velocity_mps = speed.velocity_mps - car.velocity_mps;
+                        if (relative_velocity_mps > 0.0 && car.distance_m / relative_velocity_mps <= 5.0) {
+                            commands.fetch_add(1, std::memory_order_relaxed);
+                        }
+                        lock.lock();
+                    }
+
+                    if (--remaining == 0) {
+                        handled.notify_one();
+                    }
+                }
+            });
+        }
+
+        const auto deliver = [&](const auto &store) {
+            std::unique_lock lock{mutex};
+            store();
+            generation++;
+            remaining = controllers;
+            published.notify_all();
+            handled.wait(lock, [&] { return remaining == 0; });
+        };
+
+        for (auto _: state) {
+            deliver([&] { update = ch10::SpeedUpdate{30.0}; });
+            deliver([&] { detection = ch10::CarDetected{100.0, 0.0}; });
+        }
+
+        {
+            std::lock_guard lock{mutex};
+            stopping = true;
+        }
+        published.notify_all();
+        for (auto &thread: threads) {
+            thread.join();
+        }
+
+        state.counters["controller_messages"] = benchmark::Counter{
+                static_cast<double>(state.iterations() * state.range(0) * 2), benchmark::Counter::kIsRate};
+    }
+
+    // a speed sensor and a radar thread each publish state.range(0) / 2 messages per second for one second;
+    // every detection is close enough to brake, and the actuator (this thread) measures sensor-to-brake latency
+    void BM_AsyncServiceBusLatency(benchmark::State &state) {
+        const auto messages_per_second = state.range(0);
+        const auto interval = std::chrono::nanoseconds{2'000'000'000 / messages_per_second};
+        const auto messages_per_sensor = messages_per_second / 2;
+        std::vector<long long> latencies;
+        latencies.reserve(static_cast<size_t>(messages_per_sensor));
+        unsigned long long rejected{};
+
+        for (auto _: state) {
+            ch10::AsyncServiceBus bus{};
+            ch10::AutoBrake auto_brake{bus};
+            bus.start();
+
+            std::atomic<unsigned long long> full{};
+            const auto sensor = [&](const auto message) {
+                auto next = std::chrono::steady_clock::now();
+                for (long i{}; i < messages_per_sensor; i++) {
+                    while (std::chrono::steady_clock::now() < next) {
+                        std::this_thread::yield();
+                    }
+                    next += interval;
+
+                    if (!bus.try_publish(message)) {
+                        full.fetch_add(1, std::memory_order_relaxed);
+                    }
+                }
+            };
+
+            latencies.clear();
+            std::thread speed_sensor{sensor, ch10::SpeedUpdate{100.0}};
+            std::thread radar{sensor, ch10::CarDetected{100.0, 0.0}};
+
+            ch10::TimedBrakeCommand command{};
+            const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds{2};
+            while (latencies.size() < latencies.capacity() && std::chrono::steady_clock::now() < deadline) {
+                if (!bus.try_pop(command)) {
+                    std::this_thread::yield();
+                    continue;
+                }
+
+                latencies.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now() - command.sensed_at).count());
+            }
+
+            speed_sensor.join();
+            radar.join();
+            bus.stop();
+            rejected += full.load();
+        }
+
+        std::sort(latencies.begin(), latencies.end());
+        if (!latencies.empty()) {
+            state.counters["p50_ns"] = static_cast<double>(latencies[latencies.size() / 2]);
+            state.counters["p99_ns"] = static_cast<double>(latencies[latencies.size() * 99 / 100]);
+            state.counters["p999_ns"] = static_cast<double>(latencies[latencies.size() * 999 / 1000]);
+            state.counters["max_ns"] = static_cast<double>(latencies.back());
+        }
+        state.counters["brakes"] = static_cast<double>(latencies.size());
+        state.counters["rejected"] = static_cast<double>(rejected);
+    }
+}
+
+BENCHMARK(BM_ServiceBusPublish)->Arg(1)->Arg(8)->Arg(64);
+BENCHMARK(BM_ServiceBusPublishLatency)->Arg(1)->Arg(8)->Arg(64);
+BENCHMARK(BM_AsyncServiceBusLatency)->Arg(100'000)->Iterations(1)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_AutoBrakeObserve)->RangeMultiplier(4)->Range(16, 4096);
+BENCHMARK(BM_AutoBrakeObserveBatch)->RangeMultiplier(4)->Range(16, 4096);
+BENCHMARK(BM_TrackingAutoBrakeFrame)->Args({10'000, 100})->Args({10'000, 10})->Args({10'000, 0});
+BENCHMARK(BM_TraceReplay);
+BENCHMARK_TEMPLATE(BM_Subscribe, StdFunction)->Arg(1);
+BENCHMARK_TEMPLATE(BM_Subscribe, InplaceFunction)->Arg(1);
+BENCHMARK_TEMPLATE(BM_Dispatch, StdFunction)->Arg(1)->Arg(64);
+BENCHMARK_TEMPLATE(BM_Dispatch, InplaceFunction)->Arg(1)->Arg(64);
+BENCHMARK(BM_CoroutineControllers)->RangeMultiplier(8)->Range(8, 32'768);
+BENCHMARK(BM_ThreadControllers)->RangeMultiplier(8)->Range(8, 4096)->UseRealTime();
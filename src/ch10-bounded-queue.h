@@ -0,0 +1,86 @@
+#ifndef CPPCRASHCOURSE_CH10_BOUNDED_QUEUE_H
+#define CPPCRASHCOURSE_CH10_BOUNDED_QUEUE_H
+
+#include <atomic>
+#include <bit>
+#include <memory>
+
+namespace ch10 {
+    // Bounded lock-free queue (Vyukov): every cell carries a sequence number telling producers and the consumer
+    // whose turn it is, so any number of threads may push while one thread pops.
+    template<typename T>
+    class BoundedQueue {
+    public:
+        explicit BoundedQueue(const size_t capacity)
+                : m_mask{std::bit_ceil(capacity < 2 ? 2 : capacity) - 1},
+                  m_cells{std::make_unique<Cell[]>(m_mask + 1)} {
+            for (size_t i{}; i <= m_mask; i++) {
+                m_cells[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        bool try_push(const T& value) {
+            auto position = m_enqueue_position.load(std::memory_order_relaxed);
+
+            for (;;) {
+                auto& cell = m_cells[position & m_mask];
+                const auto sequence = cell.sequence.load(std::memory_order_acquire);
+                const auto difference = static_cast<long long>(sequence) - static_cast<long long>(position);
+
+                if (difference == 0) {
+                    if (m_enqueue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                        cell.value = value;
+                        cell.sequence.store(position + 1, std::memory_order_release);
+                        return true;
+                    }
+                } else if (difference < 0) {
+                    return false;
+                } else {
+                    position = m_enqueue_position.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        bool try_pop(T& value) {
+            auto& cell = m_cells[m_dequeue_position & m_mask];
+            if (cell.sequence.load(std::memory_order_acquire) != m_dequeue_position + 1) {
+                return false;
+            }
+
+            value = cell.value;
+            cell.sequence.store(m_dequeue_position + m_mask + 1, std::memory_order_release);
+            m_dequeue_position++;
+
+            return true;
+        }
+
+        // Only meaningful on the consumer thread, like try_pop.
+        [[nodiscard]] bool empty() const {
+            return m_cells[m_dequeue_position & m_mask].sequence.load(std::memory_order_acquire)
+                   != m_dequeue_position + 1;
+        }
+
+        // Pushes claimed so far, counting ones still being written; a consumer that has popped this many values
+        // has seen every push that returned before the call.
+        [[nodiscard]] size_t push_count() const {
+            return m_enqueue_position.load(std::memory_order_acquire);
+        }
+
+        [[nodiscard]] size_t capacity() const {
+            return m_mask + 1;
+        }
+
+    private:
+        struct Cell {
+            std::atomic<size_t> sequence;
+            T value;
+        };
+
+        size_t m_mask;
+        std::unique_ptr<Cell[]> m_cells;
+        alignas(64) std::atomic<size_t> m_enqueue_position{};
+        alignas(64) size_t m_dequeue_position{};
+    };
+}
+
+#endif //CPPCRASHCOURSE_CH10_BOUNDED_QUEUE_H
@@ -0,0 +1,131 @@
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "ch10.h"
+#include "ch10-coroutine-bus.h"
+
+struct Ch10CoroutineBus : public ::testing::Test {
+    ch10::Executor executor{};
+    ch10::CoroutineBus bus{executor};
+    std::vector<ch10::BrakeCommand> brake_commands{};
+
+    void SetUp() override {
+        bus.subscribe([this](const ch10::BrakeCommand& cmd) {
+            brake_commands.push_back(cmd);
+        });
+    }
+};
+
+TEST_F(Ch10CoroutineBus, SpawnedTaskRunsUntilItWaits) {
+    executor.spawn(ch10::auto_brake_controller(bus));
+    EXPECT_EQ(0, bus.waiter_count<ch10::SpeedUpdate>());
+
+    executor.run();
+    EXPECT_EQ(1, bus.waiter_count<ch10::SpeedUpdate>());
+    EXPECT_EQ(0, bus.waiter_count<ch10::CarDetected>());
+}
+
+TEST_F(Ch10CoroutineBus, ControllerBrakesOnImminentCollision) {
+    executor.spawn(ch10::auto_brake_controller(bus));
+    executor.run();
+
+    bus.publish(ch10::SpeedUpdate{100.0});
+    EXPECT_EQ(1, bus.waiter_count<ch10::CarDetected>());
+    bus.publish(ch10::CarDetected{100.0, 0.0});
+
+    ASSERT_EQ(1, brake_commands.size());
+    EXPECT_EQ(1.0, brake_commands[0].time_to_collision_s);
+    EXPECT_EQ(1, bus.waiter_count<ch10::SpeedUpdate>());
+}
+
+TEST_F(Ch10CoroutineBus, NoBrakeWhenNotImminent) {
+    executor.spawn(ch10::auto_brake_controller(bus));
+    executor.run();
+
+    bus.publish(ch10::SpeedUpdate{100.0});
+    bus.publish(ch10::CarDetected{1000.0, 50.0});
+
+    EXPECT_TRUE(brake_commands.empty());
+}
+
+TEST_F(Ch10CoroutineBus, EveryWaitingControllerReceivesTheMessage) {
+    for (int i{}; i < 1000; i++) {
+        executor.spawn(ch10::auto_brake_controller(bus));
+    }
+    executor.run();
+
+    bus.publish(ch10::SpeedUpdate{100.0});
+    bus.publish(ch10::CarDetected{100.0, 0.0});
+
+    EXPECT_EQ(1000, brake_commands.size());
+    EXPECT_EQ(1000, bus.waiter_count<ch10::SpeedUpdate>());
+}
+
+TEST_F(Ch10CoroutineBus, CoroutineCanAwaitBrakeCommands) {
+    executor.spawn(ch10::auto_brake_controller(bus));
+
+    std::vector<double> observed{};
+    executor.spawn([](ch10::CoroutineBus& bus, std::vector<double>& observed) -> ch10::Task {
+        for (;;) {
+            observed.push_back((co_await bus.next<ch10::BrakeCommand>()).time_to_collision_s);
+        }
+    }(bus, observed));
+    executor.run();
+
+    bus.publish(ch10::SpeedUpdate{100.0});
+    bus.publish(ch10::CarDetected{200.0, 0.0});
+    bus.publish(ch10::SpeedUpdate{100.0});
+    bus.publish(ch10::CarDetected{300.0, 0.0});
+
+    EXPECT_EQ((std::vector<double>{2.0, 3.0}), observed);
+}
+
+TEST_F(Ch10CoroutineBus, ExceptionsEscapeRun) {
+    executor.spawn([](ch10::CoroutineBus& bus) -> ch10::Task {
+        co_await bus.next<ch10::SpeedUpdate>();
+        throw std::runtime_error{"controller failed"};
+    }(bus));
+    executor.run();
+
+    EXPECT_THROW(bus.publish(ch10::SpeedUpdate{1.0}), std::runtime_error);
+    EXPECT_EQ(0, executor.task_count());
+}
+
+TEST_F(Ch10CoroutineBus, FinishedTasksAreDestroyed) {
+    for (int i{}; i < 1000; i++) {
+        executor.spawn([](ch10::CoroutineBus& bus) -> ch10::Task {
+            co_await bus.next<ch10::SpeedUpdate>();
+        }(bus));
+    }
+    executor.spawn(ch10::auto_brake_controller(bus));
+    executor.run();
+    EXPECT_EQ(1001, executor.task_count());
+
+    bus.publish(ch10::SpeedUpdate{100.0});
+    EXPECT_EQ(1, executor.task_count());
+}
+
+TEST(Ch10CoroutineBusLifetime, DestroyedTasksStopWaiting) {
+    std::optional<ch10::Executor> executor{std::in_place};
+    ch10::CoroutineBus bus{*executor};
+    executor->spawn(ch10::auto_brake_controller(bus));
+    executor->spawn(ch10::auto_brake_controller(bus));
+    executor->run();
+    EXPECT_EQ(2, bus.waiter_count<ch10::SpeedUpdate>());
+
+    executor.reset();
+    EXPECT_EQ(0, bus.waiter_count<ch10::SpeedUpdate>());
+}
+
+TEST_F(Ch10CoroutineBus, AutoBrakeCallbacksKeepWorking) {
+    ch10::AutoBrake auto_brake{bus};
+
+    bus.publish(ch10::SpeedUpdate{100.0});
+    bus.publish(ch10::CarDetected{100.0, 0.0});
+
+    EXPECT_EQ(100.0, auto_brake.get_velocity_mps());
+    ASSERT_EQ(1, brake_commands.size());
+}
@@ -0,0 +1,285 @@
+#ifndef CPPCRASHCOURSE_CH10_COROUTINE_BUS_H
+#define CPPCRASHCOURSE_CH10_COROUTINE_BUS_H
+
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "ch10.h"
+
+namespace ch10 {
+    // A coroutine started by an Executor. It does not run until spawned, and its frame is destroyed with the
+    // Task; the Executor that owns it destroys it as soon as it finishes, or with the Executor.
+    class Task {
+    public:
+        struct promise_type {
+            Task get_return_object() {
+                return Task{std::coroutine_handle<promise_type>::from_promise(*this)};
+            }
+
+            std::suspend_always initial_suspend() noexcept {
+                return {};
+            }
+
+            std::suspend_always final_suspend() noexcept {
+                return {};
+            }
+
+            void return_void() {}
+
+            // propagates out of the Executor::run that resumed the coroutine
+            void unhandled_exception() {
+                throw;
+            }
+        };
+
+        Task(Task&& other) noexcept : m_handle{std::exchange(other.m_handle, {})} {}
+
+        Task& operator=(Task&& other) noexcept {
+            if (this != &other) {
+                destroy();
+                m_handle = std::exchange(other.m_handle, {});
+            }
+
+            return *this;
+        }
+
+        ~Task() {
+            destroy();
+        }
+
+        [[nodiscard]] bool done() const {
+            return !m_handle || m_handle.done();
+        }
+
+    private:
+        friend class Executor;
+
+        std::coroutine_handle<promise_type> m_handle;
+
+        explicit Task(const std::coroutine_handle<promise_type> handle) : m_handle{handle} {}
+
+        void destroy() {
+            if (m_handle) {
+                m_handle.destroy();
+                m_handle = {};
+            }
+        }
+    };
+
+    // Single-threaded executor: resumes ready coroutines one after another on the thread calling run, so any
+    // number of controllers share one core without locks.
+    class Executor {
+    public:
+        void spawn(Task task) {
+            schedule(task.m_handle);
+            const auto address = task.m_handle.address();
+            m_tasks.emplace(address, std::move(task));
+        }
+
+        void schedule(const std::coroutine_handle<> handle) {
+            m_ready.push_back(handle);
+        }
+
+        // Runs until no coroutine is ready. Calls from inside a running coroutine return at once; the outer
+        // run picks up whatever they would have run.
+        void run() {
+            if (m_running) {
+                return;
+            }
+
+            m_running = true;
+            try {
+                while (!m_ready.empty()) {
+                    const auto handle = m_ready.front();
+                    m_ready.pop_front();
+                    resume(handle);
+                }
+            } catch (...) {
+                m_running = false;
+                throw;
+            }
+            m_running = false;
+        }
+
+        [[nodiscard]] size_t task_count() const {
+            return m_tasks.size();
+        }
+
+    private:
+        std::deque<std::coroutine_handle<>> m_ready{};
+        // keyed by frame address, so a finished coroutine finds its Task
+        std::unordered_map<void*, Task> m_tasks{};
+        bool m_running{};
+
+        // a coroutine that finished, or threw, is at its final suspend point and its frame is freed right away
+        void resume(const std::coroutine_handle<> handle) {
+            try {
+                handle.resume();
+            } catch (...) {
+                m_tasks.erase(handle.address());
+                throw;
+            }
+
+            if (handle.done()) {
+                m_tasks.erase(handle.address());
+            }
+        }
+    };
+
+    // IServiceBus whose messages can also be awaited: co_await bus.next<SpeedUpdate>() suspends until the next
+    // SpeedUpdate is published. Every coroutine waiting when a message is published receives it, and publish runs
+    // the executor, so they have all reacted (and may wait again) before publish returns.
+    class CoroutineBus : public IServiceBus {
+    public:
+        explicit CoroutineBus(Executor& executor) : m_executor{executor} {}
+
+        // the coroutines still waiting outlive the bus only to be destroyed, so their awaiters let go of it
+        ~CoroutineBus() override {
+            std::apply([](auto&... waiters) {
+                (release(waiters), ...);
+            }, m_waiters);
+        }
+
+        CoroutineBus(const CoroutineBus&) = delete;
+
+        CoroutineBus& operator=(const CoroutineBus&) = delete;
+
+        // Lives in the frame of the waiting coroutine; destroying that coroutine while it waits takes it off
+        // the bus, so no waiter is left behind for a frame that is gone.
+        template<typename Message>
+        class NextAwaiter {
+        public:
+            explicit NextAwaiter(CoroutineBus& bus) : m_bus{bus} {}
+
+            ~NextAwaiter() {
+                if (m_waiting) {
+                    std::erase_if(std::get<Waiters<Message>>(m_bus.m_waiters), [this](const Waiter<Message>& waiter) {
+                        return waiter.awaiter == this;
+                    });
+                }
+            }
+
+            NextAwaiter(const NextAwaiter&) = delete;
+
+            NextAwaiter& operator=(const NextAwaiter&) = delete;
+
+            bool await_ready() const noexcept {
+                return false;
+            }
+
+            void await_suspend(const std::coroutine_handle<> handle) {
+                std::get<Waiters<Message>>(m_bus.m_waiters).push_back(Waiter<Message>{handle, this});
+                m_waiting = true;
+            }
+
+            Message await_resume() const noexcept {
+                return m_message;
+            }
+
+        private:
+            friend class CoroutineBus;
+
+            CoroutineBus& m_bus;
+            Message m_message{};
+            bool m_waiting{};
+        };
+
+        template<typename Message>
+        NextAwaiter<Message> next() {
+            return NextAwaiter<Message>{*this};
+        }
+
+        template<typename Message>
+        void publish(const Message& message) {
+            for (const auto& callback: std::get<Callbacks<Message>>(m_callbacks)) {
+                callback(message);
+            }
+
+            // waiters that wait again while this message is handled wait for the next one
+            auto& waiters = std::get<Waiters<Message>>(m_waiters);
+            auto& delivering = std::get<Waiters<Message>>(m_delivering);
+            std::swap(waiters, delivering);
+            for (const auto& waiter: delivering) {
+                waiter.awaiter->m_message = message;
+                waiter.awaiter->m_waiting = false;
+                m_executor.schedule(waiter.handle);
+            }
+            delivering.clear();
+
+            m_executor.run();
+        }
+
+        void publish(const BrakeCommand& cmd) override {
+            publish<BrakeCommand>(cmd);
+        }
+
+        void subscribe(const InplaceFunction<void(const SpeedUpdate&)>& callback) override {
+            std::get<Callbacks<SpeedUpdate>>(m_callbacks).push_back(callback);
+        }
+
+        void subscribe(const InplaceFunction<void(const CarDetected&)>& callback) override {
+            std::get<Callbacks<CarDetected>>(m_callbacks).push_back(callback);
+        }
+
+        void subscribe(const InplaceFunction<void(const BrakeCommand&)>& callback) {
+            std::get<Callbacks<BrakeCommand>>(m_callbacks).push_back(callback);
+        }
+
+        template<typename Message>
+        [[nodiscard]] size_t waiter_count() const {
+            return std::get<Waiters<Message>>(m_waiters).size();
+        }
+
+    private:
+        template<typename Message>
+        struct Waiter {
+            std::coroutine_handle<> handle;
+            NextAwaiter<Message>* awaiter;
+        };
+
+        template<typename Message>
+        using Waiters = std::vector<Waiter<Message>>;
+
+        template<typename Message>
+        using Callbacks = std::vector<InplaceFunction<void(const Message&)>>;
+
+        Executor& m_executor;
+        std::tuple<Waiters<SpeedUpdate>, Waiters<CarDetected>, Waiters<BrakeCommand>> m_waiters{};
+        std::tuple<Waiters<SpeedUpdate>, Waiters<CarDetected>, Waiters<BrakeCommand>> m_delivering{};
+        std::tuple<Callbacks<SpeedUpdate>, Callbacks<CarDetected>, Callbacks<BrakeCommand>> m_callbacks{};
+
+        template<typename Message>
+        static void release(Waiters<Message>& waiters) {
+            for (const auto& waiter: waiters) {
+                waiter.awaiter->m_waiting = false;
+            }
+            waiters.clear();
+        }
+    };
+
+    // AutoBrake written as a coroutine that waits for the next SpeedUpdate, then checks the next CarDetected
+    // against it, without any callbacks or state shared between them.
+    inline Task auto_brake_controller(CoroutineBus& bus, const double collision_threshold_s = 5.0) {
+        for (;;) {
+            const auto update = co_await bus.next<SpeedUpdate>();
+            const auto detection = co_await bus.next<CarDetected>();
+
+            const auto relative_velocity_mps = update.velocity_mps - detection.velocity_mps;
+            if (relative_velocity_mps <= 0.0) {
+                continue;
+            }
+
+            const auto time_to_collision_s = detection.distance_m / relative_velocity_mps;
+            if (time_to_collision_s > 0.0 && time_to_collision_s <= collision_threshold_s) {
+                bus.publish(BrakeCommand{time_to_collision_s});
+            }
+        }
+    }
+}
+
+#endif //CPPCRASHCOURSE_CH10_COROUTINE_BUS_H
@@ -0,0 +1,71 @@
+#include <functional>
+#include <memory>
+#include <utility>
+
+#include "gtest/gtest.h"
+
+#include "ch10-inplace-function.h"
+
+using IntFunction = ch10::InplaceFunction<int(int)>;
+
+TEST(Ch10InplaceFunction, EmptyFunctionThrowsWhenCalled) {
+    IntFunction function{};
+
+    EXPECT_FALSE(function);
+    EXPECT_THROW(function(1), std::bad_function_call);
+}
+
+TEST(Ch10InplaceFunction, CallsCapturedState) {
+    int offset{10};
+    IntFunction function{[&offset](const int value) {
+        return value + offset;
+    }};
+
+    ASSERT_TRUE(function);
+    EXPECT_EQ(11, function(1));
+    offset = 20;
+    EXPECT_EQ(21, function(1));
+}
+
+TEST(Ch10InplaceFunction, CopiesAreIndependent) {
+    IntFunction counter{[count = 0](const int step) mutable {
+        return count += step;
+    }};
+    auto copy = counter;
+
+    EXPECT_EQ(1, counter(1));
+    EXPECT_EQ(2, counter(1));
+    EXPECT_EQ(5, copy(5));
+}
+
+TEST(Ch10InplaceFunction, MoveEmptiesTheSource) {
+    IntFunction function{[](const int value) {
+        return value * 2;
+    }};
+    auto moved = std::move(function);
+
+    EXPECT_FALSE(function);
+    EXPECT_EQ(4, moved(2));
+
+    function = moved;
+    EXPECT_EQ(6, function(3));
+}
+
+TEST(Ch10InplaceFunction, DestroysNonTrivialCallables) {
+    auto shared = std::make_shared<int>(7);
+    {
+        IntFunction function{[shared](const int value) {
+            return value + *shared;
+        }};
+        auto copy = function;
+        auto moved = std::move(function);
+
+        EXPECT_EQ(3, shared.use_count());
+        EXPECT_EQ(8, moved(1));
+
+        copy = nullptr;
+        EXPECT_EQ(2, shared.use_count());
+    }
+
+    EXPECT_EQ(1, shared.use_count());
+}
@@ -0,0 +1,139 @@
+#ifndef CPPCRASHCOURSE_CH10_INPLACE_FUNCTION_H
+#define CPPCRASHCOURSE_CH10_INPLACE_FUNCTION_H
+
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace ch10 {
+    template<typename Signature, size_t Capacity = 4 * sizeof(void*)>
+    class InplaceFunction;
+
+    // Drop-in for std::function that keeps the callable inside the object: a callable that does not fit in
+    // Capacity bytes is a compile error instead of a heap allocation. Trivially copyable callables, like lambdas
+    // capturing pointers and references, are copied with memcpy and need no destructor call.
+    template<typename R, typename... Args, size_t Capacity>
+    class InplaceFunction<R(Args...), Capacity> {
+    public:
+        InplaceFunction() = default;
+
+        InplaceFunction(std::nullptr_t) {}
+
+        template<typename F>
+        requires (!std::is_same_v<std::remove_cvref_t<F>, InplaceFunction> && std::is_invocable_r_v<R, std::decay_t<F>&, Args...>)
+        InplaceFunction(F&& callable) {
+            using Callable = std::decay_t<F>;
+            static_assert(sizeof(Callable) <= Capacity, "callable does not fit into InplaceFunction");
+            static_assert(alignof(Callable) <= alignof(std::max_align_t), "callable is over-aligned for InplaceFunction");
+            static_assert(std::is_nothrow_move_constructible_v<Callable>, "callable must be nothrow move constructible");
+
+            ::new(static_cast<void*>(m_storage)) Callable(std::forward<F>(callable));
+            m_invoke = [](void* storage, Args... args) -> R {
+                return std::invoke(*static_cast<Callable*>(storage), std::forward<Args>(args)...);
+            };
+
+            if constexpr (!std::is_trivially_copyable_v<Callable> || !std::is_trivially_destructible_v<Callable>) {
+                m_manage = [](const Operation operation, void* target, void* source) {
+                    auto* callable = static_cast<Callable*>(source);
+                    switch (operation) {
+                        case Operation::Copy:
+                            ::new(target) Callable(*callable);
+                            break;
+                        case Operation::Move:
+                            ::new(target) Callable(std::move(*callable));
+                            callable->~Callable();
+                            break;
+                        case Operation::Destroy:
+                            callable->~Callable();
+                            break;
+                    }
+                };
+            }
+        }
+
+        InplaceFunction(const InplaceFunction& other) : m_invoke{other.m_invoke}, m_manage{other.m_manage} {
+            if (m_manage != nullptr) {
+                m_manage(Operation::Copy, m_storage, const_cast<unsigned char*>(other.m_storage));
+            } else {
+                std::memcpy(m_storage, other.m_storage, Capacity);
+            }
+        }
+
+        InplaceFunction(InplaceFunction&& other) noexcept {
+            move_from(other);
+        }
+
+        InplaceFunction& operator=(const InplaceFunction& other) {
+            if (this != &other) {
+                InplaceFunction copy{other};
+                *this = std::move(copy);
+            }
+
+            return *this;
+        }
+
+        InplaceFunction& operator=(InplaceFunction&& other) noexcept {
+            if (this != &other) {
+                reset();
+                move_from(other);
+            }
+
+            return *this;
+        }
+
+        ~InplaceFunction() {
+            reset();
+        }
+
+        explicit operator bool() const {
+            return m_invoke != nullptr;
+        }
+
+        R operator()(Args... args) const {
+            if (m_invoke == nullptr) {
+                throw std::bad_function_call{};
+            }
+
+            return m_invoke(const_cast<unsigned char*>(m_storage), std::forward<Args>(args)...);
+        }
+
+    private:
+        enum class Operation {
+            Copy,
+            Move,
+            Destroy,
+        };
+
+        alignas(std::max_align_t) unsigned char m_storage[Capacity]{};
+        R (* m_invoke)(void*, Args...){};
+        void (* m_manage)(Operation, void*, void*){};
+
+        void move_from(InplaceFunction& other) noexcept {
+            m_invoke = other.m_invoke;
+            m_manage = other.m_manage;
+
+            if (m_manage != nullptr) {
+                m_manage(Operation::Move, m_storage, other.m_storage);
+            } else {
+                std::memcpy(m_storage, other.m_storage, Capacity);
+            }
+
+            other.m_invoke = nullptr;
+            other.m_manage = nullptr;
+        }
+
+        void reset() {
+            if (m_manage != nullptr) {
+                m_manage(Operation::Destroy, nullptr, m_storage);
+            }
+
+            m_invoke = nullptr;
+            m_manage = nullptr;
+        }
+    };
+}
+
+#endif //CPPCRASHCOURSE_CH10_INPLACE_FUNCTION_H
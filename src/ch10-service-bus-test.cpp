@@ -0,0 +1,154 @@
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "ch10.h"
+#include "ch10-service-bus.h"
+
+struct Ch10ServiceBus : public ::testing::Test {
+    ch10::ServiceBus bus{};
+    ch10::AutoBrake auto_brake{bus};
+    std::vector<ch10::BrakeCommand> brake_commands{};
+
+    void SetUp() override {
+        bus.subscribe<ch10::BrakeCommand>([this](const ch10::BrakeCommand& cmd) {
+            brake_commands.push_back(cmd);
+        });
+    }
+};
+
+TEST_F(Ch10ServiceBus, AutoBrakeSubscribesOnce) {
+    EXPECT_EQ(1, bus.subscriber_count<ch10::SpeedUpdate>());
+    EXPECT_EQ(1, bus.subscriber_count<ch10::CarDetected>());
+}
+
+TEST_F(Ch10ServiceBus, SpeedIsSaved) {
+    bus.publish(ch10::SpeedUpdate{100.0});
+    EXPECT_EQ(100.0, auto_brake.get_velocity_mps());
+
+    bus.publish(ch10::SpeedUpdate{50.0});
+    EXPECT_EQ(50.0, auto_brake.get_velocity_mps());
+}
+
+TEST_F(Ch10ServiceBus, AlertWhenImminentCollisionDetected) {
+    bus.publish(ch10::SpeedUpdate{100.0});
+    bus.publish(ch10::CarDetected{100.0, 0.0});
+
+    ASSERT_EQ(1, brake_commands.size());
+    EXPECT_EQ(1.0, brake_commands[0].time_to_collision_s);
+}
+
+TEST_F(Ch10ServiceBus, NoAlertWhenNotImminentCollisionDetected) {
+    bus.publish(ch10::SpeedUpdate{100.0});
+    bus.publish(ch10::CarDetected{1000.0, 50.0});
+
+    EXPECT_TRUE(brake_commands.empty());
+}
+
+TEST_F(Ch10ServiceBus, EverySubscriberReceivesEveryMessage) {
+    std::vector<double> velocities{};
+    for (int i{}; i < 8; i++) {
+        bus.subscribe<ch10::SpeedUpdate>([&velocities](const ch10::SpeedUpdate& update) {
+            velocities.push_back(update.velocity_mps);
+        });
+    }
+
+    bus.publish(ch10::SpeedUpdate{10.0});
+    bus.publish(ch10::SpeedUpdate{20.0});
+
+    EXPECT_EQ(16, velocities.size());
+    EXPECT_EQ(10.0, velocities.front());
+    EXPECT_EQ(20.0, velocities.back());
+    EXPECT_EQ(20.0, auto_brake.get_velocity_mps());
+}
+
+TEST_F(Ch10ServiceBus, SubscribingDuringPublishTakesEffectForTheNextMessage) {
+    int late_calls{};
+    bus.subscribe<ch10::SpeedUpdate>([this, &late_calls](const ch10::SpeedUpdate&) {
+        bus.subscribe<ch10::SpeedUpdate>([&late_calls](const ch10::SpeedUpdate&) {
+            late_calls++;
+        });
+    });
+
+    bus.publish(ch10::SpeedUpdate{10.0});
+    EXPECT_EQ(0, late_calls);
+
+    bus.publish(ch10::SpeedUpdate{10.0});
+    EXPECT_EQ(1, late_calls);
+}
+
+TEST_F(Ch10ServiceBus, CallbackKeepsItsStateWhileSubscribingMany) {
+    std::vector<int> late_calls(1);
+    bus.subscribe<ch10::SpeedUpdate>([this, &late_calls, subscribed = 0](const ch10::SpeedUpdate&) mutable {
+        for (int i{}; i < 16; i++) {
+            bus.subscribe<ch10::SpeedUpdate>([&late_calls](const ch10::SpeedUpdate&) {
+                late_calls[0]++;
+            });
+        }
+
+        // the callback's own state, which would be gone had the table grown under it
+        subscribed += 16;
+        late_calls.push_back(subscribed);
+    });
+
+    bus.publish(ch10::SpeedUpdate{10.0});
+    EXPECT_EQ(0, late_calls[0]);
+    EXPECT_EQ(16, late_calls.back());
+    EXPECT_EQ(18, bus.subscriber_count<ch10::SpeedUpdate>());
+
+    bus.publish(ch10::SpeedUpdate{10.0});
+    EXPECT_EQ(16, late_calls[0]);
+    EXPECT_EQ(32, late_calls.back());
+}
+
+TEST_F(Ch10ServiceBus, SubscribersQueuedByAThrowingCallbackAreStillAdded) {
+    bus.subscribe<ch10::CarDetected>([this](const ch10::CarDetected&) {
+        bus.subscribe<ch10::CarDetected>([](const ch10::CarDetected&) {});
+        throw std::runtime_error{"sensor fault"};
+    });
+
+    EXPECT_THROW(bus.publish(ch10::CarDetected{1000.0, 50.0}), std::runtime_error);
+    EXPECT_EQ(3, bus.subscriber_count<ch10::CarDetected>());
+}
+
+TEST_F(Ch10ServiceBus, BatchAlertsOnceWithClosestCollision) {
+    bus.publish(ch10::SpeedUpdate{100.0});
+    const std::vector<ch10::CarDetected> frame{{300.0, 0.0}, {1000.0, 50.0}, {100.0, 0.0}, {200.0, 0.0}, {50.0, 100.0}};
+    auto_brake.observe_batch(frame);
+
+    ASSERT_EQ(1, brake_commands.size());
+    EXPECT_EQ(1.0, brake_commands[0].time_to_collision_s);
+}
+
+TEST_F(Ch10ServiceBus, BatchMatchesPerDetectionResult) {
+    bus.publish(ch10::SpeedUpdate{30.0});
+
+    std::vector<ch10::CarDetected> frame{};
+    for (int i{}; i < 37; i++) {
+        frame.push_back(ch10::CarDetected{5.0 + i * 7 % 50, static_cast<double>(i * 13 % 60)});
+    }
+
+    for (const auto& detection: frame) {
+        bus.publish(detection);
+    }
+    ASSERT_FALSE(brake_commands.empty());
+    const auto closest = std::min_element(brake_commands.begin(), brake_commands.end(), [](const auto& a, const auto& b) {
+        return a.time_to_collision_s < b.time_to_collision_s;
+    })->time_to_collision_s;
+
+    brake_commands.clear();
+    auto_brake.observe_batch(frame);
+    ASSERT_EQ(1, brake_commands.size());
+    EXPECT_EQ(closest, brake_commands[0].time_to_collision_s);
+}
+
+TEST_F(Ch10ServiceBus, NoBatchAlertWhenNothingImminent) {
+    bus.publish(ch10::SpeedUpdate{100.0});
+    const std::vector<ch10::CarDetected> frame{{1000.0, 50.0}, {100.0, 100.0}, {100.0, 150.0}};
+    auto_brake.observe_batch(frame);
+    auto_brake.observe_batch({});
+
+    EXPECT_TRUE(brake_commands.empty());
+}
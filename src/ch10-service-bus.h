@@ -0,0 +1,94 @@
+#ifndef CPPCRASHCOURSE_CH10_SERVICE_BUS_H
+#define CPPCRASHCOURSE_CH10_SERVICE_BUS_H
+
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include "ch04-trace-span.h"
+#include "ch10.h"
+
+namespace ch10 {
+    // In-process bus with any number of subscribers per message type. Each message type has its own contiguous
+    // table of callbacks picked at compile time, so publishing is a loop over that table and never allocates.
+    class ServiceBus : public IServiceBus {
+    public:
+        void publish(const BrakeCommand& cmd) override {
+            publish<BrakeCommand>(cmd);
+        }
+
+        void subscribe(const InplaceFunction<void(const SpeedUpdate&)>& callback) override {
+            subscribe<SpeedUpdate>(callback);
+        }
+
+        void subscribe(const InplaceFunction<void(const CarDetected&)>& callback) override {
+            subscribe<CarDetected>(callback);
+        }
+
+        template<typename Message>
+        void publish(const Message& message) {
+            CH04_TRACE_SPAN("ServiceBus::publish");
+            Dispatch dispatch{*this};
+
+            for (const auto& subscriber: std::get<Subscribers<Message>>(m_subscribers)) {
+                subscriber(message);
+            }
+        }
+
+        // A callback may subscribe while a message is dispatched; the new subscriber is only added once the
+        // outermost publish() returns, since growing the table would move the callback that is running.
+        template<typename Message>
+        void subscribe(InplaceFunction<void(const Message&)> callback) {
+            auto& subscribers = m_dispatching > 0 ? m_pending : m_subscribers;
+            std::get<Subscribers<Message>>(subscribers).push_back(std::move(callback));
+        }
+
+        template<typename Message>
+        [[nodiscard]] size_t subscriber_count() const {
+            return std::get<Subscribers<Message>>(m_subscribers).size();
+        }
+
+    private:
+        template<typename Message>
+        using Subscribers = std::vector<InplaceFunction<void(const Message&)>>;
+
+        using SubscriberTables = std::tuple<Subscribers<SpeedUpdate>, Subscribers<CarDetected>,
+                Subscribers<BrakeCommand>>;
+
+        SubscriberTables m_subscribers;
+        SubscriberTables m_pending;
+        int m_dispatching{};
+
+        // counts the publish() calls under way, callbacks publishing included, and adds the subscribers queued
+        // meanwhile when the last of them ends, even by an exception
+        struct Dispatch {
+            ServiceBus& bus;
+
+            explicit Dispatch(ServiceBus& bus) : bus{bus} {
+                bus.m_dispatching++;
+            }
+
+            ~Dispatch() {
+                if (--bus.m_dispatching == 0) {
+                    bus.add_pending();
+                }
+            }
+        };
+
+        void add_pending() {
+            std::apply([this](auto& ... pending) {
+                (append(std::get<std::remove_reference_t<decltype(pending)>>(m_subscribers), pending), ...);
+            }, m_pending);
+        }
+
+        template<typename Table>
+        static void append(Table& subscribers, Table& pending) {
+            for (auto& subscriber: pending) {
+                subscribers.push_back(std::move(subscriber));
+            }
+            pending.clear();
+        }
+    };
+}
+
+#endif //CPPCRASHCOURSE_CH10_SERVICE_BUS_H
@@ -0,0 +1,88 @@
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "ch10.h"
+#include "ch10-service-bus.h"
+#include "ch10-trace.h"
+
+struct Ch10Trace : public ::testing::Test {
+    const std::string path{(std::filesystem::temp_directory_path() / "ch10-trace-test.trace").string()};
+
+    void TearDown() override {
+        std::filesystem::remove(path);
+    }
+
+    void record_drive() {
+        ch10::ServiceBus bus{};
+        ch10::TraceRecorder recorder{bus, path};
+        ch10::AutoBrake auto_brake{recorder};
+
+        bus.publish(ch10::SpeedUpdate{100.0});
+        bus.publish(ch10::CarDetected{100.0, 0.0});
+        std::this_thread::sleep_for(std::chrono::milliseconds{20});
+        bus.publish(ch10::SpeedUpdate{10.0});
+        bus.publish(ch10::CarDetected{1000.0, 0.0});
+        bus.publish(ch10::CarDetected{20.0, 5.0});
+    }
+};
+
+TEST_F(Ch10Trace, RecordsMessagesInOrder) {
+    record_drive();
+    ch10::TraceReplayer replayer{path};
+
+    const auto records = replayer.records();
+    ASSERT_EQ(7, records.size());
+    EXPECT_EQ(ch10::TraceMessage::SpeedUpdate, records[0].message);
+    EXPECT_EQ(100.0, records[0].values[0]);
+    EXPECT_EQ(ch10::TraceMessage::CarDetected, records[1].message);
+    EXPECT_EQ(ch10::TraceMessage::BrakeCommand, records[2].message);
+    EXPECT_EQ(1.0, records[2].values[0]);
+    EXPECT_EQ(ch10::TraceMessage::CarDetected, records[5].message);
+    EXPECT_EQ(20.0, records[5].values[0]);
+    EXPECT_EQ(5.0, records[5].values[1]);
+    EXPECT_EQ(ch10::TraceMessage::BrakeCommand, records[6].message);
+    EXPECT_EQ(4.0, records[6].values[0]);
+
+    EXPECT_EQ(0, records[0].timestamp_ns);
+    EXPECT_LE(20'000'000, records[3].timestamp_ns);
+}
+
+TEST_F(Ch10Trace, ReplayThroughAutoBrakeReproducesBrakeCommands) {
+    record_drive();
+    ch10::TraceReplayer replayer{path};
+    ch10::AutoBrake auto_brake{replayer};
+
+    std::vector<ch10::BrakeCommand> brake_commands{};
+    replayer.set_brake_command_callback([&brake_commands](const ch10::BrakeCommand& cmd) {
+        brake_commands.push_back(cmd);
+    });
+
+    const auto result = replayer.replay();
+    EXPECT_EQ(5, result.messages);
+    EXPECT_EQ(2, result.recorded_brake_commands);
+    EXPECT_EQ(2, result.brake_commands);
+    ASSERT_EQ(2, brake_commands.size());
+    EXPECT_EQ(1.0, brake_commands[0].time_to_collision_s);
+    EXPECT_EQ(4.0, brake_commands[1].time_to_collision_s);
+    EXPECT_EQ(10.0, auto_brake.get_velocity_mps());
+}
+
+TEST_F(Ch10Trace, RealTimeReplayKeepsRecordedSpacing) {
+    record_drive();
+    ch10::TraceReplayer replayer{path};
+
+    EXPECT_GT(std::chrono::milliseconds{20}, replayer.replay().elapsed);
+    EXPECT_LE(std::chrono::milliseconds{20}, replayer.replay(ch10::ReplayPacing::RealTime).elapsed);
+}
+
+TEST_F(Ch10Trace, RejectsFileThatIsNotATrace) {
+    std::ofstream{path} << "definitely not a trace file";
+
+    EXPECT_THROW(ch10::TraceReplayer{path}, std::runtime_error);
+}
@@ -0,0 +1,286 @@
+#ifndef CPPCRASHCOURSE_CH10_TRACE_H
+#define CPPCRASHCOURSE_CH10_TRACE_H
+
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "ch10.h"
+
+namespace ch10 {
+    // A trace file is a TraceHeader followed by fixed-size TraceRecords in native byte order, so a mapped file
+    // can be read in place. timestamp_ns counts from the first recorded message.
+    struct TraceHeader {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t record_size;
+    };
+
+    enum class TraceMessage : std::uint32_t {
+        SpeedUpdate,
+        CarDetected,
+        BrakeCommand,
+    };
+
+    struct TraceRecord {
+        std::uint64_t timestamp_ns;
+        TraceMessage message;
+        std::uint32_t reserved;
+        // SpeedUpdate: velocity_mps; CarDetected: distance_m, velocity_mps; BrakeCommand: time_to_collision_s
+        double values[2];
+    };
+
+    inline constexpr char TRACE_MAGIC[8]{'c', 'h', '1', '0', 't', 'r', 'c', 'e'};
+    inline constexpr std::uint32_t TRACE_VERSION{1};
+
+    // Sits between a bus and its subscribers and appends every SpeedUpdate and CarDetected the bus delivers, and
+    // every BrakeCommand published through it, to a trace file.
+    class TraceRecorder : public IServiceBus {
+    public:
+        TraceRecorder(IServiceBus& service_bus, const std::string& path) : m_service_bus{service_bus} {
+            m_fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if (m_fd < 0) {
+                throw std::system_error{errno, std::generic_category(), "open " + path};
+            }
+
+            TraceHeader header{};
+            std::memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+            header.version = TRACE_VERSION;
+            header.record_size = sizeof(TraceRecord);
+            try {
+                write_all(&header, sizeof(header));
+            } catch (...) {
+                ::close(m_fd);
+                throw;
+            }
+
+            m_buffer.reserve(BUFFER_RECORDS);
+
+            // subscribed before anyone else, so a message is recorded before the BrakeCommands it causes
+            m_service_bus.subscribe([this](const SpeedUpdate& update) {
+                record(TraceMessage::SpeedUpdate, update.velocity_mps, 0.0);
+            });
+            m_service_bus.subscribe([this](const CarDetected& detection) {
+                record(TraceMessage::CarDetected, detection.distance_m, detection.velocity_mps);
+            });
+        }
+
+        ~TraceRecorder() override {
+            try {
+                flush();
+            } catch (const std::system_error&) {
+                // the records written so far are still a valid trace
+            }
+
+            ::close(m_fd);
+        }
+
+        TraceRecorder(const TraceRecorder&) = delete;
+
+        TraceRecorder& operator=(const TraceRecorder&) = delete;
+
+        void publish(const BrakeCommand& cmd) override {
+            record(TraceMessage::BrakeCommand, cmd.time_to_collision_s, 0.0);
+            m_service_bus.publish(cmd);
+        }
+
+        void subscribe(const InplaceFunction<void(const SpeedUpdate&)>& callback) override {
+            m_service_bus.subscribe(callback);
+        }
+
+        void subscribe(const InplaceFunction<void(const CarDetected&)>& callback) override {
+            m_service_bus.subscribe(callback);
+        }
+
+        void flush() {
+            if (m_buffer.empty()) {
+                return;
+            }
+
+            write_all(m_buffer.data(), m_buffer.size() * sizeof(TraceRecord));
+            m_buffer.clear();
+        }
+
+    private:
+        static constexpr size_t BUFFER_RECORDS{2048};
+
+        IServiceBus& m_service_bus;
+        int m_fd{-1};
+        std::vector<TraceRecord> m_buffer{};
+        std::chrono::steady_clock::time_point m_start{};
+
+        void record(const TraceMessage message, const double first, const double second) {
+            const auto now = std::chrono::steady_clock::now();
+            if (m_start == std::chrono::steady_clock::time_point{}) {
+                m_start = now;
+            }
+
+            const auto timestamp_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(now - m_start).count();
+            m_buffer.push_back(TraceRecord{static_cast<std::uint64_t>(timestamp_ns), message, 0, {first, second}});
+            if (m_buffer.size() == BUFFER_RECORDS) {
+                flush();
+            }
+        }
+
+        void write_all(const void* data, size_t size) {
+            const auto* bytes = static_cast<const char*>(data);
+            while (size > 0) {
+                const auto written = ::write(m_fd, bytes, size);
+                if (written < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    throw std::system_error{errno, std::generic_category(), "write"};
+                }
+
+                bytes += written;
+                size -= static_cast<size_t>(written);
+            }
+        }
+    };
+
+    enum class ReplayPacing {
+        AsFastAsPossible,
+        RealTime,
+    };
+
+    struct ReplayResult {
+        size_t messages;
+        size_t brake_commands;
+        size_t recorded_brake_commands;
+        std::chrono::nanoseconds elapsed;
+    };
+
+    // Maps a trace read-only and plays its SpeedUpdates and CarDetecteds to whatever subscribed, e.g. an AutoBrake
+    // constructed on top of the replayer. Recorded BrakeCommands are only counted, so a replay can be checked
+    // against the run that was recorded.
+    class TraceReplayer : public IServiceBus {
+    public:
+        explicit TraceReplayer(const std::string& path) {
+            const auto fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0) {
+                throw std::system_error{errno, std::generic_category(), "open " + path};
+            }
+
+            struct stat status{};
+            if (::fstat(fd, &status) != 0) {
+                const auto error = errno;
+                ::close(fd);
+                throw std::system_error{error, std::generic_category(), "fstat " + path};
+            }
+
+            m_size = static_cast<size_t>(status.st_size);
+            if (m_size < sizeof(TraceHeader)) {
+                ::close(fd);
+                throw std::runtime_error{"not a trace file"};
+            }
+
+            auto* mapping = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            const auto error = errno;
+            ::close(fd);
+            if (mapping == MAP_FAILED) {
+                throw std::system_error{error, std::generic_category(), "mmap " + path};
+            }
+            m_mapping = static_cast<const char*>(mapping);
+            ::madvise(mapping, m_size, MADV_SEQUENTIAL);
+
+            TraceHeader header{};
+            std::memcpy(&header, m_mapping, sizeof(header));
+            if (std::memcmp(header.magic, TRACE_MAGIC, sizeof(header.magic)) != 0 ||
+                header.version != TRACE_VERSION || header.record_size != sizeof(TraceRecord)) {
+                ::munmap(mapping, m_size);
+                throw std::runtime_error{"not a trace file"};
+            }
+        }
+
+        ~TraceReplayer() override {
+            ::munmap(const_cast<char*>(m_mapping), m_size);
+        }
+
+        TraceReplayer(const TraceReplayer&) = delete;
+
+        TraceReplayer& operator=(const TraceReplayer&) = delete;
+
+        void publish(const BrakeCommand& cmd) override {
+            m_brake_commands++;
+            if (m_brake_command_callback) {
+                m_brake_command_callback(cmd);
+            }
+        }
+
+        void subscribe(const InplaceFunction<void(const SpeedUpdate&)>& callback) override {
+            m_speed_update_callbacks.push_back(callback);
+        }
+
+        void subscribe(const InplaceFunction<void(const CarDetected&)>& callback) override {
+            m_car_detected_callbacks.push_back(callback);
+        }
+
+        void set_brake_command_callback(const InplaceFunction<void(const BrakeCommand&)>& callback) {
+            m_brake_command_callback = callback;
+        }
+
+        // A trailing partial record, e.g. from a recorder that was killed mid-write, is ignored.
+        [[nodiscard]] std::span<const TraceRecord> records() const {
+            const auto count = (m_size - sizeof(TraceHeader)) / sizeof(TraceRecord);
+            return {reinterpret_cast<const TraceRecord*>(m_mapping + sizeof(TraceHeader)), count};
+        }
+
+        ReplayResult replay(const ReplayPacing pacing = ReplayPacing::AsFastAsPossible) {
+            m_brake_commands = 0;
+            ReplayResult result{};
+
+            const auto start = std::chrono::steady_clock::now();
+            for (const auto& record: records()) {
+                if (pacing == ReplayPacing::RealTime) {
+                    std::this_thread::sleep_until(start + std::chrono::nanoseconds{record.timestamp_ns});
+                }
+
+                switch (record.message) {
+                    case TraceMessage::SpeedUpdate:
+                        for (const auto& callback: m_speed_update_callbacks) {
+                            callback(SpeedUpdate{record.values[0]});
+                        }
+                        result.messages++;
+                        break;
+                    case TraceMessage::CarDetected:
+                        for (const auto& callback: m_car_detected_callbacks) {
+                            callback(CarDetected{record.values[0], record.values[1]});
+                        }
+                        result.messages++;
+                        break;
+                    case TraceMessage::BrakeCommand:
+                        result.recorded_brake_commands++;
+                        break;
+                }
+            }
+
+            result.elapsed = std::chrono::steady_clock::now() - start;
+            result.brake_commands = m_brake_commands;
+
+            return result;
+        }
+
+    private:
+        const char* m_mapping{};
+        size_t m_size{};
+        std::vector<InplaceFunction<void(const SpeedUpdate&)>> m_speed_update_callbacks{};
+        std::vector<InplaceFunction<void(const CarDetected&)>> m_car_detected_callbacks{};
+        InplaceFunction<void(const BrakeCommand&)> m_brake_command_callback{};
+        size_t m_brake_commands{};
+    };
+}
+
+#endif //CPPCRASHCOURSE_CH10_TRACE_H
@@ -0,0 +1,101 @@
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "ch10.h"
+#include "ch10-service-bus.h"
+#include "ch10-tracking-auto-brake.h"
+
+struct Ch10TrackingAutoBrake : public ::testing::Test {
+    ch10::ServiceBus bus{};
+    ch10::TrackingAutoBrake auto_brake{bus, 0.5, 2};
+    std::vector<ch10::BrakeCommand> brake_commands{};
+
+    void SetUp() override {
+        bus.subscribe<ch10::BrakeCommand>([this](const ch10::BrakeCommand& cmd) {
+            brake_commands.push_back(cmd);
+        });
+    }
+
+    void observe(const std::vector<ch10::TrackedCarDetected>& frame) {
+        auto_brake.observe_frame(frame);
+    }
+};
+
+TEST_F(Ch10TrackingAutoBrake, SmoothingOutOfRangeThrows) {
+    EXPECT_THROW((ch10::TrackingAutoBrake{bus, 0.0}), std::invalid_argument);
+    EXPECT_THROW((ch10::TrackingAutoBrake{bus, 1.5}), std::invalid_argument);
+}
+
+TEST_F(Ch10TrackingAutoBrake, SmoothsTrackState) {
+    observe({{7, 100.0, 10.0}});
+    observe({{7, 80.0, 20.0}});
+
+    const auto track = auto_brake.get_track(7);
+    ASSERT_TRUE(track.has_value());
+    EXPECT_EQ(90.0, track->distance_m);
+    EXPECT_EQ(15.0, track->velocity_mps);
+    EXPECT_FALSE(auto_brake.get_track(8).has_value());
+}
+
+TEST_F(Ch10TrackingAutoBrake, AlertsOnceWhileTheSameCarStaysClose) {
+    bus.publish(ch10::SpeedUpdate{100.0});
+    observe({{1, 100.0, 0.0}});
+    observe({{1, 100.0, 0.0}});
+    observe({{1, 100.0, 0.0}});
+
+    ASSERT_EQ(1, brake_commands.size());
+    EXPECT_EQ(1.0, brake_commands[0].time_to_collision_s);
+}
+
+TEST_F(Ch10TrackingAutoBrake, OneAlertPerFrameWithClosestNewCollision) {
+    bus.publish(ch10::SpeedUpdate{100.0});
+    observe({{1, 300.0, 0.0}, {2, 100.0, 0.0}, {3, 1000.0, 0.0}});
+
+    ASSERT_EQ(1, brake_commands.size());
+    EXPECT_EQ(1.0, brake_commands[0].time_to_collision_s);
+}
+
+TEST_F(Ch10TrackingAutoBrake, OnlyChangedTracksAreEvaluated) {
+    observe({{1, 100.0, 0.0}, {2, 200.0, 0.0}, {3, 300.0, 0.0}});
+    EXPECT_EQ(3, auto_brake.get_evaluations());
+
+    observe({{1, 100.0, 0.0}, {2, 100.0, 0.0}, {3, 300.0, 0.0}});
+    EXPECT_EQ(4, auto_brake.get_evaluations());
+}
+
+TEST_F(Ch10TrackingAutoBrake, SpeedUpdateReevaluatesEveryTrack) {
+    observe({{1, 100.0, 0.0}, {2, 1000.0, 0.0}});
+    EXPECT_TRUE(brake_commands.empty());
+
+    bus.publish(ch10::SpeedUpdate{100.0});
+    observe({});
+
+    ASSERT_EQ(1, brake_commands.size());
+    EXPECT_EQ(1.0, brake_commands[0].time_to_collision_s);
+    EXPECT_EQ(10.0, auto_brake.get_track(2)->time_to_collision_s);
+}
+
+TEST_F(Ch10TrackingAutoBrake, EvictsStaleTracks) {
+    observe({{1, 100.0, 0.0}, {2, 100.0, 0.0}});
+    for (int i{}; i < 4; i++) {
+        observe({{2, 100.0, 0.0}});
+    }
+
+    EXPECT_EQ(1, auto_brake.get_track_count());
+    EXPECT_FALSE(auto_brake.get_track(1).has_value());
+    EXPECT_TRUE(auto_brake.get_track(2).has_value());
+}
+
+TEST_F(Ch10TrackingAutoBrake, KeepsManyTracks) {
+    std::vector<ch10::TrackedCarDetected> frame{};
+    for (unsigned i{}; i < 10000; i++) {
+        frame.push_back(ch10::TrackedCarDetected{i * 7919, 10.0 + i, 0.0});
+    }
+    observe(frame);
+
+    EXPECT_EQ(10000, auto_brake.get_track_count());
+    for (unsigned i{}; i < 10000; i++) {
+        ASSERT_EQ(10.0 + i, auto_brake.get_track(i * 7919)->distance_m);
+    }
+}
@@ -0,0 +1,242 @@
+#ifndef CPPCRASHCOURSE_CH10_TRACKING_AUTO_BRAKE_H
+#define CPPCRASHCOURSE_CH10_TRACKING_AUTO_BRAKE_H
+
+#include <algorithm>
+#include <limits>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include "ch10.h"
+
+namespace ch10 {
+    struct TrackedCarDetected {
+        unsigned track_id;
+        double distance_m;
+        double velocity_mps;
+    };
+
+    struct TrackState {
+        double distance_m;
+        double velocity_mps;
+        double time_to_collision_s;
+    };
+
+    // AutoBrake for a radar that reports the same vehicles frame after frame. Tracks live in one open-addressing
+    // table, keep exponentially smoothed distance and velocity, and are evicted after max_missed_frames frames
+    // without a detection. Time-to-collision is only recomputed for tracks whose smoothed state changed (or for
+    // all of them after a speed or threshold change), and a BrakeCommand is only published when a track enters
+    // the collision threshold, once per frame with the smallest time-to-collision.
+    class TrackingAutoBrake {
+    public:
+        explicit TrackingAutoBrake(IServiceBus& service_bus, const double smoothing = 0.5, const unsigned max_missed_frames = 5)
+                : m_service_bus{service_bus}, m_smoothing{smoothing}, m_max_missed_frames{max_missed_frames} {
+            if (smoothing <= 0.0 || smoothing > 1.0) {
+                throw std::invalid_argument{"smoothing not in (0.0, 1.0]"};
+            }
+
+            m_service_bus.subscribe([this](const SpeedUpdate& update) {
+                this->observe(update);
+            });
+
+            m_slots.resize(MIN_CAPACITY);
+        }
+
+        void set_collision_threshold_s(const double collision_threshold_s) {
+            if (collision_threshold_s < 1.0) {
+                throw std::invalid_argument{"collision_threshold_s less than 1.0"};
+            }
+
+            m_collision_threshold_s = collision_threshold_s;
+            m_reevaluate_all = true;
+        }
+
+        [[nodiscard]] double get_collision_threshold_s() const {
+            return m_collision_threshold_s;
+        }
+
+        [[nodiscard]] double get_velocity_mps() const {
+            return m_velocity_mps;
+        }
+
+        [[nodiscard]] size_t get_track_count() const {
+            return m_size;
+        }
+
+        // how many time-to-collision computations have been done so far
+        [[nodiscard]] unsigned long long get_evaluations() const {
+            return m_evaluations;
+        }
+
+        [[nodiscard]] std::optional<TrackState> get_track(const unsigned track_id) const {
+            const auto* slot = find(track_id);
+            if (slot == nullptr) {
+                return std::nullopt;
+            }
+
+            return TrackState{slot->distance_m, slot->velocity_mps, slot->time_to_collision_s};
+        }
+
+        void observe_frame(const std::span<const TrackedCarDetected> frame) {
+            m_frame++;
+
+            auto closest = NO_COLLISION;
+            for (const auto& detection: frame) {
+                auto& slot = find_or_insert(detection.track_id);
+
+                const auto distance_m = slot.last_seen_frame == 0 ? detection.distance_m
+                        : slot.distance_m + m_smoothing * (detection.distance_m - slot.distance_m);
+                const auto velocity_mps = slot.last_seen_frame == 0 ? detection.velocity_mps
+                        : slot.velocity_mps + m_smoothing * (detection.velocity_mps - slot.velocity_mps);
+                const auto changed = slot.last_seen_frame == 0 || distance_m != slot.distance_m || velocity_mps != slot.velocity_mps;
+
+                slot.distance_m = distance_m;
+                slot.velocity_mps = velocity_mps;
+                slot.last_seen_frame = m_frame;
+
+                if (changed && !m_reevaluate_all) {
+                    closest = std::min(closest, evaluate(slot));
+                }
+            }
+
+            if (m_reevaluate_all || m_frame - m_last_sweep_frame >= m_max_missed_frames) {
+                closest = std::min(closest, sweep());
+            }
+
+            if (closest != NO_COLLISION) {
+                m_service_bus.publish(BrakeCommand{closest});
+            }
+        }
+
+    private:
+        struct Slot {
+            unsigned track_id;
+            // 0 marks an empty slot; frames are numbered from 1
+            unsigned last_seen_frame;
+            double distance_m;
+            double velocity_mps;
+            double time_to_collision_s;
+            bool braking;
+        };
+
+        static constexpr size_t MIN_CAPACITY{16};
+        static constexpr double NO_COLLISION{std::numeric_limits<double>::infinity()};
+
+        IServiceBus& m_service_bus;
+        double m_smoothing;
+        unsigned m_max_missed_frames;
+        double m_velocity_mps{};
+        double m_collision_threshold_s{5.0};
+        std::vector<Slot> m_slots{};
+        size_t m_size{};
+        unsigned m_frame{};
+        unsigned m_last_sweep_frame{};
+        bool m_reevaluate_all{};
+        unsigned long long m_evaluations{};
+
+        void observe(const SpeedUpdate& update) {
+            m_velocity_mps = update.velocity_mps;
+            m_reevaluate_all = true;
+        }
+
+        // returns the time-to-collision if the track just started needing a brake, NO_COLLISION otherwise
+        double evaluate(Slot& slot) {
+            m_evaluations++;
+
+            const auto relative_velocity_mps = m_velocity_mps - slot.velocity_mps;
+            slot.time_to_collision_s = relative_velocity_mps > 0.0 ? slot.distance_m / relative_velocity_mps : NO_COLLISION;
+
+            const auto was_braking = slot.braking;
+            slot.braking = slot.time_to_collision_s > 0.0 && slot.time_to_collision_s <= m_collision_threshold_s;
+
+            return slot.braking && !was_braking ? slot.time_to_collision_s : NO_COLLISION;
+        }
+
+        // One pass over the table: drops stale tracks (rebuilding it if any were dropped, so probe chains stay
+        // intact) and re-evaluates every track when the speed or threshold changed since the last frame.
+        double sweep() {
+            m_last_sweep_frame = m_frame;
+
+            auto closest = NO_COLLISION;
+            auto evicted = false;
+            for (auto& slot: m_slots) {
+                if (slot.last_seen_frame == 0) {
+                    continue;
+                }
+
+                if (m_frame - slot.last_seen_frame > m_max_missed_frames) {
+                    slot.last_seen_frame = 0;
+                    m_size--;
+                    evicted = true;
+                } else if (m_reevaluate_all) {
+                    closest = std::min(closest, evaluate(slot));
+                }
+            }
+
+            m_reevaluate_all = false;
+            if (evicted) {
+                rehash(m_slots.size());
+            }
+
+            return closest;
+        }
+
+        static size_t hash(const unsigned track_id) {
+            return static_cast<size_t>((track_id * 0x9E3779B97F4A7C15ull) >> 32);
+        }
+
+        [[nodiscard]] const Slot* find(const unsigned track_id) const {
+            const auto mask = m_slots.size() - 1;
+            for (auto i = hash(track_id) & mask;; i = (i + 1) & mask) {
+                const auto& slot = m_slots[i];
+                if (slot.last_seen_frame == 0) {
+                    return nullptr;
+                }
+                if (slot.track_id == track_id) {
+                    return &slot;
+                }
+            }
+        }
+
+        Slot& find_or_insert(const unsigned track_id) {
+            // keeps the load factor at most 1/2, so linear probe chains stay short
+            if ((m_size + 1) * 2 > m_slots.size()) {
+                rehash(m_slots.size() * 2);
+            }
+
+            const auto mask = m_slots.size() - 1;
+            for (auto i = hash(track_id) & mask;; i = (i + 1) & mask) {
+                auto& slot = m_slots[i];
+                if (slot.last_seen_frame == 0) {
+                    slot = Slot{track_id, 0, 0.0, 0.0, NO_COLLISION, false};
+                    m_size++;
+                    return slot;
+                }
+                if (slot.track_id == track_id) {
+                    return slot;
+                }
+            }
+        }
+
+        void rehash(const size_t capacity) {
+            auto slots = std::move(m_slots);
+            m_slots.assign(capacity, Slot{});
+
+            const auto mask = capacity - 1;
+            for (const auto& slot: slots) {
+                if (slot.last_seen_frame == 0) {
+                    continue;
+                }
+
+                auto i = hash(slot.track_id) & mask;
+                while (m_slots[i].last_seen_frame != 0) {
+                    i = (i + 1) & mask;
+                }
+                m_slots[i] = slot;
+            }
+        }
+    };
+}
+
+#endif //CPPCRASHCOURSE_CH10_TRACKING_AUTO_BRAKE_H
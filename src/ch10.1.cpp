@@ -1,8 +1,9 @@
 #include <ostream>
-#include <functional>
 
 #include "catch.hpp"
 
+#include "ch10-inplace-function.h"
+
 namespace ch10_1 {
     struct SpeedUpdate {
         double velocity_mps;
@@ -24,9 +25,9 @@ namespace ch10_1 {
 
         virtual void publish(const BrakeCommand& cmd) = 0;
 
-        virtual void subscribe(const std::function<void(const SpeedUpdate&)>& callback) = 0;
+        virtual void subscribe(const ch10::InplaceFunction<void(const SpeedUpdate&)>& callback) = 0;
 
-        virtual void subscribe(const std::function<void(const CarDetected&)>& callback) = 0;
+        virtual void subscribe(const ch10::InplaceFunction<void(const CarDetected&)>& callback) = 0;
     };
 
     class ServiceBusMock : public IServiceBus {
@@ -36,19 +37,19 @@ namespace ch10_1 {
             last_command = cmd;
         }
 
-        void subscribe(const std::function<void(const SpeedUpdate&)>& callback) override {
+        void subscribe(const ch10::InplaceFunction<void(const SpeedUpdate&)>& callback) override {
             speed_update_callback = callback;
         }
 
-        void subscribe(const std::function<void(const CarDetected&)>& callback) override {
+        void subscribe(const ch10::InplaceFunction<void(const CarDetected&)>& callback) override {
             car_detected_callback = callback;
         }
 
     public:
         int commands_published{};
         BrakeCommand last_command{};
-        std::function<void(const ch10_1::SpeedUpdate &)> speed_update_callback{};
-        std::function<void(const ch10_1::CarDetected &)> car_detected_callback{};
+        ch10::InplaceFunction<void(const ch10_1::SpeedUpdate &)> speed_update_callback{};
+        ch10::InplaceFunction<void(const ch10_1::CarDetected &)> car_detected_callback{};
     };
 
     class AutoBrake {
@@ -1,9 +1,10 @@
 #include <ostream>
-#include <functional>
 
 #include "gtest/gtest.h"
 #include "gmock/gmock.h"
 
+#include "ch10-inplace-function.h"
+
 namespace ch10_4 {
     struct SpeedUpdate {
         double velocity_mps;
@@ -25,9 +26,9 @@ namespace ch10_4 {
 
         virtual void publish(const BrakeCommand& cmd) = 0;
 
-        virtual void subscribe(const std::function<void(const SpeedUpdate&)>& callback) = 0;
+        virtual void subscribe(const ch10::InplaceFunction<void(const SpeedUpdate&)>& callback) = 0;
 
-        virtual void subscribe(const std::function<void(const CarDetected&)>& callback) = 0;
+        virtual void subscribe(const ch10::InplaceFunction<void(const CarDetected&)>& callback) = 0;
     };
 
     class AutoBrake {
@@ -84,8 +85,8 @@ namespace ch10_4 {
 
 class ServiceBusMock : public ch10_4::IServiceBus {
     MOCK_METHOD1(publish, void(const ch10_4::BrakeCommand& cmd));
-    MOCK_METHOD1(subscribe, void(const std::function<void(const ch10_4::SpeedUpdate&)>& callback));
-    MOCK_METHOD1(subscribe, void(const std::function<void(const ch10_4::CarDetected&)>& callback));
+    MOCK_METHOD1(subscribe, void(const ch10::InplaceFunction<void(const ch10_4::SpeedUpdate&)>& callback));
+    MOCK_METHOD1(subscribe, void(const ch10::InplaceFunction<void(const ch10_4::CarDetected&)>& callback));
 };
 
 struct Ch10_4Nice : public ::testing::Test {
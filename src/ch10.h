@@ -0,0 +1,146 @@
+#ifndef CPPCRASHCOURSE_CH10_H
+#define CPPCRASHCOURSE_CH10_H
+
+#include <algorithm>
+#include <limits>
+#include <span>
+#include <stdexcept>
+
+#if defined(__SSE2__)
+
+#include <emmintrin.h>
+
+#endif
+
+#include "ch10-inplace-function.h"
+
+namespace ch10 {
+    struct SpeedUpdate {
+        double velocity_mps;
+    };
+
+    struct CarDetected {
+        double distance_m;
+        double velocity_mps;
+    };
+
+    struct BrakeCommand {
+        double time_to_collision_s;
+    };
+
+    class IServiceBus {
+    public:
+        IServiceBus() = default;
+        virtual ~IServiceBus() = default;
+
+        virtual void publish(const BrakeCommand& cmd) = 0;
+
+        virtual void subscribe(const InplaceFunction<void(const SpeedUpdate&)>& callback) = 0;
+
+        virtual void subscribe(const InplaceFunction<void(const CarDetected&)>& callback) = 0;
+    };
+
+    class AutoBrake {
+    public:
+        explicit AutoBrake(IServiceBus& service_bus) : m_service_bus{service_bus}, m_velocity_mps{0.0}, m_collision_threshold_s{5.0} {
+            m_service_bus.subscribe([this](const SpeedUpdate& update) {
+                this->observe(update);
+            });
+
+            m_service_bus.subscribe([this](const CarDetected& update) {
+                this->observe(update);
+            });
+        }
+
+        void set_collision_threshold_s(const double collision_threshold_s) {
+            if (collision_threshold_s < 1.0) {
+                throw std::invalid_argument{"collision_threshold_s less than 1.0"};
+            }
+
+            m_collision_threshold_s = collision_threshold_s;
+        }
+
+        [[nodiscard]] double get_collision_threshold_s() const {
+            return m_collision_threshold_s;
+        }
+
+        [[nodiscard]] double get_velocity_mps() const {
+            return m_velocity_mps;
+        }
+
+        // Handles a whole radar frame at once and publishes at most one BrakeCommand, for the closest collision.
+        void observe_batch(const std::span<const CarDetected> frame) {
+            const auto time_to_collision_s = min_time_to_collision_s(frame);
+            if (time_to_collision_s <= m_collision_threshold_s) {
+                m_service_bus.publish(BrakeCommand{time_to_collision_s});
+            }
+        }
+
+    private:
+        void observe(const SpeedUpdate& update) {
+            m_velocity_mps = update.velocity_mps;
+        }
+
+        void observe(const CarDetected& update) {
+            const auto relative_velocity_mps = m_velocity_mps - update.velocity_mps;
+            if (relative_velocity_mps <= 0.0) {
+                return;
+            }
+
+            const auto time_to_collision_s = update.distance_m / relative_velocity_mps;
+            if (time_to_collision_s > 0.0 && time_to_collision_s <= m_collision_threshold_s) {
+                m_service_bus.publish(BrakeCommand{time_to_collision_s});
+            }
+        }
+
+        // Same test as observe(const CarDetected&), but every detection is divided and compared, and the ones that
+        // would not brake are masked to infinity instead of branched over.
+        [[nodiscard]] double min_time_to_collision_s(const std::span<const CarDetected> frame) const {
+            constexpr auto none = std::numeric_limits<double>::infinity();
+            auto best = none;
+            size_t i{};
+
+#if defined(__SSE2__)
+            const auto velocity = _mm_set1_pd(m_velocity_mps);
+            const auto threshold = _mm_set1_pd(m_collision_threshold_s);
+            const auto zero = _mm_setzero_pd();
+            const auto infinity = _mm_set1_pd(none);
+            auto best2 = infinity;
+
+            for (; i + 2 <= frame.size(); i += 2) {
+                // each detection is one (distance, velocity) register; regroup two of them into columns
+                const auto first = _mm_loadu_pd(&frame[i].distance_m);
+                const auto second = _mm_loadu_pd(&frame[i + 1].distance_m);
+                const auto distance = _mm_unpacklo_pd(first, second);
+                const auto relative_velocity = _mm_sub_pd(velocity, _mm_unpackhi_pd(first, second));
+                const auto time_to_collision = _mm_div_pd(distance, relative_velocity);
+
+                const auto hit = _mm_and_pd(_mm_cmpgt_pd(relative_velocity, zero),
+                                            _mm_and_pd(_mm_cmpgt_pd(time_to_collision, zero),
+                                                       _mm_cmple_pd(time_to_collision, threshold)));
+                const auto candidate = _mm_or_pd(_mm_and_pd(hit, time_to_collision), _mm_andnot_pd(hit, infinity));
+                best2 = _mm_min_pd(best2, candidate);
+            }
+
+            best = std::min(_mm_cvtsd_f64(best2), _mm_cvtsd_f64(_mm_unpackhi_pd(best2, best2)));
+#endif
+
+            for (; i < frame.size(); i++) {
+                const auto relative_velocity_mps = m_velocity_mps - frame[i].velocity_mps;
+                const auto time_to_collision_s = frame[i].distance_m / relative_velocity_mps;
+                const auto hit = (relative_velocity_mps > 0.0) & (time_to_collision_s > 0.0) &
+                                 (time_to_collision_s <= m_collision_threshold_s);
+                best = std::min(best, hit ? time_to_collision_s : none);
+            }
+
+            return best;
+        }
+
+    private:
+        IServiceBus& m_service_bus;
+        double m_velocity_mps;
+        double m_collision_threshold_s;
+    };
+}
+
+#endif //CPPCRASHCOURSE_CH10_H
@@ -0,0 +1,362 @@
+#include <algorithm>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "ch11-local-shared-ptr.h"
+#include "ch11-monotonic-arena.h"
+#include "ch11-object-pool.h"
+
+namespace {
+    // DeadMenOfDunharrow without its static oath count, which threads allocating and freeing on each other's
+    // behalf would race on
+    struct Oath {
+        Oath(const char* m = "") : message{m} {}
+
+        const char* message;
+        long long payload[4]{};
+    };
+
+    struct CountedOath : ch11::RefCounted, Oath {
+        using Oath::Oath;
+    };
+
+    void BM_NewDelete(benchmark::State& state) {
+        for (auto _: state) {
+            auto* oath = new Oath{"raw"};
+            benchmark::DoNotOptimize(oath);
+            delete oath;
+        }
+    }
+
+    void BM_MakeUnique(benchmark::State& state) {
+        for (auto _: state) {
+            auto oath = std::make_unique<Oath>("unique");
+            benchmark::DoNotOptimize(oath.get());
+        }
+    }
+
+    // two allocations: the object, then the control block
+    void BM_SharedPtrFromNew(benchmark::State& state) {
+        for (auto _: state) {
+            std::shared_ptr<Oath> oath{new Oath{"shared"}};
+            benchmark::DoNotOptimize(oath.get());
+        }
+    }
+
+    void BM_MakeShared(benchmark::State& state) {
+        for (auto _: state) {
+            auto oath = std::make_shared<Oath>("shared");
+            benchmark::DoNotOptimize(oath.get());
+        }
+    }
+
+    // every copy and destruction is an atomic reference count update
+    void BM_SharedPtrCopy(benchmark::State& state) {
+        const auto oath = std::make_shared<Oath>("shared");
+
+        for (auto _: state) {
+            auto copy = oath;
+            benchmark::DoNotOptimize(copy.get());
+        }
+    }
+
+    void BM_UniquePtrMove(benchmark::State& state) {
+        auto oath = std::make_unique<Oath>("unique");
+
+        for (auto _: state) {
+            auto moved = std::move(oath);
+            benchmark::DoNotOptimize(moved.get());
+            oath = std::move(moved);
+        }
+    }
+
+    // walking objects owned through pointers compared with the same objects stored by value
+    void BM_SumVectorOfUniquePtr(benchmark::State& state) {
+        std::vector<std::unique_ptr<Oath>> oaths{};
+        for (long i{}; i < state.range(0); i++) {
+            oaths.push_back(std::make_unique<Oath>());
+            oaths.back()->payload[0] = i;
+        }
+
+        for (auto _: state) {
+            long long sum{};
+            for (const auto& oath: oaths) {
+                sum += oath->payload[0];
+            }
+            benchmark::DoNotOptimize(sum);
+        }
+
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+
+    void BM_SumVectorOfValues(benchmark::State& state) {
+        std::vector<Oath> oaths(static_cast<size_t>(state.range(0)));
+        for (long i{}; i < state.range(0); i++) {
+            oaths[static_cast<size_t>(i)].payload[0] = i;
+        }
+
+        for (auto _: state) {
+            long long sum{};
+            for (const auto& oath: oaths) {
+                sum += oath.payload[0];
+            }
+            benchmark::DoNotOptimize(sum);
+        }
+
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+
+    std::unique_ptr<Oath> make_unique_oath() {
+        return std::make_unique<Oath>("unique");
+    }
+
+    ch11::PooledPtr<Oath> make_pooled_oath() {
+        return ch11::make_pooled<Oath>("pooled");
+    }
+
+    // allocates a batch of objects and frees it on the same thread
+    template<auto Make>
+    void BM_AllocateFree(benchmark::State& state) {
+        const auto count = static_cast<size_t>(state.range(0));
+        std::vector<decltype(Make())> oaths{};
+        oaths.reserve(count);
+
+        for (auto _: state) {
+            for (size_t i{}; i < count; i++) {
+                oaths.push_back(Make());
+            }
+            benchmark::DoNotOptimize(oaths.data());
+            oaths.clear();
+        }
+
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+
+    // Frees the batches it is handed on its own thread, like a consumer at the end of a pipeline.
+    template<typename Pointer>
+    class Reaper {
+    public:
+        Reaper() : m_thread{[this] { run(); }} {}
+
+        ~Reaper() {
+            {
+                std::lock_guard lock{m_mutex};
+                m_stopping = true;
+            }
+            m_condition.notify_all();
+            m_thread.join();
+        }
+
+        // waits until the previous batch has been taken, then leaves an empty vector in place of this one
+        void hand_over(std::vector<Pointer>& batch) {
+            std::unique_lock lock{m_mutex};
+            m_condition.wait(lock, [this] { return m_batch.empty(); });
+            std::swap(m_batch, batch);
+            m_condition.notify_all();
+        }
+
+    private:
+        std::mutex m_mutex{};
+        std::condition_variable m_condition{};
+        std::vector<Pointer> m_batch{};
+        bool m_stopping{};
+        std::thread m_thread;
+
+        void run() {
+            std::vector<Pointer> batch{};
+            std::unique_lock lock{m_mutex};
+
+            while (true) {
+                m_condition.wait(lock, [this] { return m_stopping || !m_batch.empty(); });
+                if (m_batch.empty()) {
+                    return;
+                }
+
+                std::swap(m_batch, batch);
+                m_condition.notify_all();
+
+                lock.unlock();
+                batch.clear();
+                lock.lock();
+            }
+        }
+    };
+
+    // allocates on the benchmark thread and frees on another one
+    template<auto Make>
+    void BM_AllocateCrossThreadFree(benchmark::State& state) {
+        const auto count = static_cast<size_t>(state.range(0));
+        std::vector<decltype(Make())> oaths{};
+        Reaper<decltype(Make())> reaper{};
+
+        for (auto _: state) {
+            for (size_t i{}; i < count; i++) {
+                oaths.push_back(Make());
+            }
+            reaper.hand_over(oaths);
+        }
+
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+
+    // everything one request creates, released together at its end
+    void BM_RequestMakeUnique(benchmark::State& state) {
+        std::vector<std::unique_ptr<Oath>> oaths{};
+        oaths.reserve(static_cast<size_t>(state.range(0)));
+
+        for (auto _: state) {
+            for (long i{}; i < state.range(0); i++) {
+                oaths.push_back(std::make_unique<Oath>("request"));
+            }
+            benchmark::DoNotOptimize(oaths.data());
+            oaths.clear();
+        }
+
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+
+    void BM_RequestArena(benchmark::State& state) {
+        ch11::MonotonicArena arena{};
+
+        for (auto _: state) {
+            for (long i{}; i < state.range(0); i++) {
+                benchmark::DoNotOptimize(arena.make<Oath>("request"));
+            }
+            arena.reset();
+        }
+
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+
+    std::shared_ptr<Oath> shared_oath_from_new() {
+        return std::shared_ptr<Oath>{new Oath{"shared"}};
+    }
+
+    std::shared_ptr<Oath> make_shared_oath() {
+        return std::make_shared<Oath>("shared");
+    }
+
+    ch11::LocalSharedPtr<Oath> make_local_shared_oath() {
+        return ch11::make_local_shared<Oath>("local");
+    }
+
+    ch11::IntrusivePtr<CountedOath> make_intrusive_oath() {
+        return ch11::make_intrusive<CountedOath>("intrusive");
+    }
+
+    // The shared pointer benchmarks below run with google benchmark's hardware counters where it was built
+    // with libpfm, e.g. --benchmark_perf_counters=CYCLES,CACHE-MISSES; BM_CopyScattered shows the misses in
+    // its time as well.
+
+    template<auto Make>
+    void BM_CreateDestroy(benchmark::State& state) {
+        for (auto _: state) {
+            auto oath = Make();
+            benchmark::DoNotOptimize(oath.get());
+        }
+    }
+
+    template<auto Make>
+    void BM_Copy(benchmark::State& state) {
+        const auto oath = Make();
+
+        for (auto _: state) {
+            auto copy = oath;
+            benchmark::DoNotOptimize(copy.get());
+        }
+    }
+
+    template<auto Make>
+    void BM_Move(benchmark::State& state) {
+        auto oath = Make();
+
+        for (auto _: state) {
+            auto moved = std::move(oath);
+            benchmark::DoNotOptimize(moved.get());
+            oath = std::move(moved);
+        }
+    }
+
+    // fills a vector with copies of a new object and releases them all; the last release destroys it
+    template<auto Make>
+    void BM_ReleaseCopies(benchmark::State& state) {
+        std::vector<decltype(Make())> copies(static_cast<size_t>(state.range(0)));
+
+        for (auto _: state) {
+            std::fill(copies.begin(), copies.end(), Make());
+            copies.clear();
+            copies.resize(static_cast<size_t>(state.range(0)));
+        }
+
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+
+    // Copies and reads through pointers to objects spread over the heap in random order, so that nearly every
+    // count update and every read is a cache miss; shared_ptr from new pays for two lines per object.
+    template<auto Make>
+    void BM_CopyScattered(benchmark::State& state) {
+        const auto count = static_cast<size_t>(state.range(0));
+        std::vector<decltype(Make())> oaths{};
+        std::vector<std::unique_ptr<char[]>> padding{};
+        for (size_t i{}; i < count; i++) {
+            oaths.push_back(Make());
+            oaths.back()->payload[0] = static_cast<long long>(i);
+            padding.push_back(std::make_unique<char[]>(256));
+        }
+        std::shuffle(oaths.begin(), oaths.end(), std::mt19937{42});
+
+        std::vector<decltype(Make())> copies{};
+        copies.reserve(count);
+
+        for (auto _: state) {
+            long long sum{};
+            for (const auto& oath: oaths) {
+                copies.push_back(oath);
+                sum += copies.back()->payload[0];
+            }
+            benchmark::DoNotOptimize(sum);
+            copies.clear();
+        }
+
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+}
+
+BENCHMARK(BM_NewDelete);
+BENCHMARK(BM_MakeUnique);
+BENCHMARK(BM_SharedPtrFromNew);
+BENCHMARK(BM_MakeShared);
+BENCHMARK(BM_SharedPtrCopy);
+BENCHMARK(BM_UniquePtrMove);
+BENCHMARK(BM_SumVectorOfUniquePtr)->Arg(1 << 10)->Arg(1 << 20);
+BENCHMARK(BM_SumVectorOfValues)->Arg(1 << 10)->Arg(1 << 20);
+BENCHMARK_TEMPLATE(BM_AllocateFree, make_unique_oath)->Arg(1)->Arg(64)->Arg(4096);
+BENCHMARK_TEMPLATE(BM_AllocateFree, make_pooled_oath)->Arg(1)->Arg(64)->Arg(4096);
+BENCHMARK_TEMPLATE(BM_AllocateCrossThreadFree, make_unique_oath)->Arg(4096)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_AllocateCrossThreadFree, make_pooled_oath)->Arg(4096)->UseRealTime();
+BENCHMARK(BM_RequestMakeUnique)->Arg(64)->Arg(4096);
+BENCHMARK(BM_RequestArena)->Arg(64)->Arg(4096);
+BENCHMARK_TEMPLATE(BM_CreateDestroy, shared_oath_from_new);
+BENCHMARK_TEMPLATE(BM_CreateDestroy, make_shared_oath);
+BENCHMARK_TEMPLATE(BM_CreateDestroy, make_local_shared_oath);
+BENCHMARK_TEMPLATE(BM_CreateDestroy, make_intrusive_oath);
+BENCHMARK_TEMPLATE(BM_Copy, make_shared_oath);
+BENCHMARK_TEMPLATE(BM_Copy, make_local_shared_oath);
+BENCHMARK_TEMPLATE(BM_Copy, make_intrusive_oath);
+BENCHMARK_TEMPLATE(BM_Move, make_shared_oath);
+BENCHMARK_TEMPLATE(BM_Move, make_local_shared_oath);
+BENCHMARK_TEMPLATE(BM_Move, make_intrusive_oath);
+BENCHMARK_TEMPLATE(BM_ReleaseCopies, make_shared_oath)->Arg(64);
+BENCHMARK_TEMPLATE(BM_ReleaseCopies, make_local_shared_oath)->Arg(64);
+BENCHMARK_TEMPLATE(BM_ReleaseCopies, make_intrusive_oath)->Arg(64);
+BENCHMARK_TEMPLATE(BM_CopyScattered, shared_oath_from_new)->Arg(1 << 10)->Arg(1 << 18);
+BENCHMARK_TEMPLATE(BM_CopyScattered, make_shared_oath)->Arg(1 << 10)->Arg(1 << 18);
+BENCHMARK_TEMPLATE(BM_CopyScattered, make_local_shared_oath)->Arg(1 << 10)->Arg(1 << 18);
+BENCHMARK_TEMPLATE(BM_CopyScattered, make_intrusive_oath)->Arg(1 << 10)->Arg(1 << 18);
@@ -0,0 +1,115 @@
+#include <string>
+
+#include "catch.hpp"
+#include "ch11-local-shared-ptr.h"
+
+struct DeadMenOfDunharrow {
+    DeadMenOfDunharrow(const char* m="")
+    : message{ m } {
+        oaths_to_fulfill++;
+    }
+
+    virtual ~DeadMenOfDunharrow() {
+        oaths_to_fulfill--;
+    }
+
+    const char* message;
+    static int oaths_to_fulfill;
+};
+
+int DeadMenOfDunharrow::oaths_to_fulfill{};
+
+struct KingOfTheDead : DeadMenOfDunharrow {
+    KingOfTheDead() : DeadMenOfDunharrow{ "king" } {}
+};
+
+struct CountedOathbreaker : ch11::RefCounted, DeadMenOfDunharrow {
+    using DeadMenOfDunharrow::DeadMenOfDunharrow;
+};
+
+using LocalSharedOathbreakers = ch11::LocalSharedPtr<DeadMenOfDunharrow>;
+using IntrusiveOathbreakers = ch11::IntrusivePtr<CountedOathbreaker>;
+
+TEST_CASE("LocalSharedPtr evaluates to") {
+    SECTION("true when full") {
+        auto aragorn = ch11::make_local_shared<DeadMenOfDunharrow>();
+        REQUIRE(aragorn);
+    }
+    SECTION("false when empty") {
+        LocalSharedOathbreakers aragorn;
+        REQUIRE_FALSE(aragorn);
+    }
+}
+
+TEST_CASE("LocalSharedPtr can be used in copy") {
+    auto aragorn = ch11::make_local_shared<DeadMenOfDunharrow>("Aragorn");
+
+    SECTION("construction") {
+        auto son_of_arathorn{ aragorn };
+        REQUIRE(aragorn.use_count() == 2);
+        REQUIRE(son_of_arathorn->message == std::string{ "Aragorn" });
+        REQUIRE(DeadMenOfDunharrow::oaths_to_fulfill == 1);
+    }
+
+    SECTION("assignment") {
+        auto son_of_arathorn = ch11::make_local_shared<DeadMenOfDunharrow>();
+        REQUIRE(DeadMenOfDunharrow::oaths_to_fulfill == 2);
+        son_of_arathorn = aragorn;
+        REQUIRE(DeadMenOfDunharrow::oaths_to_fulfill == 1);
+        REQUIRE(aragorn.use_count() == 2);
+    }
+
+    SECTION("the last owner destroys the object") {
+        {
+            auto son_of_arathorn{ aragorn };
+            aragorn.reset();
+            REQUIRE(DeadMenOfDunharrow::oaths_to_fulfill == 1);
+        }
+        REQUIRE(DeadMenOfDunharrow::oaths_to_fulfill == 0);
+    }
+}
+
+TEST_CASE("LocalSharedPtr can be used in move") {
+    auto aragorn = ch11::make_local_shared<DeadMenOfDunharrow>();
+
+    auto son_of_arathorn{ std::move(aragorn) };
+    REQUIRE_FALSE(aragorn);
+    REQUIRE(son_of_arathorn.use_count() == 1);
+    REQUIRE(DeadMenOfDunharrow::oaths_to_fulfill == 1);
+}
+
+TEST_CASE("LocalSharedPtr converts to a pointer to a base") {
+    auto king = ch11::make_local_shared<KingOfTheDead>();
+    LocalSharedOathbreakers oathbreaker{ king };
+    REQUIRE(oathbreaker->message == std::string{ "king" });
+    REQUIRE(king.use_count() == 2);
+
+    king.reset();
+    REQUIRE(DeadMenOfDunharrow::oaths_to_fulfill == 1);
+    oathbreaker.reset();
+    REQUIRE(DeadMenOfDunharrow::oaths_to_fulfill == 0);
+}
+
+TEST_CASE("IntrusivePtr keeps the count in the object") {
+    auto aragorn = ch11::make_intrusive<CountedOathbreaker>("Aragorn");
+    REQUIRE(sizeof(aragorn) == sizeof(CountedOathbreaker*));
+    REQUIRE(aragorn->get_references() == 1);
+
+    SECTION("copies share the count") {
+        auto son_of_arathorn{ aragorn };
+        REQUIRE(aragorn->get_references() == 2);
+    }
+
+    SECTION("a raw pointer can be adopted again") {
+        IntrusiveOathbreakers son_of_arathorn{ aragorn.get() };
+        aragorn.reset();
+        REQUIRE(son_of_arathorn->get_references() == 1);
+        REQUIRE(DeadMenOfDunharrow::oaths_to_fulfill == 1);
+    }
+
+    SECTION("the last owner destroys the object") {
+        auto son_of_arathorn{ std::move(aragorn) };
+        son_of_arathorn = IntrusiveOathbreakers{};
+        REQUIRE(DeadMenOfDunharrow::oaths_to_fulfill == 0);
+    }
+}
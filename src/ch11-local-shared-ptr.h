@@ -0,0 +1,208 @@
+#ifndef CPPCRASHCOURSE_CH11_LOCAL_SHARED_PTR_H
+#define CPPCRASHCOURSE_CH11_LOCAL_SHARED_PTR_H
+
+#include <type_traits>
+#include <utility>
+
+// Shared ownership for objects that never leave one thread: the reference counts are plain integers, so
+// copying and destroying a pointer is an increment or decrement instead of an atomic read-modify-write.
+// Neither pointer may be copied or destroyed concurrently from two threads.
+
+namespace ch11 {
+    // Base for objects that carry their own reference count, for use with IntrusivePtr. The object and its
+    // count are one allocation, and any raw pointer to it can be turned back into an owning one.
+    class RefCounted {
+    public:
+        void add_ref() const noexcept {
+            m_references++;
+        }
+
+        // true when the last reference is gone
+        [[nodiscard]] bool release() const noexcept {
+            return --m_references == 0;
+        }
+
+        [[nodiscard]] long get_references() const noexcept {
+            return m_references;
+        }
+
+    protected:
+        RefCounted() = default;
+
+        // copies start with their own count
+        RefCounted(const RefCounted&) noexcept {}
+
+        RefCounted& operator=(const RefCounted&) noexcept {
+            return *this;
+        }
+
+        ~RefCounted() = default;
+
+    private:
+        mutable long m_references{};
+    };
+
+    template<typename T>
+    class IntrusivePtr {
+    public:
+        IntrusivePtr() noexcept = default;
+
+        explicit IntrusivePtr(T* object) noexcept : m_object{object} {
+            if (m_object != nullptr) {
+                m_object->add_ref();
+            }
+        }
+
+        ~IntrusivePtr() {
+            if (m_object != nullptr && m_object->release()) {
+                delete m_object;
+            }
+        }
+
+        IntrusivePtr(const IntrusivePtr& other) noexcept : IntrusivePtr{other.m_object} {}
+
+        IntrusivePtr(IntrusivePtr&& other) noexcept : m_object{std::exchange(other.m_object, nullptr)} {}
+
+        IntrusivePtr& operator=(IntrusivePtr other) noexcept {
+            std::swap(m_object, other.m_object);
+            return *this;
+        }
+
+        void reset() noexcept {
+            IntrusivePtr{}.swap(*this);
+        }
+
+        void swap(IntrusivePtr& other) noexcept {
+            std::swap(m_object, other.m_object);
+        }
+
+        [[nodiscard]] T* get() const noexcept {
+            return m_object;
+        }
+
+        T& operator*() const noexcept {
+            return *m_object;
+        }
+
+        T* operator->() const noexcept {
+            return m_object;
+        }
+
+        explicit operator bool() const noexcept {
+            return m_object != nullptr;
+        }
+
+    private:
+        T* m_object{};
+    };
+
+    template<typename T, typename... Args>
+    IntrusivePtr<T> make_intrusive(Args&& ... args) {
+        static_assert(std::is_base_of_v<RefCounted, T>, "T must derive from ch11::RefCounted");
+        return IntrusivePtr<T>{new T(std::forward<Args>(args)...)};
+    }
+
+    struct LocalControlBlock {
+        long references;
+
+        void (* destroy)(LocalControlBlock*);
+    };
+
+    template<typename T>
+    struct LocalBlock : LocalControlBlock {
+        T value;
+
+        template<typename... Args>
+        explicit LocalBlock(Args&& ... args) : LocalControlBlock{1, &LocalBlock::destroy_block},
+                                               value(std::forward<Args>(args)...) {}
+
+        static void destroy_block(LocalControlBlock* block) {
+            delete static_cast<LocalBlock*>(block);
+        }
+    };
+
+    // A shared_ptr with a non-atomic count whose control block and object share one allocation; there is no
+    // weak count, so the memory goes away together with the object.
+    template<typename T>
+    class LocalSharedPtr {
+    public:
+        LocalSharedPtr() noexcept = default;
+
+        ~LocalSharedPtr() {
+            if (m_block != nullptr && --m_block->references == 0) {
+                m_block->destroy(m_block);
+            }
+        }
+
+        LocalSharedPtr(const LocalSharedPtr& other) noexcept : m_object{other.m_object}, m_block{other.m_block} {
+            if (m_block != nullptr) {
+                m_block->references++;
+            }
+        }
+
+        LocalSharedPtr(LocalSharedPtr&& other) noexcept
+                : m_object{std::exchange(other.m_object, nullptr)}, m_block{std::exchange(other.m_block, nullptr)} {}
+
+        // from a pointer to a derived type
+        template<typename U> requires std::is_convertible_v<U*, T*>
+        LocalSharedPtr(const LocalSharedPtr<U>& other) noexcept : m_object{other.m_object}, m_block{other.m_block} {
+            if (m_block != nullptr) {
+                m_block->references++;
+            }
+        }
+
+        LocalSharedPtr& operator=(LocalSharedPtr other) noexcept {
+            swap(other);
+            return *this;
+        }
+
+        void reset() noexcept {
+            LocalSharedPtr{}.swap(*this);
+        }
+
+        void swap(LocalSharedPtr& other) noexcept {
+            std::swap(m_object, other.m_object);
+            std::swap(m_block, other.m_block);
+        }
+
+        [[nodiscard]] T* get() const noexcept {
+            return m_object;
+        }
+
+        T& operator*() const noexcept {
+            return *m_object;
+        }
+
+        T* operator->() const noexcept {
+            return m_object;
+        }
+
+        explicit operator bool() const noexcept {
+            return m_object != nullptr;
+        }
+
+        [[nodiscard]] long use_count() const noexcept {
+            return m_block == nullptr ? 0 : m_block->references;
+        }
+
+    private:
+        T* m_object{};
+        LocalControlBlock* m_block{};
+
+        LocalSharedPtr(T* object, LocalControlBlock* block) noexcept : m_object{object}, m_block{block} {}
+
+        template<typename U>
+        friend class LocalSharedPtr;
+
+        template<typename U, typename... Args>
+        friend LocalSharedPtr<U> make_local_shared(Args&& ... args);
+    };
+
+    template<typename T, typename... Args>
+    LocalSharedPtr<T> make_local_shared(Args&& ... args) {
+        auto* block = new LocalBlock<T>(std::forward<Args>(args)...);
+        return LocalSharedPtr<T>{&block->value, block};
+    }
+}
+
+#endif //CPPCRASHCOURSE_CH11_LOCAL_SHARED_PTR_H
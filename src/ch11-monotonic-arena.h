@@ -0,0 +1,158 @@
+#ifndef CPPCRASHCOURSE_CH11_MONOTONIC_ARENA_H
+#define CPPCRASHCOURSE_CH11_MONOTONIC_ARENA_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+namespace ch11 {
+    // Bump allocator for objects that all die together, e.g. everything created while handling one request.
+    // Allocation is a pointer increment; nothing is freed individually. reset() runs the destructors of the
+    // non-trivially destructible objects in reverse order and keeps the largest block for the next round.
+    class MonotonicArena {
+    public:
+        explicit MonotonicArena(const size_t block_size = 64 * 1024) : m_block_size{block_size} {}
+
+        ~MonotonicArena() {
+            release();
+        }
+
+        MonotonicArena(const MonotonicArena&) = delete;
+
+        MonotonicArena& operator=(const MonotonicArena&) = delete;
+
+        void* allocate(const size_t size, const size_t alignment = alignof(std::max_align_t)) {
+            auto* aligned = align_up(m_current, alignment);
+            if (m_block == nullptr || aligned + size > m_end) {
+                add_block(size + alignment);
+                aligned = align_up(m_current, alignment);
+            }
+
+            m_current = aligned + size;
+            return aligned;
+        }
+
+        template<typename T, typename... Args>
+        T* make(Args&& ... args) {
+            if constexpr (std::is_trivially_destructible_v<T>) {
+                return ::new(allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+            } else {
+                auto* cleanup = allocate(sizeof(Cleanup), alignof(Cleanup));
+                auto* object = ::new(allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+
+                m_cleanups = ::new(cleanup) Cleanup{[](void* p) { static_cast<T*>(p)->~T(); }, object, m_cleanups};
+                return object;
+            }
+        }
+
+        // value-initialized elements
+        template<typename T>
+        std::span<T> make_array(const size_t count) {
+            static_assert(std::is_trivially_destructible_v<T>, "arena arrays are never destroyed");
+
+            auto* elements = static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+            std::uninitialized_value_construct_n(elements, count);
+            return {elements, count};
+        }
+
+        void reset() {
+            run_cleanups();
+
+            // keeps the largest block, which is not always the newest: an oversized allocation gets a block of its
+            // own, and the blocks after it go back to the doubling size
+            if (m_block != nullptr) {
+                auto* largest = m_block;
+                for (auto* block = m_block->previous; block != nullptr; block = block->previous) {
+                    if (block->size > largest->size) {
+                        largest = block;
+                    }
+                }
+
+                for (auto* block = m_block; block != nullptr;) {
+                    auto* previous = block->previous;
+                    if (block != largest) {
+                        ::operator delete(block);
+                    }
+                    block = previous;
+                }
+
+                m_block = largest;
+                m_block->previous = nullptr;
+                m_current = m_block->data();
+                m_end = m_current + m_block->size;
+            }
+            m_used = 0;
+        }
+
+        // bytes handed out since construction or the last reset, including alignment padding
+        [[nodiscard]] size_t get_used() const {
+            return m_used + (m_block == nullptr ? 0 : static_cast<size_t>(m_current - m_block->data()));
+        }
+
+    private:
+        struct Cleanup {
+            void (* destroy)(void*);
+
+            void* object;
+            Cleanup* previous;
+        };
+
+        struct Block {
+            Block* previous;
+            size_t size;
+
+            std::byte* data() {
+                return reinterpret_cast<std::byte*>(this + 1);
+            }
+        };
+
+        size_t m_block_size;
+        Block* m_block{};
+        std::byte* m_current{};
+        std::byte* m_end{};
+        size_t m_used{};
+        Cleanup* m_cleanups{};
+
+        static std::byte* align_up(std::byte* pointer, const size_t alignment) {
+            const auto address = reinterpret_cast<std::uintptr_t>(pointer);
+            return pointer + ((alignment - address % alignment) % alignment);
+        }
+
+        void add_block(const size_t minimum) {
+            if (m_block != nullptr) {
+                m_used += static_cast<size_t>(m_current - m_block->data());
+                m_block_size *= 2;
+            }
+
+            const auto size = std::max(m_block_size, minimum);
+            auto* block = ::new(::operator new(sizeof(Block) + size)) Block{m_block, size};
+
+            m_block = block;
+            m_current = block->data();
+            m_end = m_current + size;
+        }
+
+        void run_cleanups() {
+            for (; m_cleanups != nullptr; m_cleanups = m_cleanups->previous) {
+                m_cleanups->destroy(m_cleanups->object);
+            }
+        }
+
+        void release() {
+            run_cleanups();
+
+            while (m_block != nullptr) {
+                auto* previous = m_block->previous;
+                ::operator delete(m_block);
+                m_block = previous;
+            }
+        }
+    };
+}
+
+#endif //CPPCRASHCOURSE_CH11_MONOTONIC_ARENA_H
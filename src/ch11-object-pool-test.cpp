@@ -0,0 +1,251 @@
+#include <atomic>
+#include <deque>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "catch.hpp"
+#include "ch11-monotonic-arena.h"
+#include "ch11-object-pool.h"
+
+struct DeadMenOfDunharrow {
+    DeadMenOfDunharrow(const char* m="")
+    : message{ m } {
+        oaths_to_fulfill++;
+    }
+
+    ~DeadMenOfDunharrow() {
+        oaths_to_fulfill--;
+    }
+
+    const char* message;
+    static int oaths_to_fulfill;
+};
+
+int DeadMenOfDunharrow::oaths_to_fulfill{};
+
+struct Oathbreaker {
+    Oathbreaker() {
+        throw std::runtime_error{ "oath broken" };
+    }
+};
+
+using PooledOathbreakers = ch11::PooledPtr<DeadMenOfDunharrow>;
+
+TEST_CASE("PooledPtr is as small as a raw pointer") {
+    REQUIRE(sizeof(PooledOathbreakers) == sizeof(DeadMenOfDunharrow*));
+}
+
+TEST_CASE("PooledPtr calls the destructor and returns the slot to the pool") {
+    auto aragorn = ch11::make_pooled<DeadMenOfDunharrow>("Aragorn");
+    REQUIRE(aragorn->message == std::string{ "Aragorn" });
+    REQUIRE(DeadMenOfDunharrow::oaths_to_fulfill == 1);
+
+    auto* slot = aragorn.get();
+    aragorn.reset();
+    REQUIRE(DeadMenOfDunharrow::oaths_to_fulfill == 0);
+
+    auto legolas = ch11::make_pooled<DeadMenOfDunharrow>();
+    REQUIRE(legolas.get() == slot);
+}
+
+TEST_CASE("PooledPtr can be used in move") {
+    auto aragorn = ch11::make_pooled<DeadMenOfDunharrow>();
+
+    SECTION("construction") {
+        auto son_of_arathorn = std::move(aragorn);
+        REQUIRE(DeadMenOfDunharrow::oaths_to_fulfill == 1);
+    }
+
+    SECTION("assignment") {
+        auto son_of_arathorn = ch11::make_pooled<DeadMenOfDunharrow>();
+        REQUIRE(DeadMenOfDunharrow::oaths_to_fulfill == 2);
+        son_of_arathorn = std::move(aragorn);
+        REQUIRE(DeadMenOfDunharrow::oaths_to_fulfill == 1);
+    }
+}
+
+TEST_CASE("ObjectPool grows by whole blocks and reuses freed slots") {
+    std::vector<ch11::PooledPtr<long long>> numbers{};
+    for (int i{}; i < 1000; i++) {
+        numbers.push_back(ch11::make_pooled<long long>(i));
+    }
+    const auto capacity = ch11::ObjectPool<long long>::capacity();
+    REQUIRE(capacity >= 1000);
+    REQUIRE(capacity % 256 == 0);
+
+    numbers.clear();
+    for (int i{}; i < 1000; i++) {
+        numbers.push_back(ch11::make_pooled<long long>(i));
+    }
+    REQUIRE(ch11::ObjectPool<long long>::capacity() == capacity);
+}
+
+TEST_CASE("make_pooled returns the slot when the constructor throws") {
+    REQUIRE_THROWS_AS(ch11::make_pooled<Oathbreaker>(), std::runtime_error);
+    const auto capacity = ch11::ObjectPool<Oathbreaker>::capacity();
+
+    for (int i{}; i < 1000; i++) {
+        REQUIRE_THROWS_AS(ch11::make_pooled<Oathbreaker>(), std::runtime_error);
+    }
+    REQUIRE(ch11::ObjectPool<Oathbreaker>::capacity() == capacity);
+}
+
+TEST_CASE("Objects freed on another thread go back to the allocating thread's pool") {
+    std::vector<PooledOathbreakers> army{};
+    for (int i{}; i < 1000; i++) {
+        army.push_back(ch11::make_pooled<DeadMenOfDunharrow>());
+    }
+    const auto capacity = ch11::ObjectPool<DeadMenOfDunharrow>::capacity();
+
+    std::thread{ [&army] { army.clear(); } }.join();
+    REQUIRE(DeadMenOfDunharrow::oaths_to_fulfill == 0);
+
+    for (int i{}; i < 1000; i++) {
+        army.push_back(ch11::make_pooled<DeadMenOfDunharrow>());
+    }
+    REQUIRE(ch11::ObjectPool<DeadMenOfDunharrow>::capacity() == capacity);
+    army.clear();
+}
+
+TEST_CASE("Objects outlive the thread that allocated them") {
+    std::vector<PooledOathbreakers> army{};
+    std::thread{ [&army] {
+        for (int i{}; i < 1000; i++) {
+            army.push_back(ch11::make_pooled<DeadMenOfDunharrow>("summoned"));
+        }
+    } }.join();
+
+    REQUIRE(DeadMenOfDunharrow::oaths_to_fulfill == 1000);
+    REQUIRE(army.back()->message == std::string{ "summoned" });
+    army.clear();
+    REQUIRE(DeadMenOfDunharrow::oaths_to_fulfill == 0);
+}
+
+// counted atomically, since it is created and destroyed on different threads at once
+struct SwornOath {
+    SwornOath() {
+        sworn++;
+    }
+
+    ~SwornOath() {
+        sworn--;
+    }
+
+    static std::atomic<int> sworn;
+};
+
+std::atomic<int> SwornOath::sworn{};
+
+TEST_CASE("Objects allocated on one thread are freed on another while both keep going") {
+    for (int round{}; round < 20; round++) {
+        std::mutex mutex{};
+        std::deque<ch11::PooledPtr<SwornOath>> handed_over{};
+        bool done{};
+
+        // The allocating thread keeps a whole block and hands over one object at a time, so every allocation
+        // finds its own free list empty and takes back the object freed last, possibly while that free is still
+        // under way. It exits while the freeing thread still holds some of its objects.
+        std::thread allocating{ [&] {
+            std::vector<ch11::PooledPtr<SwornOath>> kept{};
+            for (int i{}; i < 256; i++) {
+                kept.push_back(ch11::make_pooled<SwornOath>());
+            }
+
+            for (int i{}; i < 2000;) {
+                std::unique_lock lock{ mutex };
+                if (!handed_over.empty()) {
+                    lock.unlock();
+                    std::this_thread::yield();
+                    continue;
+                }
+                handed_over.push_back(ch11::make_pooled<SwornOath>());
+                i++;
+            }
+
+            std::lock_guard lock{ mutex };
+            std::move(kept.begin(), kept.end(), std::back_inserter(handed_over));
+            done = true;
+        } };
+
+        // frees outside the lock, so the allocating thread can reclaim while a free is under way
+        std::thread freeing{ [&] {
+            while (true) {
+                ch11::PooledPtr<SwornOath> oath{};
+                {
+                    std::lock_guard lock{ mutex };
+                    if (handed_over.empty()) {
+                        if (done) {
+                            return;
+                        }
+                        continue;
+                    }
+                    oath = std::move(handed_over.front());
+                    handed_over.pop_front();
+                }
+            }
+        } };
+
+        allocating.join();
+        freeing.join();
+        REQUIRE(SwornOath::sworn == 0);
+    }
+}
+
+TEST_CASE("MonotonicArena destroys its objects on reset") {
+    ch11::MonotonicArena arena{ 1024 };
+
+    auto* aragorn = arena.make<DeadMenOfDunharrow>("Aragorn");
+    auto* squares = arena.make<int>(25);
+    REQUIRE(aragorn->message == std::string{ "Aragorn" });
+    REQUIRE(*squares == 25);
+    REQUIRE(DeadMenOfDunharrow::oaths_to_fulfill == 1);
+
+    arena.reset();
+    REQUIRE(DeadMenOfDunharrow::oaths_to_fulfill == 0);
+    REQUIRE(arena.get_used() == 0);
+}
+
+TEST_CASE("MonotonicArena destroys its objects when it goes out of scope") {
+    {
+        ch11::MonotonicArena arena{ 64 };
+        for (int i{}; i < 1000; i++) {
+            arena.make<DeadMenOfDunharrow>();
+        }
+        REQUIRE(DeadMenOfDunharrow::oaths_to_fulfill == 1000);
+    }
+    REQUIRE(DeadMenOfDunharrow::oaths_to_fulfill == 0);
+}
+
+TEST_CASE("MonotonicArena aligns and reuses its memory") {
+    ch11::MonotonicArena arena{ 128 };
+
+    auto squares = arena.make_array<int>(5);
+    REQUIRE(squares.size() == 5);
+    REQUIRE(squares[4] == 0);
+
+    auto* aligned = arena.allocate(1, 64);
+    REQUIRE(reinterpret_cast<std::uintptr_t>(aligned) % 64 == 0);
+
+    auto* large = arena.make_array<char>(4096).data();
+    REQUIRE(arena.get_used() >= 4096 + 5 * sizeof(int));
+
+    arena.reset();
+    REQUIRE(arena.make_array<char>(4096).data() == large);
+}
+
+TEST_CASE("MonotonicArena keeps its largest block on reset") {
+    ch11::MonotonicArena arena{ 128 };
+
+    // an oversized block of its own, followed by a smaller one
+    void* large = arena.make_array<char>(100000).data();
+    arena.make_array<char>(200);
+    REQUIRE(arena.get_used() >= 100200);
+
+    arena.reset();
+    REQUIRE(static_cast<void*>(arena.make_array<char>(100000).data()) == large);
+}
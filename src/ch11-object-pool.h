@@ -0,0 +1,171 @@
+#ifndef CPPCRASHCOURSE_CH11_OBJECT_POOL_H
+#define CPPCRASHCOURSE_CH11_OBJECT_POOL_H
+
+#include <atomic>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace ch11 {
+    // Fixed-size slots for objects of type T, one pool per thread. Allocating and freeing on the owning thread is
+    // a push or pop on a plain free list; a slot freed by another thread goes onto the owner's lock-free remote
+    // list, which the owner takes over in one exchange once its own list runs dry. A pool whose thread exits
+    // while some of its objects are still alive is freed by whichever thread returns the last of them.
+    template<typename T, size_t BlockSize = 256>
+    class ObjectPool {
+    public:
+        static T* allocate() {
+            auto& pool = local();
+
+            if (pool.m_free == nullptr) {
+                pool.reclaim();
+            }
+            if (pool.m_free == nullptr) {
+                pool.grow();
+            }
+
+            auto* slot = pool.m_free;
+            pool.m_free = slot->next;
+            pool.m_available--;
+
+            return reinterpret_cast<T*>(slot->storage);
+        }
+
+        // The object must already be destroyed.
+        static void deallocate(T* object) {
+            auto* slot = reinterpret_cast<Slot*>(object);
+
+            if (auto* pool = owned(); slot->owner == pool) {
+                slot->next = pool->m_free;
+                pool->m_free = slot;
+                pool->m_available++;
+                return;
+            }
+
+            auto& remote_free = slot->owner->m_remote_free;
+            slot->next = remote_free.load(std::memory_order_relaxed);
+            while (!remote_free.compare_exchange_weak(slot->next, slot, std::memory_order_release,
+                                                      std::memory_order_relaxed)) {
+            }
+
+            if (slot->owner->m_remote_balance.fetch_sub(1, std::memory_order_acq_rel) == ABANDONED + 1) {
+                delete slot->owner;
+            }
+        }
+
+        // slots of the calling thread's pool, free or not
+        [[nodiscard]] static size_t capacity() {
+            return local().m_blocks.size() * BlockSize;
+        }
+
+    private:
+        struct Slot {
+            union {
+                Slot* next;
+                alignas(T) unsigned char storage[sizeof(T)];
+            };
+            ObjectPool* owner;
+        };
+
+        struct Handle {
+            ObjectPool* pool{new ObjectPool{}};
+
+            Handle() {
+                owned() = pool;
+            }
+
+            ~Handle() {
+                owned() = nullptr;
+                pool->abandon();
+            }
+        };
+
+        Slot* m_free{};
+        size_t m_available{};
+        std::vector<std::unique_ptr<Slot[]>> m_blocks{};
+        alignas(64) std::atomic<Slot*> m_remote_free{};
+        // The slots reclaimed minus the remote frees counted so far. A free is counted after its slot is pushed,
+        // so the owner can reclaim a slot before its free is counted and the balance may briefly be positive.
+        // abandon() adds ABANDONED plus the slots still out, so the balance only comes down to ABANDONED once
+        // the last free is counted; before that flag no value a free can leave behind means the pool is done.
+        std::atomic<long> m_remote_balance{};
+
+        static constexpr long ABANDONED = 1L << 62;
+
+        static ObjectPool& local() {
+            thread_local Handle handle{};
+            return *handle.pool;
+        }
+
+        // The calling thread's pool, or null if it has never allocated or its pool was abandoned at exit. Unlike
+        // local() it never creates a pool, so threads that only free objects do not get one, and frees made
+        // after the thread's pool was abandoned take the remote path its accounting expects.
+        static ObjectPool*& owned() {
+            thread_local ObjectPool* pool{};
+            return pool;
+        }
+
+        void grow() {
+            auto& block = m_blocks.emplace_back(std::make_unique<Slot[]>(BlockSize));
+            for (size_t i{}; i < BlockSize; i++) {
+                block[i].owner = this;
+                block[i].next = i + 1 < BlockSize ? &block[i + 1] : nullptr;
+            }
+
+            m_free = &block[0];
+            m_available += BlockSize;
+        }
+
+        // moves the slots other threads have freed onto the local free list
+        void reclaim() {
+            long count{};
+            for (auto* slot = m_remote_free.exchange(nullptr, std::memory_order_acquire); slot != nullptr;) {
+                auto* next = slot->next;
+                slot->next = m_free;
+                m_free = slot;
+                slot = next;
+                count++;
+            }
+
+            m_available += static_cast<size_t>(count);
+            m_remote_balance.fetch_add(count, std::memory_order_relaxed);
+        }
+
+        // Called at thread exit: frees the pool now if every slot has come back, otherwise leaves that to the
+        // thread returning the last object.
+        void abandon() {
+            reclaim();
+
+            const auto outstanding = static_cast<long>(m_blocks.size() * BlockSize - m_available);
+            if (m_remote_balance.fetch_add(ABANDONED + outstanding, std::memory_order_acq_rel) + outstanding == 0) {
+                delete this;
+            }
+        }
+    };
+
+    template<typename T>
+    struct PoolDeleter {
+        void operator()(T* object) const {
+            object->~T();
+            ObjectPool<T>::deallocate(object);
+        }
+    };
+
+    template<typename T>
+    using PooledPtr = std::unique_ptr<T, PoolDeleter<T>>;
+
+    template<typename T, typename... Args>
+    PooledPtr<T> make_pooled(Args&& ... args) {
+        auto* memory = ObjectPool<T>::allocate();
+
+        try {
+            return PooledPtr<T>{::new(static_cast<void*>(memory)) T(std::forward<Args>(args)...)};
+        } catch (...) {
+            ObjectPool<T>::deallocate(memory);
+            throw;
+        }
+    }
+}
+
+#endif //CPPCRASHCOURSE_CH11_OBJECT_POOL_H